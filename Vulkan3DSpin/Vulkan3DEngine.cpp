@@ -3,11 +3,36 @@
 
 #include "Vulkan3DEngine.h"
 #include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Bench/Bench.h"
+#include "VulkanMain/Bench/Micro.h"
+#include "VulkanMain/Benchmark/Benchmark.h"
+#include "VulkanMain/Benchmark/Regression.h"
+#include "VulkanMain/Mesh/MeshFile.h"
 
 using namespace std;
 
-int main()
+int main(int argc, char** argv)
 {
+	if (argc > 1 && string(argv[1]) == "--bench") {
+		return VkBench::Run(vector<string>(argv + 2, argv + argc));
+	}
+
+	if (argc > 1 && string(argv[1]) == "--microbench") {
+		return VkMicro::Run(vector<string>(argv + 2, argv + argc));
+	}
+
+	if (argc > 1 && string(argv[1]) == "--benchmark") {
+		return VkBenchmark::Run(vector<string>(argv + 2, argv + argc));
+	}
+
+	if (argc > 1 && string(argv[1]) == "--regress") {
+		return VkRegression::Run(vector<string>(argv + 2, argv + argc));
+	}
+
+	if (argc > 3 && string(argv[1]) == "--import-mesh") {
+		return VkMesh::ImportObj(argv[2], argv[3]);
+	}
+
 	VkMain vkm;
 	vkm.run();
 	return 0;
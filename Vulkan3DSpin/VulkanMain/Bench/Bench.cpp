@@ -0,0 +1,630 @@
+#include "VulkanMain/Bench/Bench.h"
+#include "VulkanMain/Dispatch/Dispatch.h"
+#include "VulkanMain/Transform/Transform.h"
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/GpuCulling/GpuCulling.h"
+#include "VulkanMain/Jobs/Jobs.h"
+#include "VulkanMain/Scene/Scene.h"
+#include "VulkanMain/Descriptors/Descriptors.h"
+#include "VulkanMain/DrawList/DrawList.h"
+#include "VulkanMain/RenderGraph/RenderGraph.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Median wall time of one call to func, in milliseconds.
+    double MeasureMs(int iterations, const std::function<void()>& func) {
+        func();
+
+        std::vector<double> samples;
+        samples.reserve(iterations);
+        for (int i = 0; i < iterations; i++) {
+            auto start = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    void FillRandomTransforms(TransformSystem& transforms, size_t count) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+        transforms.Clear();
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 axis = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) + glm::vec3(0.0f, 0.0f, 0.001f));
+            transforms.Add(
+                glm::vec3(position(rng), position(rng), position(rng)),
+                glm::angleAxis(angle(rng), axis),
+                glm::vec3(scale(rng), scale(rng), scale(rng))
+            );
+        }
+    }
+
+    float MaxDifference(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+        float diff = 0.0f;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    diff = std::max(diff, std::fabs(a[i][c][r] - b[i][c][r]));
+                }
+            }
+        }
+        return diff;
+    }
+}
+
+void VkBench::TransformBenchmark() {
+    glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 10.0f);
+    proj[1][1] *= -1;
+    glm::mat4 viewProj = proj * view;
+
+    std::cout << "transform: world + MVP per object, median of runs, "
+              << VkJobs::ThreadCount() << " threads\n";
+    std::cout << std::setw(10) << "objects"
+              << std::setw(14) << "glm (ms)"
+              << std::setw(14) << "simd (ms)"
+              << std::setw(14) << "simd-mt (ms)"
+              << std::setw(10) << "x1"
+              << std::setw(10) << "xN"
+              << std::setw(12) << "max err" << "\n";
+
+    for (size_t count : { 1000u, 10000u, 100000u, 1000000u }) {
+        TransformSystem transforms;
+        FillRandomTransforms(transforms, count);
+        int iterations = count >= 1000000 ? 10 : 50;
+
+        double scalarMs = MeasureMs(iterations, [&]() { transforms.ComputeMatricesScalar(viewProj); });
+        std::vector<glm::mat4> reference = transforms.MVP();
+
+        double simdMs = MeasureMs(iterations, [&]() { transforms.ComputeMatricesRange(viewProj, 0, transforms.Size()); });
+        double parallelMs = MeasureMs(iterations, [&]() { transforms.ComputeMatrices(viewProj); });
+        float error = MaxDifference(reference, transforms.MVP());
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << scalarMs
+                  << std::setw(14) << simdMs
+                  << std::setw(14) << parallelMs
+                  << std::setprecision(2)
+                  << std::setw(10) << scalarMs / simdMs
+                  << std::setw(10) << scalarMs / parallelMs
+                  << std::scientific << std::setprecision(1)
+                  << std::setw(12) << error
+                  << std::defaultfloat << "\n";
+    }
+}
+
+void VkBench::CullingBenchmark() {
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, -60.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 200.0f);
+    proj[1][1] *= -1;
+    glm::mat4 viewProj = proj * view;
+    Frustum frustum = VkCulling::ExtractFrustum(viewProj);
+
+    MeshBounds bounds{};
+    bounds.box.min = glm::vec3(-0.5f);
+    bounds.box.max = glm::vec3(0.5f);
+    bounds.sphere.center = glm::vec3(0.0f);
+    bounds.sphere.radius = glm::length(glm::vec3(0.5f));
+
+    // CPU time spent per frame before submit. "cpu-driven" transforms, culls
+    // and writes one push constant + draw per visible object. The GPU paths
+    // do what UploadObjectChanges and RecordGpuCulling do and leave culling
+    // to cull.comp: "gpu-static" re-uploads the one moving object,
+    // "gpu-dynamic" every object; both build the frustum push constants.
+    std::cout << "culling: per-frame CPU cost, median of runs, "
+              << VkJobs::ThreadCount() << " threads\n";
+    std::cout << std::setw(10) << "objects"
+              << std::setw(10) << "visible"
+              << std::setw(16) << "cpu-driven (ms)"
+              << std::setw(16) << "gpu-static (ms)"
+              << std::setw(17) << "gpu-dynamic (ms)" << "\n";
+
+    for (size_t count : { 1000u, 10000u, 100000u, 1000000u }) {
+        TransformSystem transforms;
+        FillRandomTransforms(transforms, count);
+        int iterations = count >= 1000000 ? 10 : 50;
+
+        CullingSystem culling;
+        culling.Resize(count);
+        for (size_t i = 0; i < count; i++) {
+            culling.SetLocalBounds(static_cast<uint32_t>(i), bounds);
+        }
+
+        std::vector<uint32_t> visible;
+        std::vector<glm::mat4> pushConstants;
+        pushConstants.reserve(count);
+        std::vector<GpuObjectData> objects(count);
+        GpuCullConstants constants{};
+        ChangeList uploads;
+        uploads.Resize(count);
+        std::vector<uint32_t> moving = { 0 };
+
+        double cpuMs = MeasureMs(iterations, [&]() {
+            transforms.ComputeMatrices(viewProj);
+            culling.UpdateWorldBounds(transforms.World());
+            culling.Cull(frustum, visible);
+
+            pushConstants.clear();
+            for (uint32_t i : visible) {
+                pushConstants.push_back(transforms.MVP()[i]);
+            }
+        });
+
+        double gpuStaticMs = MeasureMs(iterations, [&]() {
+            transforms.ComputeMatricesRange(viewProj, 0, 1);
+            uploads.Add(moving);
+            for (uint32_t i : uploads.Indices()) {
+                objects[i] = VkGpuCulling::PackObject(transforms.World()[i], bounds);
+            }
+            uploads.Clear();
+            constants = VkGpuCulling::MakeConstants(VkCulling::ExtractFrustum(viewProj), static_cast<uint32_t>(count), 12);
+        });
+
+        double gpuDynamicMs = MeasureMs(iterations, [&]() {
+            transforms.ComputeMatrices(viewProj);
+            VkJobs::ParallelFor(count, TransformSystem::BATCH_SIZE, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) {
+                    objects[i] = VkGpuCulling::PackObject(transforms.World()[i], bounds);
+                }
+            });
+            constants = VkGpuCulling::MakeConstants(VkCulling::ExtractFrustum(viewProj), static_cast<uint32_t>(count), 12);
+        });
+
+        std::cout << std::setw(10) << count
+                  << std::setw(10) << visible.size()
+                  << std::fixed << std::setprecision(4)
+                  << std::setw(16) << cpuMs
+                  << std::setw(16) << gpuStaticMs
+                  << std::setw(17) << gpuDynamicMs
+                  << std::defaultfloat << "\n";
+    }
+}
+
+void VkBench::SceneBenchmark() {
+    // Each root carries a small hierarchy (root -> 3 children -> 3 grandchildren
+    // each), like a vehicle or a character rig. "static" touches nothing,
+    // "1% moving" moves 1% of the roots, "all moving" every root.
+    const uint32_t nodesPerRoot = 1 + 3 + 9;
+
+    std::cout << "scene: SceneGraph::Update() per frame, median of runs\n";
+    std::cout << std::setw(10) << "nodes"
+              << std::setw(14) << "static (ms)"
+              << std::setw(16) << "1% moving (ms)"
+              << std::setw(17) << "all moving (ms)"
+              << std::setw(12) << "max error" << "\n";
+
+    for (uint32_t roots : { 1000u, 10000u, 100000u }) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+
+        SceneGraph scene;
+        std::vector<uint32_t> rootNodes;
+        for (uint32_t r = 0; r < roots; r++) {
+            uint32_t root = scene.AddNode(SceneGraph::NO_PARENT, glm::vec3(position(rng), position(rng), position(rng)), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+            rootNodes.push_back(root);
+            for (int c = 0; c < 3; c++) {
+                uint32_t child = scene.AddNode(root, glm::vec3(offset(rng), offset(rng), offset(rng)), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.5f));
+                for (int g = 0; g < 3; g++) {
+                    scene.AddNode(child, glm::vec3(offset(rng), offset(rng), offset(rng)), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(0.5f));
+                }
+            }
+        }
+        scene.Update();
+
+        int iterations = roots >= 100000 ? 20 : 100;
+        float angle = 0.0f;
+        auto moveRoots = [&](uint32_t stride) {
+            angle += 0.01f;
+            glm::quat rotation = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+            for (uint32_t r = 0; r < roots; r += stride) {
+                scene.SetRotation(rootNodes[r], rotation);
+            }
+        };
+
+        double staticMs = MeasureMs(iterations, [&]() { scene.Update(); });
+        double partialMs = MeasureMs(iterations, [&]() { moveRoots(100); scene.Update(); });
+        double fullMs = MeasureMs(iterations, [&]() { moveRoots(1); scene.Update(); });
+
+        // The incrementally updated matrices must match a scene built from
+        // scratch with the same local transforms.
+        SceneGraph reference;
+        for (uint32_t i = 0; i < scene.Size(); i++) {
+            reference.AddNode(scene.Parent(i), scene.GetPosition(i), scene.GetRotation(i), scene.GetScale(i));
+        }
+        reference.Update();
+        float error = MaxDifference(reference.World(), scene.World());
+
+        std::cout << std::setw(10) << roots * nodesPerRoot
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(14) << staticMs
+                  << std::setw(16) << partialMs
+                  << std::setw(17) << fullMs
+                  << std::defaultfloat
+                  << std::setw(12) << error << "\n";
+    }
+}
+
+void VkBench::DrawListBenchmark() {
+    // A frame's worth of draws over a few pipelines and materials at random
+    // depths, sorted by the radix sort and by std::stable_sort.
+    std::cout << "drawlist: sort keys, median of runs, "
+              << VkJobs::ThreadCount() << " threads\n";
+    std::cout << std::setw(10) << "draws"
+              << std::setw(18) << "stable_sort (ms)"
+              << std::setw(12) << "radix (ms)"
+              << std::setw(10) << "x"
+              << std::setw(10) << "match" << "\n";
+
+    for (size_t count : { 1000u, 10000u, 100000u, 1000000u }) {
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<uint32_t> pipeline(0, 3);
+        std::uniform_int_distribution<uint32_t> material(0, 63);
+        std::uniform_real_distribution<float> depth(0.0f, 200.0f);
+
+        std::vector<DrawItem> input(count);
+        for (size_t i = 0; i < count; i++) {
+            input[i] = { VkDrawList::MakeKey(0, pipeline(rng), material(rng), depth(rng)), static_cast<uint32_t>(i), 0, 0 };
+        }
+        int iterations = count >= 1000000 ? 10 : 50;
+
+        std::vector<DrawItem> reference, items, scratch;
+        double stdMs = MeasureMs(iterations, [&]() {
+            reference = input;
+            std::stable_sort(reference.begin(), reference.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+        });
+        double radixMs = MeasureMs(iterations, [&]() {
+            items = input;
+            VkDrawList::Sort(items, scratch);
+        });
+
+        bool match = std::equal(items.begin(), items.end(), reference.begin(), [](const DrawItem& a, const DrawItem& b) {
+            return a.key == b.key && a.object == b.object;
+        });
+
+        std::cout << std::setw(10) << count
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(18) << stdMs
+                  << std::setw(12) << radixMs
+                  << std::setprecision(2)
+                  << std::setw(10) << stdMs / radixMs
+                  << std::defaultfloat
+                  << std::setw(10) << (match ? "yes" : "NO") << "\n";
+    }
+}
+
+namespace {
+    // Instance and device without surface or swapchain, enough to create
+    // descriptor pools and buffers.
+    struct HeadlessDevice {
+        VkInstance instance = VK_NULL_HANDLE;
+        VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+        VkDevice device = VK_NULL_HANDLE;
+
+        bool Create() {
+            VkApplicationInfo appInfo{};
+            appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+            appInfo.pApplicationName = "Vulkan3DEngine bench";
+            appInfo.apiVersion = VK_API_VERSION_1_2;
+
+            VkInstanceCreateInfo instanceInfo{};
+            instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+            instanceInfo.pApplicationInfo = &appInfo;
+            if (!VkDispatch::LoadLoader() || vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+                return false;
+            }
+            VkDispatch::LoadInstance(instance);
+
+            uint32_t deviceCount = 1;
+            if (vkEnumeratePhysicalDevices(instance, &deviceCount, &physicalDevice) < 0 || deviceCount == 0) {
+                return false;
+            }
+
+            float priority = 1.0f;
+            VkDeviceQueueCreateInfo queueInfo{};
+            queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+            queueInfo.queueFamilyIndex = 0;
+            queueInfo.queueCount = 1;
+            queueInfo.pQueuePriorities = &priority;
+
+            VkDeviceCreateInfo deviceInfo{};
+            deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+            deviceInfo.queueCreateInfoCount = 1;
+            deviceInfo.pQueueCreateInfos = &queueInfo;
+            return vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) == VK_SUCCESS;
+        }
+
+        void Destroy() {
+            if (device != VK_NULL_HANDLE) {
+                vkDestroyDevice(device, nullptr);
+            }
+            if (instance != VK_NULL_HANDLE) {
+                vkDestroyInstance(instance, nullptr);
+            }
+        }
+    };
+}
+
+void VkBench::DescriptorBenchmark() {
+    HeadlessDevice headless;
+    if (!headless.Create()) {
+        std::cout << "descriptors: no Vulkan device, skipped\n";
+        headless.Destroy();
+        return;
+    }
+    VkDevice device = headless.device;
+
+    // One small buffer for every descriptor to point at.
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = 4096;
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkBuffer buffer;
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    for (uint32_t bits = memRequirements.memoryTypeBits; !(bits & 1); bits >>= 1) {
+        allocInfo.memoryTypeIndex++;
+    }
+
+    VkDeviceMemory memory;
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+    vkBindBufferMemory(device, buffer, memory, 0);
+
+    // Same interface as the culling set: three storage buffers.
+    std::vector<VkDescriptorSetLayoutBinding> bindings(3);
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    DescriptorLayoutCache layouts;
+    layouts.Init(device);
+    VkDescriptorSetLayout layout = layouts.Get(bindings);
+    VkDescriptorUpdateTemplate updateTemplate = VkDescriptors::CreateUpdateTemplate(device, layout, bindings);
+
+    std::vector<DescriptorAllocator::PoolRatio> ratios = { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f } };
+    DescriptorInfo descriptors[3] = { DescriptorInfo(buffer), DescriptorInfo(buffer), DescriptorInfo(buffer) };
+
+    auto writeSet = [&](VkDescriptorSet set) {
+        VkWriteDescriptorSet writes[3]{};
+        for (uint32_t b = 0; b < 3; b++) {
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = set;
+            writes[b].dstBinding = b;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].descriptorCount = 1;
+            writes[b].pBufferInfo = &descriptors[b].buffer;
+        }
+        vkUpdateDescriptorSets(device, 3, writes, 0, nullptr);
+    };
+
+    // Allocating and writing setsPerFrame transient sets, then giving them
+    // back. "free-sets" frees every set on its own from a
+    // FREE_DESCRIPTOR_SET pool; the other two reset whole pools through
+    // DescriptorAllocator and differ only in how the sets are written.
+    std::cout << "descriptors: transient sets per frame, median of runs\n";
+    std::cout << std::setw(10) << "sets"
+              << std::setw(16) << "free-sets (ms)"
+              << std::setw(15) << "reset+writes"
+              << std::setw(17) << "reset+template"
+              << std::setw(8) << "pools" << "\n";
+
+    for (uint32_t setsPerFrame : { 100u, 1000u, 10000u }) {
+        int iterations = setsPerFrame >= 10000 ? 20 : 100;
+
+        VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setsPerFrame * 3 };
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        poolInfo.maxSets = setsPerFrame;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+
+        VkDescriptorPool freePool;
+        if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &freePool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor pool!");
+        }
+
+        std::vector<VkDescriptorSet> sets(setsPerFrame);
+        double freeMs = MeasureMs(iterations, [&]() {
+            VkDescriptorSetAllocateInfo setInfo{};
+            setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            setInfo.descriptorPool = freePool;
+            setInfo.descriptorSetCount = 1;
+            setInfo.pSetLayouts = &layout;
+
+            for (auto& set : sets) {
+                if (vkAllocateDescriptorSets(device, &setInfo, &set) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate descriptor set!");
+                }
+                writeSet(set);
+            }
+            for (auto& set : sets) {
+                vkFreeDescriptorSets(device, freePool, 1, &set);
+            }
+        });
+        vkDestroyDescriptorPool(device, freePool, nullptr);
+
+        // Starts small on purpose so the first frames exercise the growth path.
+        DescriptorAllocator allocator;
+        allocator.Init(device, 64, ratios);
+
+        double writesMs = MeasureMs(iterations, [&]() {
+            allocator.Reset();
+            for (uint32_t i = 0; i < setsPerFrame; i++) {
+                writeSet(allocator.Allocate(layout));
+            }
+        });
+
+        double templateMs = MeasureMs(iterations, [&]() {
+            allocator.Reset();
+            for (uint32_t i = 0; i < setsPerFrame; i++) {
+                vkUpdateDescriptorSetWithTemplate(device, allocator.Allocate(layout), updateTemplate, descriptors);
+            }
+        });
+
+        std::cout << std::setw(10) << setsPerFrame
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(16) << freeMs
+                  << std::setw(15) << writesMs
+                  << std::setw(17) << templateMs
+                  << std::defaultfloat
+                  << std::setw(8) << allocator.PoolCount() << "\n";
+
+        allocator.Destroy();
+    }
+
+    vkDestroyDescriptorUpdateTemplate(device, updateTemplate, nullptr);
+    layouts.Destroy();
+    vkDestroyBuffer(device, buffer, nullptr);
+    vkFreeMemory(device, memory, nullptr);
+    headless.Destroy();
+}
+
+void VkBench::RenderGraphBenchmark() {
+    HeadlessDevice headless;
+    if (!headless.Create()) {
+        std::cout << "rendergraph: no Vulkan device, skipped\n";
+        headless.Destroy();
+        return;
+    }
+
+    // A deferred 1080p frame: shadow map, depth pre-pass, G-buffer, light
+    // culling and lighting in compute, a two-step bloom and a tonemap into
+    // the backbuffer. The debug overlay is written but never read, so the
+    // graph culls it.
+    VkExtent2D full{ 1920, 1080 };
+    VkExtent2D half{ 960, 540 };
+    VkExtent2D shadowExtent{ 2048, 2048 };
+    auto noop = [](VkCommandBuffer) {};
+    VkClearValue clear{};
+
+    RenderGraph graph;
+    graph.Init(headless.device, headless.physicalDevice);
+
+    RgHandle backbuffer = graph.ImportImage("backbuffer", VK_FORMAT_B8G8R8A8_UNORM, full, RgUsage::Present, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    RgHandle shadowMap = graph.CreateImage("shadow-map", VK_FORMAT_D32_SFLOAT, shadowExtent);
+    RgHandle depth = graph.CreateImage("depth", VK_FORMAT_D32_SFLOAT, full);
+    RgHandle albedo = graph.CreateImage("gbuffer-albedo", VK_FORMAT_R8G8B8A8_UNORM, full);
+    RgHandle normals = graph.CreateImage("gbuffer-normals", VK_FORMAT_R16G16B16A16_SFLOAT, full);
+    RgHandle lightList = graph.CreateBuffer("light-list", 4 << 20);
+    RgHandle hdr = graph.CreateImage("hdr", VK_FORMAT_R16G16B16A16_SFLOAT, full);
+    RgHandle bloomHalf = graph.CreateImage("bloom-half", VK_FORMAT_R16G16B16A16_SFLOAT, half);
+    RgHandle bloomBlur = graph.CreateImage("bloom-blur", VK_FORMAT_R16G16B16A16_SFLOAT, half);
+    RgHandle overlay = graph.CreateImage("debug-overlay", VK_FORMAT_R8G8B8A8_UNORM, full);
+
+    uint32_t pass = graph.AddPass("shadow", RgPassType::Graphics, noop);
+    graph.Write(pass, shadowMap, RgUsage::DepthAttachment);
+    graph.Clear(pass, shadowMap, clear);
+
+    pass = graph.AddPass("depth-prepass", RgPassType::Graphics, noop);
+    graph.Write(pass, depth, RgUsage::DepthAttachment);
+    graph.Clear(pass, depth, clear);
+
+    pass = graph.AddPass("gbuffer", RgPassType::Graphics, noop);
+    graph.Read(pass, depth, RgUsage::DepthRead);
+    graph.Write(pass, albedo, RgUsage::ColorAttachment);
+    graph.Write(pass, normals, RgUsage::ColorAttachment);
+    graph.Clear(pass, albedo, clear);
+    graph.Clear(pass, normals, clear);
+
+    pass = graph.AddPass("light-cull", RgPassType::Compute, noop);
+    graph.Read(pass, depth, RgUsage::SampledCompute);
+    graph.Write(pass, lightList, RgUsage::StorageWrite);
+
+    pass = graph.AddPass("lighting", RgPassType::Compute, noop);
+    graph.Read(pass, albedo, RgUsage::SampledCompute);
+    graph.Read(pass, normals, RgUsage::SampledCompute);
+    graph.Read(pass, shadowMap, RgUsage::SampledCompute);
+    graph.Read(pass, lightList, RgUsage::StorageRead);
+    graph.Write(pass, hdr, RgUsage::StorageWrite);
+
+    pass = graph.AddPass("bloom-downsample", RgPassType::Compute, noop);
+    graph.Read(pass, hdr, RgUsage::SampledCompute);
+    graph.Write(pass, bloomHalf, RgUsage::StorageWrite);
+
+    pass = graph.AddPass("bloom-blur", RgPassType::Compute, noop);
+    graph.Read(pass, bloomHalf, RgUsage::SampledCompute);
+    graph.Write(pass, bloomBlur, RgUsage::StorageWrite);
+
+    pass = graph.AddPass("debug-overlay", RgPassType::Graphics, noop);
+    graph.Write(pass, overlay, RgUsage::ColorAttachment);
+    graph.Clear(pass, overlay, clear);
+
+    pass = graph.AddPass("tonemap", RgPassType::Graphics, noop);
+    graph.Read(pass, hdr, RgUsage::SampledFragment);
+    graph.Read(pass, bloomBlur, RgUsage::SampledFragment);
+    graph.Write(pass, backbuffer, RgUsage::ColorAttachment);
+
+    double compileMs = MeasureMs(20, [&]() { graph.Compile(); });
+
+    std::cout << graph.Dump();
+    std::cout << "compile: " << std::fixed << std::setprecision(3) << compileMs << " ms\n" << std::defaultfloat;
+
+    graph.Destroy();
+    headless.Destroy();
+}
+
+int VkBench::Run(const std::vector<std::string>& args) {
+    auto selected = [&](const std::string& name) {
+        return args.empty() || std::find(args.begin(), args.end(), name) != args.end();
+    };
+
+    if (selected("transform")) {
+        TransformBenchmark();
+    }
+
+    if (selected("culling")) {
+        CullingBenchmark();
+    }
+
+    if (selected("scene")) {
+        SceneBenchmark();
+    }
+
+    if (selected("descriptors")) {
+        DescriptorBenchmark();
+    }
+
+    if (selected("drawlist")) {
+        DrawListBenchmark();
+    }
+
+    if (selected("rendergraph")) {
+        RenderGraphBenchmark();
+    }
+
+    return 0;
+}
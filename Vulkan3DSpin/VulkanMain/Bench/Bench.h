@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Benchmarks, run with "Vulkan3DEngine --bench [name...]". No window is
+// created; "descriptors" and "rendergraph" create a headless instance and
+// device, the rest are CPU-only.
+namespace VkBench {
+    int Run(const std::vector<std::string>& args);
+
+    void TransformBenchmark();
+    void CullingBenchmark();
+    void SceneBenchmark();
+    void DescriptorBenchmark();
+    void DrawListBenchmark();
+    void RenderGraphBenchmark();
+}
@@ -0,0 +1,440 @@
+#include "VulkanMain/Bench/Micro.h"
+#include "VulkanMain/Transform/Transform.h"
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/DrawList/DrawList.h"
+#include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Vertex/UBO/Ubo.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    // Written by SinkPointer so that the store cannot be proven dead.
+    volatile const void* escapeSink = nullptr;
+
+    void FillRandomTransforms(TransformSystem& transforms, size_t count) {
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+        std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+        transforms.Clear();
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 axis = glm::normalize(glm::vec3(position(rng), position(rng), position(rng)) + glm::vec3(0.0f, 0.0f, 0.001f));
+            transforms.Add(
+                glm::vec3(position(rng), position(rng), position(rng)),
+                glm::angleAxis(angle(rng), axis),
+                glm::vec3(scale(rng), scale(rng), scale(rng))
+            );
+        }
+    }
+
+    glm::mat4 CameraViewProj(float farPlane) {
+        glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, farPlane);
+        proj[1][1] *= -1;
+        return proj * view;
+    }
+
+    // The per-frame camera and UBO math at the top of RecordCommandBuffer.
+    void MicroFrameMatrices(MicroState& state) {
+        float time = 0.0f;
+        for (auto _ : state) {
+            glm::quat rotation = glm::angleAxis(time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            glm::mat4 view = glm::lookAt(glm::vec3(2.0f, 2.0f, 2.0f), glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+            glm::mat4 proj = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 10.0f);
+            proj[1][1] *= -1;
+
+            glm::mat4 viewProj = proj * view;
+            Frustum frustum = VkCulling::ExtractFrustum(viewProj);
+            glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+
+            UBO ubo{};
+            ubo.mvp = viewProj * glm::mat4_cast(rotation);
+
+            VkMicro::DoNotOptimize(ubo);
+            VkMicro::DoNotOptimize(frustum);
+            VkMicro::DoNotOptimize(cameraPosition);
+            time += 1.0f / 60.0f;
+        }
+    }
+
+    // World and MVP for Arg() objects on the calling thread.
+    void MicroObjectMatrices(MicroState& state) {
+        size_t count = static_cast<size_t>(state.Arg());
+        TransformSystem transforms;
+        FillRandomTransforms(transforms, count);
+        glm::mat4 viewProj = CameraViewProj(10.0f);
+
+        for (auto _ : state) {
+            transforms.ComputeMatricesRange(viewProj, 0, count);
+            VkMicro::DoNotOptimize(transforms.MVP()[0]);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // Interleaving separate position and color streams into Vertex and
+    // copying them into a staging block, as a mesh upload does.
+    void MicroVertexPacking(MicroState& state) {
+        size_t count = static_cast<size_t>(state.Arg());
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+
+        std::vector<glm::vec3> positions(count), colors(count);
+        for (size_t i = 0; i < count; i++) {
+            positions[i] = glm::vec3(value(rng), value(rng), value(rng));
+            colors[i] = glm::abs(glm::vec3(value(rng), value(rng), value(rng)));
+        }
+        std::vector<Vertex> vertices(count);
+        std::vector<char> staging(sizeof(Vertex) * count);
+
+        for (auto _ : state) {
+            for (size_t i = 0; i < count; i++) {
+                vertices[i].pos = positions[i];
+                vertices[i].color = colors[i];
+            }
+            memcpy(staging.data(), vertices.data(), staging.size());
+            VkMicro::DoNotOptimize(staging[0]);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // VkUtils::ReadFile of an Arg()-byte file, warm in the OS cache; shader
+    // and mesh loads go through it.
+    void MicroReadFile(MicroState& state) {
+        size_t size = static_cast<size_t>(state.Arg());
+        std::filesystem::path path = std::filesystem::temp_directory_path() / ("vk3d-microbench-" + std::to_string(size) + ".bin");
+        {
+            std::vector<char> contents(size);
+            std::mt19937 rng(1234);
+            for (char& c : contents) {
+                c = static_cast<char>(rng());
+            }
+            std::ofstream file(path, std::ios::binary);
+            file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        }
+
+        for (auto _ : state) {
+            std::vector<char> buffer = VkUtils::ReadFile(path.string());
+            VkMicro::DoNotOptimize(buffer.data());
+        }
+        state.SetItemsProcessed(size);
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    // VkUtils::FindMemoryType on the memory types of a typical discrete GPU,
+    // cycling through the lookups buffers and images make.
+    void MicroMemoryTypeLookup(MicroState& state) {
+        const VkMemoryPropertyFlags deviceLocal = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        const VkMemoryPropertyFlags hostCached = hostVisible | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+
+        VkPhysicalDeviceMemoryProperties memProperties{};
+        const VkMemoryPropertyFlags types[] = {
+            0, deviceLocal, deviceLocal, hostVisible, hostCached, deviceLocal | hostVisible,
+            deviceLocal, hostVisible, hostCached, deviceLocal, deviceLocal | hostVisible
+        };
+        memProperties.memoryTypeCount = static_cast<uint32_t>(std::size(types));
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            memProperties.memoryTypes[i].propertyFlags = types[i];
+            memProperties.memoryTypes[i].heapIndex = (types[i] & deviceLocal) ? 0 : 1;
+        }
+
+        struct Lookup {
+            uint32_t typeBits;
+            VkMemoryPropertyFlags properties;
+        };
+        const Lookup lookups[] = {
+            { 0x7ffu, deviceLocal },
+            { 0x7ffu, hostVisible },
+            { 0x7f0u, hostCached },
+            { 0x600u, deviceLocal | hostVisible },
+        };
+
+        size_t next = 0;
+        for (auto _ : state) {
+            const Lookup& lookup = lookups[next];
+            next = (next + 1) % std::size(lookups);
+            VkMicro::DoNotOptimize(VkUtils::FindMemoryType(memProperties, lookup.typeBits, lookup.properties));
+        }
+    }
+
+    // VkDrawList::Sort of Arg() draws over a few pipelines and materials;
+    // includes copying the unsorted list back in.
+    void MicroDrawListSort(MicroState& state) {
+        size_t count = static_cast<size_t>(state.Arg());
+        std::mt19937 rng(1234);
+        std::uniform_int_distribution<uint32_t> pipeline(0, 3);
+        std::uniform_int_distribution<uint32_t> material(0, 63);
+        std::uniform_real_distribution<float> depth(0.0f, 200.0f);
+
+        std::vector<DrawItem> input(count);
+        for (size_t i = 0; i < count; i++) {
+            input[i] = { VkDrawList::MakeKey(0, pipeline(rng), material(rng), depth(rng)), static_cast<uint32_t>(i), 0, 0 };
+        }
+
+        std::vector<DrawItem> items, scratch;
+        for (auto _ : state) {
+            items = input;
+            VkDrawList::Sort(items, scratch);
+            VkMicro::DoNotOptimize(items[0]);
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    // CullingSystem::Cull of Arg() unit cubes scattered around the camera.
+    void MicroFrustumCulling(MicroState& state) {
+        size_t count = static_cast<size_t>(state.Arg());
+        TransformSystem transforms;
+        FillRandomTransforms(transforms, count);
+        glm::mat4 viewProj = CameraViewProj(200.0f);
+        transforms.ComputeMatricesRange(viewProj, 0, count);
+
+        MeshBounds bounds{};
+        bounds.box.min = glm::vec3(-0.5f);
+        bounds.box.max = glm::vec3(0.5f);
+        bounds.sphere.center = glm::vec3(0.0f);
+        bounds.sphere.radius = glm::length(glm::vec3(0.5f));
+
+        CullingSystem culling;
+        culling.Resize(count);
+        for (size_t i = 0; i < count; i++) {
+            culling.SetLocalBounds(static_cast<uint32_t>(i), bounds);
+        }
+        culling.UpdateWorldBounds(transforms.World());
+
+        Frustum frustum = VkCulling::ExtractFrustum(viewProj);
+        std::vector<uint32_t> visible;
+        for (auto _ : state) {
+            culling.Cull(frustum, visible);
+            VkMicro::DoNotOptimize(visible.data());
+        }
+        state.SetItemsProcessed(count);
+    }
+
+    std::string FullName(const MicroBenchmark& benchmark, int64_t arg) {
+        if (benchmark.args.size() == 1 && benchmark.args[0] == 0) {
+            return benchmark.name;
+        }
+        return benchmark.name + "/" + std::to_string(arg);
+    }
+
+    std::string JsonString(const std::string& text) {
+        std::string escaped = "\"";
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped + "\"";
+    }
+
+    void WriteRun(std::ostream& out, const MicroResult& result, const std::string& name, const char* runType,
+                  const char* aggregate, int repetitions, int index, double nanoseconds, bool last) {
+        out << "    {\n"
+            << "      \"name\": " << JsonString(name) << ",\n"
+            << "      \"run_name\": " << JsonString(result.name) << ",\n"
+            << "      \"run_type\": \"" << runType << "\",\n"
+            << "      \"repetitions\": " << repetitions << ",\n";
+        if (aggregate != nullptr) {
+            out << "      \"aggregate_name\": \"" << aggregate << "\",\n";
+        }
+        else {
+            out << "      \"repetition_index\": " << index << ",\n";
+        }
+        out << "      \"threads\": 1,\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << nanoseconds << ",\n"
+            << "      \"cpu_time\": " << nanoseconds << ",\n"
+            << "      \"time_unit\": \"ns\"";
+        if (result.itemsPerSecond > 0.0 && aggregate == nullptr && nanoseconds > 0.0) {
+            out << ",\n      \"items_per_second\": " << result.itemsPerSecond * result.median / nanoseconds;
+        }
+        out << "\n    }" << (last ? "\n" : ",\n");
+    }
+}
+
+void VkMicro::SinkPointer(const void* pointer) {
+    escapeSink = pointer;
+}
+
+const std::vector<MicroBenchmark>& VkMicro::Benchmarks() {
+    static const std::vector<MicroBenchmark> benchmarks = {
+        { "frame_matrices", MicroFrameMatrices, { 0 } },
+        { "object_matrices", MicroObjectMatrices, { 1, 64, 1024, 16384 } },
+        { "vertex_packing", MicroVertexPacking, { 3, 1024, 65536 } },
+        { "read_file", MicroReadFile, { 4096, 65536, 1 << 20 } },
+        { "memory_type_lookup", MicroMemoryTypeLookup, { 0 } },
+        { "drawlist_sort", MicroDrawListSort, { 64, 1024, 16384 } },
+        { "frustum_culling", MicroFrustumCulling, { 1024, 16384 } },
+    };
+    return benchmarks;
+}
+
+MicroResult VkMicro::RunBenchmark(const std::string& name, MicroFunction function, int64_t arg, double minSeconds, int repetitions) {
+    // Grow the iteration count until one run is long enough to time, with
+    // headroom so the repetitions do not fall just short of minSeconds.
+    uint64_t iterations = 1;
+    while (true) {
+        MicroState state(iterations, arg);
+        function(state);
+        double elapsed = state.ElapsedSeconds();
+        if (elapsed >= minSeconds || iterations >= (1ull << 40)) {
+            break;
+        }
+        double scale = elapsed > 0.0 ? minSeconds * 1.4 / elapsed : 10.0;
+        iterations = static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0));
+    }
+
+    MicroResult result;
+    result.name = name;
+    result.iterations = iterations;
+
+    uint64_t items = 0;
+    for (int r = 0; r < repetitions; r++) {
+        MicroState state(iterations, arg);
+        function(state);
+        result.samples.push_back(state.ElapsedSeconds() * 1e9 / static_cast<double>(iterations));
+        items = state.ItemsProcessed();
+    }
+
+    std::vector<double> sorted = result.samples;
+    std::sort(sorted.begin(), sorted.end());
+    size_t n = sorted.size();
+    result.median = n % 2 == 1 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+
+    double sum = 0.0;
+    for (double sample : sorted) {
+        sum += sample;
+    }
+    result.mean = sum / static_cast<double>(n);
+
+    double variance = 0.0;
+    for (double sample : sorted) {
+        variance += (sample - result.mean) * (sample - result.mean);
+    }
+    result.stddev = n > 1 ? std::sqrt(variance / static_cast<double>(n - 1)) : 0.0;
+
+    if (items > 0 && result.median > 0.0) {
+        result.itemsPerSecond = static_cast<double>(items) * 1e9 / result.median;
+    }
+    return result;
+}
+
+void VkMicro::PrintResult(std::ostream& out, const MicroResult& result) {
+    double cv = result.mean > 0.0 ? 100.0 * result.stddev / result.mean : 0.0;
+    out << std::left << std::setw(32) << result.name << std::right
+        << std::fixed << std::setprecision(1)
+        << std::setw(14) << result.median
+        << std::setw(8) << cv
+        << std::setw(14) << result.iterations;
+    if (result.itemsPerSecond > 0.0) {
+        out << std::setprecision(2) << std::setw(14) << result.itemsPerSecond / 1e6;
+    }
+    out << std::defaultfloat << "\n";
+}
+
+void VkMicro::WriteJson(std::ostream& out, const std::vector<MicroResult>& results, int repetitions) {
+    char date[32] = {};
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << std::setprecision(9);
+    out << "{\n"
+        << "  \"context\": {\n"
+        << "    \"date\": \"" << date << "\",\n"
+        << "    \"executable\": \"Vulkan3DEngine --microbench\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef NDEBUG
+        << "    \"library_build_type\": \"release\"\n"
+#else
+        << "    \"library_build_type\": \"debug\"\n"
+#endif
+        << "  },\n"
+        << "  \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const MicroResult& result = results[i];
+        for (int r = 0; r < static_cast<int>(result.samples.size()); r++) {
+            WriteRun(out, result, result.name, "iteration", nullptr, repetitions, r, result.samples[r], false);
+        }
+        bool last = i + 1 == results.size();
+        WriteRun(out, result, result.name + "_mean", "aggregate", "mean", repetitions, 0, result.mean, false);
+        WriteRun(out, result, result.name + "_median", "aggregate", "median", repetitions, 0, result.median, false);
+        WriteRun(out, result, result.name + "_stddev", "aggregate", "stddev", repetitions, 0, result.stddev, last);
+    }
+
+    out << "  ]\n"
+        << "}\n";
+}
+
+int VkMicro::Run(const std::vector<std::string>& args) {
+    std::string filter = ".*";
+    std::string jsonPath;
+    double minSeconds = 0.1;
+    int repetitions = 5;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        bool hasValue = i + 1 < args.size();
+        if (args[i] == "--filter" && hasValue) {
+            filter = args[++i];
+        }
+        else if (args[i] == "--json" && hasValue) {
+            jsonPath = args[++i];
+        }
+        else if (args[i] == "--min-time" && hasValue) {
+            minSeconds = std::stod(args[++i]);
+        }
+        else if (args[i] == "--repetitions" && hasValue) {
+            repetitions = std::max(1, std::stoi(args[++i]));
+        }
+        else {
+            std::cerr << "usage: Vulkan3DEngine --microbench [--filter regex] [--min-time 0.1] [--repetitions 5] [--json out.json]\n";
+            return 2;
+        }
+    }
+
+    std::regex pattern(filter);
+    std::cout << std::left << std::setw(32) << "benchmark" << std::right
+              << std::setw(14) << "time (ns)"
+              << std::setw(8) << "cv %"
+              << std::setw(14) << "iterations"
+              << std::setw(14) << "Mitems/s" << "\n";
+
+    std::vector<MicroResult> results;
+    for (const MicroBenchmark& benchmark : Benchmarks()) {
+        for (int64_t arg : benchmark.args) {
+            std::string name = FullName(benchmark, arg);
+            if (!std::regex_search(name, pattern)) {
+                continue;
+            }
+            results.push_back(RunBenchmark(name, benchmark.function, arg, minSeconds, repetitions));
+            PrintResult(std::cout, results.back());
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream file(jsonPath);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to open microbenchmark output file!");
+        }
+        WriteJson(file, results, repetitions);
+    }
+    return 0;
+}
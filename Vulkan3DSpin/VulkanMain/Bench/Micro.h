@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Microbenchmarks of CPU hot paths that need no GPU, in the style of Google
+// Benchmark but without the dependency:
+//   Vulkan3DEngine --microbench [--filter regex] [--min-time 0.1]
+//                  [--repetitions 5] [--json out.json]
+// A benchmark runs its body once per iteration of the range-for; work before
+// the loop is setup and is not timed:
+//   void MicroFoo(MicroState& state) {
+//       std::vector<float> input = ...;
+//       for (auto _ : state) {
+//           VkMicro::DoNotOptimize(Foo(input));
+//       }
+//   }
+// Iterations are doubled until one run takes min-time, then the benchmark is
+// repeated and reported as the median time per iteration. Inputs come from
+// fixed seeds and --json writes Google Benchmark's format, so two commits'
+// files can be compared with its tools/compare.py.
+class MicroState {
+public:
+    MicroState(uint64_t iterations, int64_t arg) : iterations(iterations), arg(arg) {}
+
+    // The registered argument, e.g. the element count.
+    int64_t Arg() const { return arg; }
+    uint64_t Iterations() const { return iterations; }
+
+    // Items handled per iteration, reported as a rate.
+    void SetItemsProcessed(uint64_t items) { itemsProcessed = items; }
+    uint64_t ItemsProcessed() const { return itemsProcessed; }
+
+    double ElapsedSeconds() const { return elapsed; }
+
+    // The loop variable; never read.
+    struct [[maybe_unused]] Value {};
+
+    class Iterator {
+    public:
+        Iterator(MicroState* state, uint64_t remaining) : state(state), remaining(remaining) {}
+
+        Value operator*() const { return {}; }
+        Iterator& operator++() { remaining--; return *this; }
+
+        bool operator!=(const Iterator&) {
+            if (remaining != 0) {
+                return true;
+            }
+            state->StopTimer();
+            return false;
+        }
+
+    private:
+        MicroState* state;
+        uint64_t remaining;
+    };
+
+    Iterator begin() {
+        StartTimer();
+        return Iterator(this, iterations);
+    }
+    Iterator end() { return Iterator(this, 0); }
+
+private:
+    void StartTimer() { start = std::chrono::steady_clock::now(); }
+    void StopTimer() { elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+
+    uint64_t iterations;
+    int64_t arg;
+    uint64_t itemsProcessed = 0;
+    std::chrono::steady_clock::time_point start;
+    double elapsed = 0.0;
+};
+
+using MicroFunction = void (*)(MicroState& state);
+
+// Registered once per argument; reported as "name/arg" when there are several.
+struct MicroBenchmark {
+    std::string name;
+    MicroFunction function;
+    std::vector<int64_t> args;
+};
+
+// One benchmark and argument; times are nanoseconds per iteration.
+struct MicroResult {
+    std::string name;
+    uint64_t iterations = 0;
+    std::vector<double> samples;
+    double median = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double itemsPerSecond = 0.0;
+};
+
+namespace VkMicro {
+    // Stores pointer out of line, where the optimizer cannot see it unused.
+    void SinkPointer(const void* pointer);
+
+    // Keeps the compiler from dropping the computation of whatever pointer
+    // points at: it has to be in memory here and may be read. GCC and Clang
+    // get an empty asm that takes the pointer and clobbers memory; MSVC has
+    // no inline asm on x64, so the pointer escapes through SinkPointer and
+    // _ReadWriteBarrier keeps the stores from moving past it.
+    inline void Escape(const void* pointer) {
+#if defined(_MSC_VER)
+        SinkPointer(pointer);
+        _ReadWriteBarrier();
+#else
+        asm volatile("" : : "g"(pointer) : "memory");
+#endif
+    }
+
+    template <typename T>
+    inline void DoNotOptimize(const T& value) {
+        Escape(&value);
+    }
+
+    // Every benchmark of the suite, in report order. New hot paths are added
+    // to the table in Micro.cpp.
+    const std::vector<MicroBenchmark>& Benchmarks();
+
+    MicroResult RunBenchmark(const std::string& name, MicroFunction function, int64_t arg, double minSeconds, int repetitions);
+
+    void PrintResult(std::ostream& out, const MicroResult& result);
+    void WriteJson(std::ostream& out, const std::vector<MicroResult>& results, int repetitions);
+
+    int Run(const std::vector<std::string>& args);
+}
@@ -0,0 +1,583 @@
+#include "VulkanMain/Benchmark/Benchmark.h"
+#include "VulkanMain/Benchmark/Regression.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+#include "VulkanMain/Dispatch/Null.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    const BenchmarkScene SCENES[] = {
+        //  name            objects  segments  gpu    cluster bindless occlusion
+        { "default",        1,       0,        false, false,  false,   false },
+        { "many-objects",   10000,   0,        false, false,  false,   false },
+        { "dense-mesh",     16,      256,      false, true,   false,   false },
+        { "stress",         4096,    64,       false, true,   false,   false },
+        { "gpu-driven",     10000,   32,       true,  false,  true,    false },
+    };
+
+    void PrintUsage() {
+        std::cout << "usage: --benchmark [scene] [key=value...] [--out file.json, default benchmark.json] [--baselines dir] [--null]\n"
+                  << "scenes:";
+        for (const auto& scene : SCENES) {
+            std::cout << " " << scene.name;
+        }
+        std::cout << "\nkeys: objects, segments, warmup, frames, fps, gpu-culling, cluster-culling, bindless, occlusion-culling, direct-dispatch, parallel-init\n";
+    }
+
+    std::string EscapeJson(const std::string& text) {
+        std::string escaped;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                escaped += ' ';
+            }
+            else {
+                escaped += c;
+            }
+        }
+        return escaped;
+    }
+
+    void WriteSummary(std::ostream& out, const BenchmarkSummary& summary) {
+        out << "{ \"mean\": " << summary.mean
+            << ", \"min\": " << summary.min
+            << ", \"p50\": " << summary.p50
+            << ", \"p90\": " << summary.p90
+            << ", \"p99\": " << summary.p99
+            << ", \"max\": " << summary.max << " }";
+    }
+
+    void WriteSamples(std::ostream& out, const std::vector<double>& samples) {
+        out << "[";
+        for (size_t i = 0; i < samples.size(); i++) {
+            out << (i > 0 ? ", " : "") << samples[i];
+        }
+        out << "]";
+    }
+}
+
+bool VkBenchmark::FindScene(const std::string& name, BenchmarkScene& scene) {
+    for (const auto& candidate : SCENES) {
+        if (candidate.name == name) {
+            scene = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void VkBenchmark::BuildSphere(uint32_t segments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    segments = std::max(segments, 3u);
+    uint32_t rings = std::max(segments / 2, 2u);
+    const float pi = 3.14159265f;
+
+    vertices.clear();
+    indices.clear();
+    vertices.reserve(static_cast<size_t>(rings + 1) * (segments + 1));
+    indices.reserve(static_cast<size_t>(rings) * segments * 6);
+
+    // The seam column is duplicated so every quad indexes its own corners.
+    for (uint32_t ring = 0; ring <= rings; ring++) {
+        float theta = pi * static_cast<float>(ring) / static_cast<float>(rings);
+        for (uint32_t segment = 0; segment <= segments; segment++) {
+            float phi = 2.0f * pi * static_cast<float>(segment) / static_cast<float>(segments);
+            glm::vec3 normal(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+            vertices.push_back({ normal * 0.5f, normal * 0.5f + glm::vec3(0.5f) });
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++) {
+        for (uint32_t segment = 0; segment < segments; segment++) {
+            uint32_t a = ring * (segments + 1) + segment;
+            uint32_t b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+}
+
+std::string VkBenchmark::Fingerprint(const BenchmarkResult& result) {
+    std::ostringstream out;
+    out << std::hex << std::setfill('0')
+        << std::setw(4) << result.vendorId << "-"
+        << std::setw(4) << result.deviceId << "-"
+        << std::setw(8) << result.driverVersion;
+    return out.str();
+}
+
+BenchmarkSummary VkBenchmark::Summarize(std::vector<double> samples) {
+    BenchmarkSummary summary;
+    if (samples.empty()) {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+        return samples[std::max<size_t>(rank, 1) - 1];
+    };
+
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    summary.mean = total / static_cast<double>(samples.size());
+    summary.min = samples.front();
+    summary.p50 = percentile(50.0);
+    summary.p90 = percentile(90.0);
+    summary.p99 = percentile(99.0);
+    summary.max = samples.back();
+    return summary;
+}
+
+void VkBenchmark::WriteJson(std::ostream& out, const BenchmarkConfig& config, const BenchmarkResult& result) {
+    const BenchmarkScene& scene = config.scene;
+    out << std::fixed << std::setprecision(4);
+    out << "{\n"
+        << "  \"scene\": { \"name\": \"" << EscapeJson(scene.name) << "\""
+        << ", \"objects\": " << scene.objects
+        << ", \"sphereSegments\": " << scene.sphereSegments
+        << ", \"gpuCulling\": " << (scene.gpuCulling ? "true" : "false")
+        << ", \"clusterCulling\": " << (scene.clusterCulling ? "true" : "false")
+        << ", \"bindless\": " << (scene.bindless ? "true" : "false")
+        << ", \"occlusionCulling\": " << (scene.occlusionCulling ? "true" : "false") << " },\n"
+        << "  \"device\": \"" << EscapeJson(result.device) << "\",\n"
+        << "  \"backend\": \"" << (config.nullBackend ? "null" : "vulkan") << "\",\n"
+        << "  \"directDispatch\": " << (config.directDispatch ? "true" : "false") << ",\n"
+        << "  \"machine\": { \"vendorID\": " << result.vendorId
+        << ", \"deviceID\": " << result.deviceId
+        << ", \"driverVersion\": " << result.driverVersion
+        << ", \"fingerprint\": \"" << Fingerprint(result) << "\" },\n"
+        << "  \"warmupFrames\": " << config.warmupFrames << ",\n"
+        << "  \"frames\": " << config.frames << ",\n"
+        << "  \"frameSeconds\": " << std::setprecision(6) << config.frameSeconds << std::setprecision(4) << ",\n";
+
+    out << "  \"cpuFrameMs\": ";
+    WriteSummary(out, Summarize(result.cpuMs));
+    out << ",\n  \"gpuFrameMs\": ";
+    if (result.gpuMs.empty()) {
+        out << "null";
+    }
+    else {
+        WriteSummary(out, Summarize(result.gpuMs));
+    }
+
+    BenchmarkSummary record = Summarize(result.recordMs);
+    out << ",\n  \"recordFrameMs\": ";
+    WriteSummary(out, record);
+    out << ",\n  \"drawsPerFrame\": " << result.drawsPerFrame;
+    out << ",\n  \"recordNsPerDraw\": ";
+    if (result.drawsPerFrame == 0) {
+        out << "null";
+    }
+    else {
+        out << record.p50 * 1e6 / result.drawsPerFrame;
+    }
+
+    const StartupStats& startup = result.startup;
+    out << ",\n  \"startup\": { \"parallel\": " << (startup.parallel ? "true" : "false")
+        << ", \"initMs\": " << startup.initMs
+        << ", \"firstFrameMs\": " << startup.firstFrameMs
+        << ", \"phases\": [";
+    for (size_t i = 0; i < startup.phases.size(); i++) {
+        const StartupPhase& phase = startup.phases[i];
+        out << (i > 0 ? "," : "") << "\n    { \"name\": \"" << phase.name << "\""
+            << ", \"thread\": " << phase.thread
+            << ", \"startMs\": " << phase.startMs
+            << ", \"ms\": " << phase.ms << " }";
+    }
+    out << "\n  ] }";
+
+    // Bytes.
+    const MemoryStats& memory = result.memory;
+    out << ",\n  \"memory\": { \"budgetExtension\": " << (memory.budgetExtension ? "true" : "false")
+        << ", \"allocations\": " << memory.allocations
+        << ", \"heaps\": [";
+    for (size_t i = 0; i < memory.heaps.size(); i++) {
+        const MemoryHeapStats& heap = memory.heaps[i];
+        out << (i > 0 ? "," : "") << "\n    { \"size\": " << heap.size
+            << ", \"budget\": " << heap.budget
+            << ", \"usage\": " << heap.usage
+            << ", \"allocated\": " << heap.allocated
+            << ", \"deviceLocal\": " << (heap.deviceLocal ? "true" : "false") << " }";
+    }
+    out << "\n  ], \"categories\": {";
+    for (size_t i = 0; i < MEMORY_CATEGORY_COUNT; i++) {
+        out << (i > 0 ? ", " : " ") << "\"" << VkMemory::CategoryName(static_cast<MemoryCategory>(i)) << "\": " << memory.categories[i];
+    }
+    out << " } }";
+
+    // Only with a streamed texture (VK3D_TEXTURE).
+    const TextureStats& textures = result.textures;
+    const MemoryPoolStats& pool = textures.pool;
+    out << ",\n  \"textures\": { \"textures\": " << textures.textures
+        << ", \"residentBytes\": " << textures.residentBytes
+        << ", \"evictions\": " << textures.evictions
+        << ", \"defragMoves\": " << textures.defragMoves
+        << ", \"pool\": { \"blocks\": " << pool.blocks
+        << ", \"blockBytes\": " << pool.blockBytes
+        << ", \"usedBytes\": " << pool.usedBytes
+        << ", \"largestFree\": " << pool.largestFree
+        << ", \"releasedBytes\": " << pool.releasedBytes << " } }";
+    out << ",\n  \"defragFrameMs\": ";
+    WriteSummary(out, Summarize(result.defragMs));
+
+    // As of the last frame; only GPU-driven culling fills it in.
+    const CullStats& culling = result.culling;
+    out << ",\n  \"culling\": { \"tested\": " << culling.tested
+        << ", \"visible\": " << culling.visible
+        << ", \"culled\": " << culling.culled
+        << ", \"occlusion\": " << (culling.occlusion ? "true" : "false")
+        << ", \"occluded\": " << culling.occluded
+        << ", \"occludedTriangles\": " << culling.occludedTriangles
+        << ", \"lateDraws\": " << culling.lateDraws << " }";
+    out << ",\n  \"occlusionGpuMs\": ";
+    if (result.occlusionGpuMs.empty()) {
+        out << "null";
+    }
+    else {
+        WriteSummary(out, Summarize(result.occlusionGpuMs));
+    }
+
+    out << ",\n  \"callsPerFrame\": ";
+    if (result.callsPerFrame.empty()) {
+        out << "null";
+    }
+    else {
+        out << "{";
+        for (size_t i = 0; i < result.callsPerFrame.size(); i++) {
+            out << (i > 0 ? ", " : " ") << "\"" << result.callsPerFrame[i].first << "\": " << result.callsPerFrame[i].second;
+        }
+        out << " }";
+    }
+
+    out << ",\n  \"samples\": {\n    \"cpuFrameMs\": ";
+    WriteSamples(out, result.cpuMs);
+    out << ",\n    \"gpuFrameMs\": ";
+    WriteSamples(out, result.gpuMs);
+    out << ",\n    \"recordFrameMs\": ";
+    WriteSamples(out, result.recordMs);
+    out << ",\n    \"occlusionGpuMs\": ";
+    WriteSamples(out, result.occlusionGpuMs);
+    out << "\n  }\n}\n";
+}
+
+int VkBenchmark::Run(const std::vector<std::string>& args) {
+    BenchmarkConfig config;
+    FindScene("default", config.scene);
+    std::string baselineDirectory;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        if (arg == "--out" && i + 1 < args.size()) {
+            config.outputPath = args[++i];
+            continue;
+        }
+        if (arg == "--baselines" && i + 1 < args.size()) {
+            baselineDirectory = args[++i];
+            continue;
+        }
+        if (arg == "--null") {
+            config.nullBackend = true;
+            continue;
+        }
+
+        size_t equals = arg.find('=');
+        if (equals == std::string::npos) {
+            if (!FindScene(arg, config.scene)) {
+                std::cout << "unknown benchmark scene " << arg << "\n";
+                PrintUsage();
+                return 1;
+            }
+            continue;
+        }
+
+        std::string key = arg.substr(0, equals);
+        uint32_t value = 0;
+        const char* first = arg.data() + equals + 1;
+        const char* last = arg.data() + arg.size();
+        std::from_chars_result parsed = std::from_chars(first, last, value);
+        if (first == last || parsed.ec != std::errc() || parsed.ptr != last) {
+            std::cout << "bad value for benchmark key " << key << "\n";
+            PrintUsage();
+            return 1;
+        }
+        if (key == "objects") {
+            config.scene.objects = std::max(value, 1u);
+        }
+        else if (key == "segments") {
+            config.scene.sphereSegments = value;
+        }
+        else if (key == "warmup") {
+            config.warmupFrames = value;
+        }
+        else if (key == "frames") {
+            config.frames = std::max(value, 1u);
+        }
+        else if (key == "fps") {
+            config.frameSeconds = 1.0 / std::max(value, 1u);
+        }
+        else if (key == "gpu-culling") {
+            config.scene.gpuCulling = value != 0;
+        }
+        else if (key == "cluster-culling") {
+            config.scene.clusterCulling = value != 0;
+        }
+        else if (key == "bindless") {
+            config.scene.bindless = value != 0;
+        }
+        else if (key == "occlusion-culling") {
+            config.scene.occlusionCulling = value != 0;
+        }
+        else if (key == "direct-dispatch") {
+            config.directDispatch = value != 0;
+        }
+        else if (key == "parallel-init") {
+            config.parallelInit = value != 0;
+        }
+        else {
+            std::cout << "unknown benchmark key " << key << "\n";
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    BenchmarkResult result;
+    VkMain vkm;
+    vkm.runBenchmark(config, result);
+
+    std::ofstream file(config.outputPath);
+    if (!file) {
+        throw std::runtime_error("failed to open " + config.outputPath + "!");
+    }
+    WriteJson(file, config, result);
+
+    BenchmarkSummary cpu = Summarize(result.cpuMs);
+    std::cout << std::fixed << std::setprecision(3)
+              << config.scene.name << " on " << result.device << ": cpu p50 " << cpu.p50 << " ms, p99 " << cpu.p99 << " ms";
+    if (!result.gpuMs.empty()) {
+        BenchmarkSummary gpu = Summarize(result.gpuMs);
+        std::cout << " | gpu p50 " << gpu.p50 << " ms, p99 " << gpu.p99 << " ms";
+    }
+    BenchmarkSummary record = Summarize(result.recordMs);
+    std::cout << " | record p50 " << record.p50 << " ms";
+    if (result.drawsPerFrame > 0) {
+        std::cout << " (" << std::setprecision(1) << record.p50 * 1e6 / result.drawsPerFrame << " ns/draw)" << std::setprecision(3);
+    }
+    std::cout << " | first frame " << std::setprecision(1) << result.startup.firstFrameMs << " ms" << std::setprecision(3);
+    if (!result.callsPerFrame.empty()) {
+        std::cout << " | " << std::setprecision(1) << result.callsPerFrame.front().second << " calls/frame";
+    }
+    std::cout << " -> " << config.outputPath << "\n";
+
+    // Same as a separate --regress run with the default limits.
+    if (!baselineDirectory.empty()) {
+        return VkRegression::Check({ config, result }, baselineDirectory, false, 0.01, 5.0);
+    }
+    return 0;
+}
+
+// Offscreen color targets in place of the swapchain images, one per frame
+// in flight; imageIndex is simply currentFrame.
+void VkMain::CreateOffscreenTargets() {
+    swapChainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+    swapChainExtent = { WIDTH, HEIGHT };
+    imageCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+
+    swapChainImages.resize(imageCount);
+    offscreenMemory.resize(imageCount);
+    for (uint32_t i = 0; i < imageCount; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = swapChainImageFormat;
+        imageInfo.extent = { swapChainExtent.width, swapChainExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        // Transfer source so frame capture works headless too.
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &swapChainImages[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create offscreen image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, swapChainImages[i], &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (VkMemory::Allocate(device, allocInfo, MemoryCategory::RenderTarget, offscreenMemory[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate offscreen image memory!");
+        }
+        vkBindImageMemory(device, swapChainImages[i], offscreenMemory[i], 0);
+    }
+
+    // Nothing waits on these without a present, but Cleanup expects them.
+    renderFinishedSemaphores.resize(imageCount);
+    for (size_t i = 0; i < renderFinishedSemaphores.size(); i++) {
+        VkSemaphoreCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        vkCreateSemaphore(device, &info, nullptr, &renderFinishedSemaphores[i]);
+    }
+    imagesInFlight.resize(imageCount, VK_NULL_HANDLE);
+
+    if (!captureDirectory.empty() && !VkCapture::SupportsFormat(swapChainImageFormat)) {
+        captureDirectory.clear();
+    }
+}
+
+void VkMain::DestroyOffscreenTargets() {
+    for (size_t i = 0; i < swapChainImages.size(); i++) {
+        vkDestroyImage(device, swapChainImages[i], nullptr);
+        VkMemory::Free(device, offscreenMemory[i]);
+    }
+    swapChainImages.clear();
+    offscreenMemory.clear();
+}
+
+// Two timestamps per frame in flight at the top and bottom of the frame's
+// command buffer, and with occlusion culling two more around the pyramid
+// build and late cull. Work on the async compute queue is not included.
+void VkMain::CreateTimestampQueries() {
+    QueueFamilyIndices indices = VkUtils::FindQueueFamilies(physicalDevice, surface);
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+    timestampValidBits = families[indices.graphicsFamily.value()].timestampValidBits;
+    if (timestampValidBits == 0) {
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    timestampPeriodNs = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = TIMESTAMPS_PER_FRAME * MAX_FRAMES_IN_FLIGHT;
+
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+    textureStreamer.SetTimestampQueries(timestampQueryPool, 4, TIMESTAMPS_PER_FRAME, timestampPeriodNs, timestampValidBits);
+}
+
+// Called once the frame's fence has signaled, like ReadFragmentQueries.
+void VkMain::ReadTimestampQueries(uint32_t frame) {
+    frameStats.gpuFrameMs = -1.0;
+    frameStats.culling.occlusionGpuMs = -1.0;
+    if (timestampQueryPool == VK_NULL_HANDLE || frameStats.frame < static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT)) {
+        return;
+    }
+
+    uint64_t mask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+    auto readSpan = [&](uint32_t first, double& ms) {
+        uint64_t timestamps[2];
+        if (vkGetQueryPoolResults(device, timestampQueryPool, first, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            uint64_t ticks = (timestamps[1] - timestamps[0]) & mask;
+            ms = static_cast<double>(ticks) * timestampPeriodNs / 1e6;
+        }
+    };
+
+    readSpan(frame * TIMESTAMPS_PER_FRAME, frameStats.gpuFrameMs);
+    // What occlusion culling adds: the pyramid build and the late cull.
+    if (occlusionCulling) {
+        readSpan(frame * TIMESTAMPS_PER_FRAME + 2, frameStats.culling.occlusionGpuMs);
+    }
+}
+
+void VkMain::DestroyTimestampQueries() {
+    vkDestroyQueryPool(device, timestampQueryPool, nullptr);
+    timestampQueryPool = VK_NULL_HANDLE;
+}
+
+double VkMain::FrameTime() const {
+    if (benchmarking) {
+        return static_cast<double>(frameStats.frame) * benchmark.frameSeconds;
+    }
+    return glfwGetTime();
+}
+
+void VkMain::BenchmarkLoop(BenchmarkResult& result) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    result.device = properties.deviceName;
+    result.vendorId = properties.vendorID;
+    result.deviceId = properties.deviceID;
+    result.driverVersion = properties.driverVersion;
+
+    uint32_t totalFrames = benchmark.warmupFrames + benchmark.frames;
+    result.cpuMs.reserve(benchmark.frames);
+    result.gpuMs.reserve(benchmark.frames);
+    result.recordMs.reserve(benchmark.frames);
+
+    // A frame's timestamps are read when its slot comes around again,
+    // MAX_FRAMES_IN_FLIGHT frames later.
+    auto addGpuSample = [&](uint64_t frame) {
+        if (frameStats.gpuFrameMs >= 0.0 && frame >= benchmark.warmupFrames) {
+            result.gpuMs.push_back(frameStats.gpuFrameMs);
+        }
+        if (frameStats.culling.occlusionGpuMs >= 0.0 && frame >= benchmark.warmupFrames) {
+            result.occlusionGpuMs.push_back(frameStats.culling.occlusionGpuMs);
+        }
+    };
+
+    for (uint32_t frame = 0; frame < totalFrames; frame++) {
+        if (benchmark.nullBackend && frame == benchmark.warmupFrames) {
+            VkNull::ResetCalls();
+        }
+        DrawFrame();
+        if (frame >= benchmark.warmupFrames) {
+            result.cpuMs.push_back(frameStats.cpuFrameMs);
+            result.recordMs.push_back(frameStats.recordMs);
+            result.defragMs.push_back(frameStats.textures.defragMs);
+        }
+        if (frame >= static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT)) {
+            addGpuSample(frame - MAX_FRAMES_IN_FLIGHT);
+        }
+    }
+
+    result.drawsPerFrame = frameStats.state.draws;
+    result.startup = startup;
+    result.memory = frameStats.memory;
+    result.textures = frameStats.textures;
+    result.culling = frameStats.culling;
+
+    // "total" first, then each entry point.
+    if (benchmark.nullBackend) {
+        double frames = static_cast<double>(benchmark.frames);
+        result.callsPerFrame.emplace_back("total", static_cast<double>(VkNull::TotalCalls()) / frames);
+        for (const auto& call : VkNull::Calls()) {
+            result.callsPerFrame.emplace_back(call.first, static_cast<double>(call.second) / frames);
+        }
+    }
+
+    vkDeviceWaitIdle(device);
+    uint32_t first = totalFrames > static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT) ? totalFrames - MAX_FRAMES_IN_FLIGHT : 0;
+    for (uint32_t frame = first; frame < totalFrames; frame++) {
+        ReadTimestampQueries(frame % MAX_FRAMES_IN_FLIGHT);
+        addGpuSample(frame);
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/Startup/Startup.h"
+#include "VulkanMain/Memory/Memory.h"
+#include "VulkanMain/Texture/Texture.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A stress scene for the benchmark runner. Every object is an instance of
+// one mesh, laid out on the usual grid.
+struct BenchmarkScene {
+    std::string name;
+    uint32_t objects = 1;
+    // UV sphere with this many segments around and half as many rings;
+    // 0 keeps the built-in tetrahedron.
+    uint32_t sphereSegments = 0;
+    bool gpuCulling = false;
+    bool clusterCulling = false;
+    bool bindless = false;
+    bool occlusionCulling = false;
+};
+
+struct BenchmarkConfig {
+    BenchmarkScene scene;
+    uint32_t warmupFrames = 60;
+    uint32_t frames = 600;
+    // Simulated time per frame; animation never reads the wall clock, so
+    // frame N looks the same on every run and every machine.
+    double frameSeconds = 1.0 / 60.0;
+    // The renderer prints its fallbacks to stdout, so results go to a file.
+    std::string outputPath = "benchmark.json";
+    // Run on the null backend (see Null.h): CPU cost only, plus call counts.
+    bool nullBackend = false;
+    // Device-level calls bypass the loader (see VkDispatch::LoadDevice);
+    // direct-dispatch=0 measures the trampolines instead.
+    bool directDispatch = true;
+    // parallel-init=0 runs every startup step on the main thread.
+    bool parallelInit = true;
+};
+
+// One sample per measured frame. cpuMs is the wall time of DrawFrame,
+// gpuMs the span between timestamps at the start and end of the frame's
+// command buffer; it stays empty when the graphics queue has no timestamps.
+struct BenchmarkResult {
+    // From the properties of the device PickPhysicalDevice chose.
+    std::string device;
+    uint32_t vendorId = 0;
+    uint32_t deviceId = 0;
+    uint32_t driverVersion = 0;
+    std::vector<double> cpuMs;
+    std::vector<double> gpuMs;
+    // Vulkan calls per measured frame: "total", then each entry point, most
+    // frequent first. Only the null backend counts them.
+    std::vector<std::pair<std::string, double>> callsPerFrame;
+    // Time in RecordCommandBuffer per measured frame, and the draws it
+    // recorded on the last one.
+    std::vector<double> recordMs;
+    uint32_t drawsPerFrame = 0;
+    StartupStats startup;
+    // As of the last frame.
+    MemoryStats memory;
+    TextureStats textures;
+    // GPU time moving texture images per measured frame.
+    std::vector<double> defragMs;
+    CullStats culling;
+    // GPU time of the Hi-Z build and late cull per measured frame; empty
+    // without occlusion culling or timestamps.
+    std::vector<double> occlusionGpuMs;
+};
+
+// Percentiles are nearest-rank.
+struct BenchmarkSummary {
+    double mean = 0.0;
+    double min = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Runs the renderer headless for a fixed number of frames, with "Vulkan3DEngine
+// --benchmark [scene] [key=value...] [--out file.json] [--baselines dir] [--null]".
+// No window, surface or swapchain is created, so a software ICD such as
+// lavapipe is enough. --baselines checks the run like --regress does (see
+// Regression.h); --null leaves out the driver and counts calls instead.
+namespace VkBenchmark {
+    // "default", "many-objects", "dense-mesh", "stress" or "gpu-driven".
+    bool FindScene(const std::string& name, BenchmarkScene& scene);
+
+    // Radius 0.5 around the origin, colored by normal.
+    void BuildSphere(uint32_t segments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // "vendor-device-driver" in hex; results are only compared with
+    // baselines from the same fingerprint.
+    std::string Fingerprint(const BenchmarkResult& result);
+
+    BenchmarkSummary Summarize(std::vector<double> samples);
+    void WriteJson(std::ostream& out, const BenchmarkConfig& config, const BenchmarkResult& result);
+
+    int Run(const std::vector<std::string>& args);
+}
@@ -0,0 +1,422 @@
+#include "VulkanMain/Benchmark/Regression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+    // Just enough JSON for what VkBenchmark::WriteJson produces.
+    struct JsonValue {
+        enum class Type { Null, Bool, Number, String, Array, Object };
+
+        Type type = Type::Null;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        std::vector<JsonValue> array;
+        std::vector<std::pair<std::string, JsonValue>> object;
+
+        const JsonValue& operator[](const std::string& key) const {
+            static const JsonValue null;
+            for (const auto& member : object) {
+                if (member.first == key) {
+                    return member.second;
+                }
+            }
+            return null;
+        }
+    };
+
+    class JsonParser {
+    public:
+        explicit JsonParser(const std::string& json) : text(json) {}
+
+        JsonValue Parse() {
+            JsonValue value = ParseValue();
+            SkipSpace();
+            if (pos != text.size()) {
+                Fail();
+            }
+            return value;
+        }
+
+    private:
+        void SkipSpace() {
+            while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) {
+                pos++;
+            }
+        }
+
+        [[noreturn]] void Fail() const {
+            throw std::runtime_error("failed to parse benchmark JSON at offset " + std::to_string(pos) + "!");
+        }
+
+        void Expect(char c) {
+            SkipSpace();
+            if (pos >= text.size() || text[pos] != c) {
+                Fail();
+            }
+            pos++;
+        }
+
+        bool Consume(const char* word) {
+            size_t length = std::char_traits<char>::length(word);
+            if (text.compare(pos, length, word) != 0) {
+                return false;
+            }
+            pos += length;
+            return true;
+        }
+
+        bool ConsumeComma() {
+            SkipSpace();
+            if (pos < text.size() && text[pos] == ',') {
+                pos++;
+                return true;
+            }
+            return false;
+        }
+
+        std::string ParseString() {
+            Expect('"');
+            std::string value;
+            while (pos < text.size() && text[pos] != '"') {
+                if (text[pos] == '\\' && pos + 1 < text.size()) {
+                    pos++;
+                }
+                value += text[pos++];
+            }
+            Expect('"');
+            return value;
+        }
+
+        JsonValue ParseValue() {
+            SkipSpace();
+            if (pos >= text.size()) {
+                Fail();
+            }
+
+            JsonValue value;
+            char c = text[pos];
+            if (c == '{') {
+                value.type = JsonValue::Type::Object;
+                pos++;
+                SkipSpace();
+                if (pos < text.size() && text[pos] == '}') {
+                    pos++;
+                    return value;
+                }
+                while (true) {
+                    std::string key = ParseString();
+                    Expect(':');
+                    value.object.emplace_back(std::move(key), ParseValue());
+                    if (!ConsumeComma()) {
+                        break;
+                    }
+                }
+                Expect('}');
+            }
+            else if (c == '[') {
+                value.type = JsonValue::Type::Array;
+                pos++;
+                SkipSpace();
+                if (pos < text.size() && text[pos] == ']') {
+                    pos++;
+                    return value;
+                }
+                while (true) {
+                    value.array.push_back(ParseValue());
+                    if (!ConsumeComma()) {
+                        break;
+                    }
+                }
+                Expect(']');
+            }
+            else if (c == '"') {
+                value.type = JsonValue::Type::String;
+                value.string = ParseString();
+            }
+            else if (Consume("true") || Consume("false")) {
+                value.type = JsonValue::Type::Bool;
+                value.boolean = c == 't';
+            }
+            else if (Consume("null")) {
+                value.type = JsonValue::Type::Null;
+            }
+            else {
+                char* end = nullptr;
+                value.type = JsonValue::Type::Number;
+                value.number = std::strtod(text.c_str() + pos, &end);
+                if (end == text.c_str() + pos) {
+                    Fail();
+                }
+                pos = static_cast<size_t>(end - text.c_str());
+            }
+            return value;
+        }
+
+        const std::string& text;
+        size_t pos = 0;
+    };
+
+    std::vector<double> ReadSamples(const JsonValue& array) {
+        std::vector<double> samples;
+        samples.reserve(array.array.size());
+        for (const auto& value : array.array) {
+            samples.push_back(value.number);
+        }
+        return samples;
+    }
+
+    bool SameScene(const BenchmarkConfig& a, const BenchmarkConfig& b) {
+        return a.scene.name == b.scene.name &&
+            a.scene.objects == b.scene.objects &&
+            a.scene.sphereSegments == b.scene.sphereSegments &&
+            a.scene.gpuCulling == b.scene.gpuCulling &&
+            a.scene.clusterCulling == b.scene.clusterCulling &&
+            a.scene.bindless == b.scene.bindless &&
+            a.scene.occlusionCulling == b.scene.occlusionCulling &&
+            a.directDispatch == b.directDispatch &&
+            std::fabs(a.frameSeconds - b.frameSeconds) < 1e-6;
+    }
+
+    MetricComparison CompareSamples(const std::string& metric, const std::vector<double>& baseline, const std::vector<double>& current, double alpha, double thresholdPercent) {
+        MetricComparison comparison;
+        comparison.metric = metric;
+        comparison.baseline = VkBenchmark::Summarize(baseline);
+        comparison.current = VkBenchmark::Summarize(current);
+        if (baseline.empty() || current.empty()) {
+            return comparison;
+        }
+
+        comparison.pValue = VkRegression::MannWhitneyGreater(baseline, current);
+        double medianChange = comparison.baseline.p50 > 0.0
+            ? 100.0 * (comparison.current.p50 - comparison.baseline.p50) / comparison.baseline.p50
+            : 0.0;
+        comparison.regressed = comparison.pValue < alpha && medianChange > thresholdPercent;
+        return comparison;
+    }
+
+    std::string FormatChange(double baseline, double current) {
+        if (baseline <= 0.0) {
+            return "-";
+        }
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << std::showpos << 100.0 * (current - baseline) / baseline << "%";
+        return out.str();
+    }
+}
+
+BenchmarkRecord VkRegression::LoadRecord(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("failed to open " + path + "!");
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::string text = contents.str();
+    JsonValue json = JsonParser(text).Parse();
+
+    BenchmarkRecord record;
+    const JsonValue& scene = json["scene"];
+    record.config.scene.name = scene["name"].string;
+    record.config.scene.objects = static_cast<uint32_t>(scene["objects"].number);
+    record.config.scene.sphereSegments = static_cast<uint32_t>(scene["sphereSegments"].number);
+    record.config.scene.gpuCulling = scene["gpuCulling"].boolean;
+    record.config.scene.clusterCulling = scene["clusterCulling"].boolean;
+    record.config.scene.bindless = scene["bindless"].boolean;
+    record.config.scene.occlusionCulling = scene["occlusionCulling"].boolean;
+    record.config.warmupFrames = static_cast<uint32_t>(json["warmupFrames"].number);
+    record.config.frames = static_cast<uint32_t>(json["frames"].number);
+    record.config.frameSeconds = json["frameSeconds"].number;
+    record.config.outputPath = path;
+    // Missing in older files, which all went through the loader.
+    record.config.directDispatch = json["directDispatch"].boolean;
+
+    const JsonValue& machine = json["machine"];
+    record.result.device = json["device"].string;
+    record.result.vendorId = static_cast<uint32_t>(machine["vendorID"].number);
+    record.result.deviceId = static_cast<uint32_t>(machine["deviceID"].number);
+    record.result.driverVersion = static_cast<uint32_t>(machine["driverVersion"].number);
+
+    const JsonValue& samples = json["samples"];
+    record.result.cpuMs = ReadSamples(samples["cpuFrameMs"]);
+    record.result.gpuMs = ReadSamples(samples["gpuFrameMs"]);
+    record.result.recordMs = ReadSamples(samples["recordFrameMs"]);
+    record.result.drawsPerFrame = static_cast<uint32_t>(json["drawsPerFrame"].number);
+    return record;
+}
+
+std::string VkRegression::BaselinePath(const std::string& directory, const BenchmarkRecord& record) {
+    std::string name = record.config.scene.name + "-" + VkBenchmark::Fingerprint(record.result) + ".json";
+    return (std::filesystem::path(directory) / name).string();
+}
+
+double VkRegression::MannWhitneyGreater(const std::vector<double>& baseline, const std::vector<double>& current) {
+    size_t n1 = current.size();
+    size_t n2 = baseline.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+
+    // Ranks over both samples together; ties share their average rank.
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(n1 + n2);
+    for (double sample : current) {
+        all.push_back({ sample, true });
+    }
+    for (double sample : baseline) {
+        all.push_back({ sample, false });
+    }
+    std::sort(all.begin(), all.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    double currentRanks = 0.0;
+    double tieTerm = 0.0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        double rank = 0.5 * static_cast<double>(i + 1 + j);
+        for (size_t k = i; k < j; k++) {
+            if (all[k].second) {
+                currentRanks += rank;
+            }
+        }
+        double ties = static_cast<double>(j - i);
+        tieTerm += ties * ties * ties - ties;
+        i = j;
+    }
+
+    double n = static_cast<double>(n1 + n2);
+    double u = currentRanks - 0.5 * static_cast<double>(n1) * static_cast<double>(n1 + 1);
+    double mean = 0.5 * static_cast<double>(n1) * static_cast<double>(n2);
+    double variance = static_cast<double>(n1) * static_cast<double>(n2) / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+
+    // Continuity-corrected z; large U means current tends to be slower.
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<MetricComparison> VkRegression::Compare(const BenchmarkRecord& baseline, const BenchmarkRecord& current, double alpha, double thresholdPercent) {
+    return {
+        CompareSamples("cpuFrameMs", baseline.result.cpuMs, current.result.cpuMs, alpha, thresholdPercent),
+        CompareSamples("gpuFrameMs", baseline.result.gpuMs, current.result.gpuMs, alpha, thresholdPercent),
+        CompareSamples("recordFrameMs", baseline.result.recordMs, current.result.recordMs, alpha, thresholdPercent),
+    };
+}
+
+void VkRegression::PrintTable(std::ostream& out, const std::vector<MetricComparison>& comparisons, double thresholdPercent) {
+    out << std::left << std::setw(14) << "metric"
+        << std::right << std::setw(8) << "stat"
+        << std::setw(12) << "baseline"
+        << std::setw(12) << "current"
+        << std::setw(10) << "change" << "\n";
+
+    for (const auto& comparison : comparisons) {
+        const BenchmarkSummary& a = comparison.baseline;
+        const BenchmarkSummary& b = comparison.current;
+        const std::pair<const char*, std::pair<double, double>> rows[] = {
+            { "mean", { a.mean, b.mean } },
+            { "p50", { a.p50, b.p50 } },
+            { "p90", { a.p90, b.p90 } },
+            { "p99", { a.p99, b.p99 } },
+            { "max", { a.max, b.max } },
+        };
+
+        for (const auto& row : rows) {
+            out << std::left << std::setw(14) << (&row == &rows[0] ? comparison.metric : "")
+                << std::right << std::setw(8) << row.first
+                << std::fixed << std::setprecision(3)
+                << std::setw(12) << row.second.first
+                << std::setw(12) << row.second.second
+                << std::setw(10) << FormatChange(row.second.first, row.second.second) << "\n";
+        }
+
+        out << std::left << std::setw(14) << "" << std::right << "  Mann-Whitney p = "
+            << std::setprecision(4) << comparison.pValue << " -> "
+            << (comparison.regressed ? "REGRESSION" : "ok")
+            << " (median " << FormatChange(a.p50, b.p50) << ", threshold +"
+            << std::setprecision(1) << thresholdPercent << "%)\n";
+    }
+    out << std::defaultfloat;
+}
+
+int VkRegression::Check(const BenchmarkRecord& current, const std::string& directory, bool update, double alpha, double thresholdPercent) {
+    std::string path = BaselinePath(directory, current);
+
+    if (update || !std::filesystem::exists(path)) {
+        std::filesystem::create_directories(directory);
+        std::ofstream file(path);
+        if (!file) {
+            throw std::runtime_error("failed to open " + path + "!");
+        }
+        VkBenchmark::WriteJson(file, current.config, current.result);
+        std::cout << "stored baseline " << path << "\n";
+        return 0;
+    }
+
+    BenchmarkRecord baseline = LoadRecord(path);
+    if (!SameScene(baseline.config, current.config)) {
+        std::cout << "baseline " << path << " was recorded with different scene parameters; rerun with --update\n";
+        return 1;
+    }
+
+    std::cout << current.config.scene.name << " on " << current.result.device
+              << " (" << VkBenchmark::Fingerprint(current.result) << ") against " << path << "\n";
+    std::vector<MetricComparison> comparisons = Compare(baseline, current, alpha, thresholdPercent);
+    PrintTable(std::cout, comparisons, thresholdPercent);
+
+    bool regressed = std::any_of(comparisons.begin(), comparisons.end(), [](const MetricComparison& c) { return c.regressed; });
+    return regressed ? 1 : 0;
+}
+
+int VkRegression::Run(const std::vector<std::string>& args) {
+    std::string resultPath;
+    std::string directory = "baselines";
+    bool update = false;
+    double alpha = 0.01;
+    double thresholdPercent = 5.0;
+
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--baselines" && hasValue) {
+            directory = args[++i];
+        }
+        else if (arg == "--update") {
+            update = true;
+        }
+        else if (arg == "--alpha" && hasValue) {
+            alpha = std::stod(args[++i]);
+        }
+        else if (arg == "--threshold" && hasValue) {
+            thresholdPercent = std::stod(args[++i]);
+        }
+        else if (resultPath.empty() && arg.rfind("--", 0) != 0) {
+            resultPath = arg;
+        }
+        else {
+            resultPath.clear();
+            break;
+        }
+    }
+
+    if (resultPath.empty()) {
+        std::cout << "usage: --regress result.json [--baselines dir] [--update] [--alpha 0.01] [--threshold 5]\n";
+        return 2;
+    }
+
+    return Check(LoadRecord(resultPath), directory, update, alpha, thresholdPercent);
+}
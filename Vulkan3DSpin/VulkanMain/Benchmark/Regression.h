@@ -0,0 +1,49 @@
+#pragma once
+#include "VulkanMain/Benchmark/Benchmark.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A benchmark JSON file read back.
+struct BenchmarkRecord {
+    BenchmarkConfig config;
+    BenchmarkResult result;
+};
+
+// One frame-time metric of a run against its baseline. pValue is the
+// one-sided Mann-Whitney probability of samples at least this much slower
+// if nothing had changed; 1 when either side has no samples.
+struct MetricComparison {
+    std::string metric;
+    BenchmarkSummary baseline;
+    BenchmarkSummary current;
+    double pValue = 1.0;
+    bool regressed = false;
+};
+
+// Keeps one baseline per scene and machine fingerprint, named
+// "<scene>-<fingerprint>.json" in the baseline directory, and checks new
+// runs against it:
+//   Vulkan3DEngine --regress result.json [--baselines dir] [--update]
+//                  [--alpha 0.01] [--threshold 5]
+// A metric regresses when the shift is significant at alpha and its median
+// is more than threshold percent slower; the exit code is 1 if any does.
+// Without a baseline, or with --update, the run becomes the baseline.
+namespace VkRegression {
+    BenchmarkRecord LoadRecord(const std::string& path);
+    std::string BaselinePath(const std::string& directory, const BenchmarkRecord& record);
+
+    // Normal approximation with tie correction; fine from about 20 samples
+    // a side, which every benchmark run has.
+    double MannWhitneyGreater(const std::vector<double>& baseline, const std::vector<double>& current);
+
+    std::vector<MetricComparison> Compare(const BenchmarkRecord& baseline, const BenchmarkRecord& current, double alpha, double thresholdPercent);
+    void PrintTable(std::ostream& out, const std::vector<MetricComparison>& comparisons, double thresholdPercent);
+
+    // Compares current with its baseline in directory, or stores it there;
+    // returns the exit code.
+    int Check(const BenchmarkRecord& current, const std::string& directory, bool update, double alpha, double thresholdPercent);
+
+    int Run(const std::vector<std::string>& args);
+}
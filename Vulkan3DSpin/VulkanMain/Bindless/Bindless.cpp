@@ -0,0 +1,228 @@
+#include "VulkanMain/Bindless/Bindless.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <cassert>
+#include <stdexcept>
+
+void BindlessSlots::Reset(uint32_t slotCapacity) {
+    freeSlots.clear();
+    next = 0;
+    capacity = slotCapacity;
+}
+
+uint32_t BindlessSlots::Allocate() {
+    if (!freeSlots.empty()) {
+        uint32_t slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+
+    if (next >= capacity) {
+        throw std::runtime_error("bindless descriptor table is full!");
+    }
+    return next++;
+}
+
+void BindlessSlots::Free(uint32_t slot) {
+    assert(slot < next);
+    freeSlots.push_back(slot);
+}
+
+void BindlessTable::Create(VkDevice vkDevice, uint32_t bufferCapacity, uint32_t imageCapacity) {
+    assert(vkDevice != VK_NULL_HANDLE);
+    device = vkDevice;
+    buffers.Reset(bufferCapacity);
+    images.Reset(imageCapacity);
+
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    bindings[0].binding = VkBindless::BUFFER_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[0].descriptorCount = bufferCapacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+
+    // Upper bound only; the set is allocated with imageCapacity below.
+    bindings[1].binding = VkBindless::IMAGE_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[1].descriptorCount = imageCapacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorBindingFlags common =
+        VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    VkDescriptorBindingFlags bindingFlags[2] = {
+        common,
+        common | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = 2;
+    flagsInfo.pBindingFlags = bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = &flagsInfo;
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.bindingCount = 2;
+    layoutInfo.pBindings = bindings;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSizes[2]{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = bufferCapacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[1].descriptorCount = imageCapacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo countInfo{};
+    countInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    countInfo.descriptorSetCount = 1;
+    countInfo.pDescriptorCounts = &imageCapacity;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = &countInfo;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate bindless descriptor set!");
+    }
+}
+
+void BindlessTable::Destroy() {
+    if (device == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkDestroyDescriptorPool(device, pool, nullptr);
+    vkDestroyDescriptorSetLayout(device, layout, nullptr);
+    pool = VK_NULL_HANDLE;
+    layout = VK_NULL_HANDLE;
+    set = VK_NULL_HANDLE;
+    device = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessTable::RegisterBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    uint32_t slot = buffers.Allocate();
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = VkBindless::BUFFER_BINDING;
+    write.dstArrayElement = slot;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return slot;
+}
+
+uint32_t BindlessTable::RegisterImage(VkImageView view, VkSampler sampler, VkImageLayout imageLayout) {
+    uint32_t slot = images.Allocate();
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = view;
+    imageInfo.imageLayout = imageLayout;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = VkBindless::IMAGE_BINDING;
+    write.dstArrayElement = slot;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    return slot;
+}
+
+// The stale descriptor stays in place; PARTIALLY_BOUND makes that legal as
+// long as no shader reads the slot.
+void BindlessTable::ReleaseBuffer(uint32_t slot) {
+    buffers.Free(slot);
+}
+
+void BindlessTable::ReleaseImage(uint32_t slot) {
+    images.Free(slot);
+}
+
+void VkMain::CreateBindless() {
+    assert(device != VK_NULL_HANDLE);
+    assert(objectBuffers.size() == MAX_FRAMES_IN_FLIGHT);
+
+    bindlessTable.Create(device, bindlessBufferCapacity, bindlessImageCapacity);
+
+    objectBufferSlots.resize(MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        objectBufferSlots[i] = bindlessTable.RegisterBuffer(objectBuffers[i]);
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(BindlessDrawConstants);
+
+    VkDescriptorSetLayout setLayout = bindlessTable.Layout();
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &setLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &bindlessPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create bindless pipeline layout!");
+    }
+
+    bindlessPipeline = BuildGraphicsPipeline(shaderDirectory + "bindless_vert.spv", shaderDirectory + "bindless_frag.spv", bindlessPipelineLayout);
+    if (depthPrepass) {
+        bindlessDepthPipeline = BuildGraphicsPipeline(shaderDirectory + "bindless_vert.spv", "", bindlessPipelineLayout);
+    }
+}
+
+// Called for every bindless draw; after the first one of a frame the cache
+// drops both binds and the constants are already in place.
+void VkMain::BindBindless(const glm::mat4& viewProj, bool depthOnly) {
+    if (drawState.BindPipeline(depthOnly ? bindlessDepthPipeline : bindlessPipeline)) {
+        BindlessDrawConstants constants{};
+        constants.viewProj = viewProj;
+        constants.objectBuffer = objectBufferSlots[currentFrame];
+        drawState.PushConstants(bindlessPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+    }
+
+    drawState.BindDescriptorSet(bindlessPipelineLayout, bindlessTable.Set());
+}
+
+void VkMain::DestroyBindless() {
+    vkDestroyPipeline(device, bindlessPipeline, nullptr);
+    vkDestroyPipeline(device, bindlessDepthPipeline, nullptr);
+    vkDestroyPipelineLayout(device, bindlessPipelineLayout, nullptr);
+    bindlessTable.Destroy();
+    objectBufferSlots.clear();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace VkBindless {
+    // Requested table sizes; CreateLogicalDevice clamps them to the device's
+    // update-after-bind limits.
+    constexpr uint32_t MAX_BUFFERS = 1024;
+    constexpr uint32_t MAX_IMAGES = 16384;
+
+    constexpr uint32_t BUFFER_BINDING = 0;
+    constexpr uint32_t IMAGE_BINDING = 1;
+
+    // Slot value meaning "no resource", e.g. an object without a texture.
+    constexpr uint32_t INVALID_INDEX = 0xFFFFFFFFu;
+}
+
+// Push constants of bindless.vert (80 bytes). Set once per frame; each draw
+// selects its object through firstInstance.
+struct BindlessDrawConstants {
+    glm::mat4 viewProj;
+    uint32_t objectBuffer;
+    uint32_t padding[3];
+};
+
+// Hands out array slots of one descriptor binding. Freed slots are reused
+// first so the used range stays dense.
+class BindlessSlots {
+public:
+    void Reset(uint32_t capacity);
+    uint32_t Allocate();
+    void Free(uint32_t slot);
+
+    uint32_t Capacity() const { return capacity; }
+    uint32_t Used() const { return next - static_cast<uint32_t>(freeSlots.size()); }
+
+private:
+    std::vector<uint32_t> freeSlots;
+    uint32_t next = 0;
+    uint32_t capacity = 0;
+};
+
+// One global descriptor set holding every storage buffer and sampled image
+// the renderer uses, in two large arrays that shaders index by slot. Created
+// with UPDATE_AFTER_BIND and PARTIALLY_BOUND, so resources can be registered
+// while the set is bound by frames in flight, and unused slots may stay
+// empty. The image array is the variable-count binding.
+//
+// Releasing a slot does not wait for the GPU: the caller must make sure no
+// frame in flight still reads it before the slot is registered again.
+class BindlessTable {
+public:
+    void Create(VkDevice device, uint32_t bufferCapacity, uint32_t imageCapacity);
+    void Destroy();
+
+    uint32_t RegisterBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    uint32_t RegisterImage(VkImageView view, VkSampler sampler, VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void ReleaseBuffer(uint32_t slot);
+    void ReleaseImage(uint32_t slot);
+
+    VkDescriptorSetLayout Layout() const { return layout; }
+    VkDescriptorSet Set() const { return set; }
+
+    const BindlessSlots& Buffers() const { return buffers; }
+    const BindlessSlots& Images() const { return images; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    BindlessSlots buffers;
+    BindlessSlots images;
+};
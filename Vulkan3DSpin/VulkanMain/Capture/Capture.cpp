@@ -0,0 +1,376 @@
+#include "VulkanMain/Capture/Capture.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    std::array<uint32_t, 256> MakeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[n] = c;
+        }
+        return table;
+    }
+
+    uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) {
+        static const std::array<uint32_t, 256> table = MakeCrcTable();
+        crc = ~crc;
+        for (size_t i = 0; i < size; i++) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    void PutBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+        out.push_back(static_cast<uint8_t>(value >> 24));
+        out.push_back(static_cast<uint8_t>(value >> 16));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void PutChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data) {
+        PutBigEndian(out, static_cast<uint32_t>(data.size()));
+        size_t start = out.size();
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), data.begin(), data.end());
+        PutBigEndian(out, Crc32(out.data() + start, out.size() - start));
+    }
+
+    bool IsBgr(VkFormat format) {
+        return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    uint32_t FindReadbackMemory(VkPhysicalDevice physicalDevice, uint32_t typeBits, bool& coherent) {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+        // Cached memory makes the CPU reads fast; coherent is the fallback.
+        const VkMemoryPropertyFlags preferred[] = {
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        };
+        for (VkMemoryPropertyFlags properties : preferred) {
+            for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+                VkMemoryPropertyFlags flags = memProperties.memoryTypes[i].propertyFlags;
+                if ((typeBits & (1u << i)) && (flags & properties) == properties) {
+                    coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+                    return i;
+                }
+            }
+        }
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+}
+
+bool VkCapture::SupportsFormat(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::vector<uint8_t> VkCapture::EncodePng(uint32_t width, uint32_t height, const uint8_t* rgb) {
+    static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    constexpr size_t MAX_STORED_BLOCK = 65535;
+
+    std::vector<uint8_t> out(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+
+    std::vector<uint8_t> header;
+    PutBigEndian(header, width);
+    PutBigEndian(header, height);
+    // 8 bits per channel, RGB, deflate, adaptive filtering, no interlace.
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    PutChunk(out, "IHDR", header);
+
+    // Every row starts with filter type 0 (none).
+    size_t rowSize = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), rgb + y * rowSize, rgb + (y + 1) * rowSize);
+    }
+
+    // zlib stream: header, stored blocks, Adler-32 of the raw data.
+    std::vector<uint8_t> zlib;
+    zlib.reserve(raw.size() + raw.size() / MAX_STORED_BLOCK * 5 + 16);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    uint32_t a = 1, b = 0;
+    size_t offset = 0;
+    do {
+        size_t blockSize = std::min(raw.size() - offset, MAX_STORED_BLOCK);
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(blockSize));
+        zlib.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8_t>(~blockSize));
+        zlib.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+
+        // Reduced every 4096 bytes, well before b could overflow.
+        for (size_t i = offset; i < offset + blockSize; i++) {
+            a += raw[i];
+            b += a;
+            if ((i & 4095) == 4095) {
+                a %= 65521;
+                b %= 65521;
+            }
+        }
+        a %= 65521;
+        b %= 65521;
+        offset += blockSize;
+    } while (offset < raw.size());
+    PutBigEndian(zlib, (b << 16) | a);
+
+    PutChunk(out, "IDAT", zlib);
+    PutChunk(out, "IEND", {});
+    return out;
+}
+
+void FrameCapture::Init
+(
+    VkDevice vkDevice,
+    VkPhysicalDevice physicalDevice,
+    VkFormat imageFormat,
+    VkExtent2D imageExtent,
+    uint32_t framesInFlight,
+    const std::string& outputDirectory,
+    VkCapture::FileFormat outputFormat,
+    uint32_t captureInterval
+) {
+    device = vkDevice;
+    format = imageFormat;
+    extent = imageExtent;
+    directory = outputDirectory;
+    fileFormat = outputFormat;
+    interval = std::max(1u, captureInterval);
+    slotSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+    std::filesystem::create_directories(directory);
+
+    slots.resize(framesInFlight + VkCapture::EXTRA_SLOTS);
+    for (Slot& slot : slots) {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = slotSize;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create capture buffer!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, slot.buffer, &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = FindReadbackMemory(physicalDevice, memRequirements.memoryTypeBits, coherent);
+
+        if (VkMemory::Allocate(device, allocInfo, MemoryCategory::Readback, slot.memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate capture memory!");
+        }
+        vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+        vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &slot.mapped);
+    }
+
+    stopping = false;
+    worker = std::thread(&FrameCapture::WorkerLoop, this);
+}
+
+void FrameCapture::Destroy() {
+    if (slots.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+
+    for (Slot& slot : slots) {
+        vkUnmapMemory(device, slot.memory);
+        vkDestroyBuffer(device, slot.buffer, nullptr);
+        VkMemory::Free(device, slot.memory);
+    }
+    slots.clear();
+    queue.clear();
+}
+
+bool FrameCapture::Begin(uint64_t frameNumber, uint32_t frame) {
+    if (slots.empty() || frameNumber % interval != 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (uint32_t i = 0; i < slots.size(); i++) {
+        uint32_t index = (nextSlot + i) % slots.size();
+        Slot& slot = slots[index];
+        if (slot.state == SlotState::Free) {
+            slot.state = SlotState::Recorded;
+            slot.frame = frame;
+            slot.frameNumber = frameNumber;
+            currentSlot = index;
+            nextSlot = (index + 1) % slots.size();
+            return true;
+        }
+    }
+
+    stats.dropped++;
+    return false;
+}
+
+VkBuffer FrameCapture::Buffer() const {
+    return slots[currentSlot].buffer;
+}
+
+void FrameCapture::RecordCopy(VkCommandBuffer commandBuffer, VkImage image) {
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { extent.width, extent.height, 1 };
+
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slots[currentSlot].buffer, 1, &region);
+}
+
+void FrameCapture::Collect(uint32_t frame) {
+    if (slots.empty()) {
+        return;
+    }
+
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (uint32_t i = 0; i < slots.size(); i++) {
+            Slot& slot = slots[i];
+            if (slot.state != SlotState::Recorded || slot.frame != frame) {
+                continue;
+            }
+
+            if (!coherent) {
+                VkMappedMemoryRange range{};
+                range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+                range.memory = slot.memory;
+                range.size = VK_WHOLE_SIZE;
+                vkInvalidateMappedMemoryRanges(device, 1, &range);
+            }
+            slot.state = SlotState::Encoding;
+            queue.push_back(i);
+            queued = true;
+        }
+    }
+    if (queued) {
+        wake.notify_one();
+    }
+}
+
+CaptureStats FrameCapture::Stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void FrameCapture::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+
+        uint32_t index = queue.front();
+        queue.pop_front();
+
+        // Encoding state keeps the main thread off the slot while unlocked.
+        lock.unlock();
+        auto encodeStart = std::chrono::steady_clock::now();
+        Write(slots[index]);
+        double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - encodeStart).count();
+        lock.lock();
+
+        slots[index].state = SlotState::Free;
+        stats.saved++;
+        stats.encodeMs = encodeMs;
+    }
+}
+
+void FrameCapture::Write(const Slot& slot) {
+    const uint8_t* pixels = static_cast<const uint8_t*>(slot.mapped);
+    size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+    bool bgr = IsBgr(format);
+
+    char name[64];
+    std::vector<uint8_t> file;
+    if (fileFormat == VkCapture::FileFormat::Png) {
+        std::vector<uint8_t> rgb(pixelCount * 3);
+        for (size_t i = 0; i < pixelCount; i++) {
+            rgb[i * 3 + 0] = pixels[i * 4 + (bgr ? 2 : 0)];
+            rgb[i * 3 + 1] = pixels[i * 4 + 1];
+            rgb[i * 3 + 2] = pixels[i * 4 + (bgr ? 0 : 2)];
+        }
+        file = VkCapture::EncodePng(extent.width, extent.height, rgb.data());
+        snprintf(name, sizeof(name), "frame_%06llu.png", static_cast<unsigned long long>(slot.frameNumber));
+    }
+    else {
+        file.assign(pixels, pixels + pixelCount * 4);
+        if (bgr) {
+            for (size_t i = 0; i < pixelCount; i++) {
+                std::swap(file[i * 4 + 0], file[i * 4 + 2]);
+            }
+        }
+        snprintf(name, sizeof(name), "frame_%06llu_%ux%u.rgba", static_cast<unsigned long long>(slot.frameNumber), extent.width, extent.height);
+    }
+
+    std::ofstream out(std::filesystem::path(directory) / name, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+}
+
+void VkMain::CreateCapture() {
+    VkCapture::FileFormat fileFormat = VkCapture::FileFormat::Png;
+    std::string formatName = VkUtils::GetEnvString("VK3D_CAPTURE_FORMAT");
+    if (formatName == "raw") {
+        fileFormat = VkCapture::FileFormat::Raw;
+    }
+    else if (!formatName.empty() && formatName != "png") {
+        std::cout << "Unknown VK3D_CAPTURE_FORMAT " << formatName << ", writing png" << std::endl;
+    }
+
+    frameCapture.Init(
+        device,
+        physicalDevice,
+        swapChainImageFormat,
+        swapChainExtent,
+        MAX_FRAMES_IN_FLIGHT,
+        captureDirectory,
+        fileFormat,
+        VkUtils::GetEnvUint("VK3D_CAPTURE_EVERY", 1)
+    );
+}
+
+// Graph pass after the forward pass; the graph moves the backbuffer to
+// TRANSFER_SRC and makes the copy visible to the host.
+void VkMain::RecordCapture(VkCommandBuffer commandBuffer) {
+    if (captureThisFrame) {
+        frameCapture.RecordCopy(commandBuffer, frameGraph.Image(backbufferResource));
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// saved counts files written so far; dropped counts due frames skipped
+// because every readback slot was still waiting or encoding.
+struct CaptureStats {
+    uint32_t saved = 0;
+    uint32_t dropped = 0;
+    double encodeMs = 0.0;
+};
+
+namespace VkCapture {
+    enum class FileFormat {
+        Png,
+        // Tightly packed RGBA8 rows, size in the file name.
+        Raw,
+    };
+
+    // Readback slots beyond one per frame in flight, so the encoder can lag
+    // a frame or two before captures are dropped.
+    constexpr uint32_t EXTRA_SLOTS = 2;
+
+    // 8-bit RGBA/BGRA swapchain formats; anything else is not captured.
+    bool SupportsFormat(VkFormat format);
+
+    // 8-bit RGB PNG from tightly packed RGB rows. The image data goes into
+    // stored (uncompressed) deflate blocks, so encoding is about one pass
+    // over the pixels and needs no zlib.
+    std::vector<uint8_t> EncodePng(uint32_t width, uint32_t height, const uint8_t* rgb);
+}
+
+// Copies presented frames into a ring of host-visible buffers and writes
+// them to disk without stalling the frame. A copy recorded for frame F is
+// collected once F's fence has signaled, frames in flight later, and a
+// worker thread converts, encodes and writes it; the slot is reused after
+// that. When no slot is free the frame is simply not captured.
+class FrameCapture {
+public:
+    void Init
+    (
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        VkFormat format,
+        VkExtent2D extent,
+        uint32_t framesInFlight,
+        const std::string& directory,
+        VkCapture::FileFormat fileFormat,
+        uint32_t interval
+    );
+    // Finishes the files already queued, then releases the slots. The
+    // device must be idle.
+    void Destroy();
+
+    // Whether frameNumber is captured; if so a slot is reserved for it and
+    // Buffer() names its readback buffer.
+    bool Begin(uint64_t frameNumber, uint32_t frame);
+    // Some slot's buffer even when nothing is captured, so the render graph
+    // always has a handle.
+    VkBuffer Buffer() const;
+    // image must be in TRANSFER_SRC_OPTIMAL layout.
+    void RecordCopy(VkCommandBuffer commandBuffer, VkImage image);
+    // Call once frame's fence has signaled.
+    void Collect(uint32_t frame);
+
+    bool Active() const { return !slots.empty(); }
+    CaptureStats Stats();
+
+private:
+    enum class SlotState {
+        Free,
+        Recorded,
+        Encoding,
+    };
+
+    struct Slot {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        SlotState state = SlotState::Free;
+        uint32_t frame = 0;
+        uint64_t frameNumber = 0;
+    };
+
+    void WorkerLoop();
+    void Write(const Slot& slot);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    std::string directory;
+    VkCapture::FileFormat fileFormat = VkCapture::FileFormat::Png;
+    uint32_t interval = 1;
+    bool coherent = true;
+    VkDeviceSize slotSize = 0;
+
+    std::vector<Slot> slots;
+    uint32_t nextSlot = 0;
+    uint32_t currentSlot = 0;
+
+    // Guards slot states, the queue, stats and stopping.
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<uint32_t> queue;
+    bool stopping = false;
+    std::thread worker;
+    CaptureStats stats;
+};
@@ -0,0 +1,189 @@
+#include "VulkanMain/Compute/Compute.h"
+#include "VulkanMain/Utils/Utils.h"
+#include "VulkanMain/Startup/Startup.h"
+
+#include <stdexcept>
+
+std::vector<VkDescriptorSetLayoutBinding> VkCompute::StorageBufferBindings(uint32_t count, VkShaderStageFlags extraStages) {
+    std::vector<VkDescriptorSetLayoutBinding> bindings(count);
+    for (uint32_t i = 0; i < count; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | extraStages;
+    }
+    return bindings;
+}
+
+ComputePipeline VkCompute::CreatePipeline
+(
+    VkDevice device,
+    DescriptorLayoutCache& layouts,
+    const std::string& shaderPath,
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+    uint32_t pushConstantSize,
+    uint32_t localSizeX
+) {
+    ComputePipeline result;
+    result.pushConstantSize = pushConstantSize;
+    result.localSizeX = localSizeX;
+    result.setLayout = layouts.Get(bindings);
+    result.updateTemplate = VkDescriptors::CreateUpdateTemplate(device, result.setLayout, bindings);
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = pushConstantSize;
+
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &result.setLayout;
+    layoutInfo.pushConstantRangeCount = pushConstantSize > 0 ? 1 : 0;
+    layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &layoutInfo, nullptr, &result.layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline layout!");
+    }
+
+    auto shaderCode = VkStartup::ReadShader(shaderPath);
+    VkShaderModule shaderModule = VkUtils::CreateShaderModule(device, shaderCode);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = shaderModule;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = result.layout;
+
+    VkResult created = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &result.pipeline);
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+    if (created != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute pipeline!");
+    }
+
+    return result;
+}
+
+void VkCompute::DestroyPipeline(VkDevice device, ComputePipeline& pipeline) {
+    vkDestroyPipeline(device, pipeline.pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipeline.layout, nullptr);
+    vkDestroyDescriptorUpdateTemplate(device, pipeline.updateTemplate, nullptr);
+    pipeline = ComputePipeline{};
+}
+
+void VkCompute::WriteSet(VkDevice device, const ComputePipeline& pipeline, VkDescriptorSet set, const DescriptorInfo* descriptors) {
+    vkUpdateDescriptorSetWithTemplate(device, set, pipeline.updateTemplate, descriptors);
+}
+
+void VkCompute::Dispatch(VkCommandBuffer commandBuffer, const ComputePipeline& pipeline, VkDescriptorSet set, const void* pushConstants, uint32_t itemCount) {
+    uint32_t groups = (itemCount + pipeline.localSizeX - 1) / pipeline.localSizeX;
+    DispatchGroups(commandBuffer, pipeline, set, pushConstants, groups, 1, 1);
+}
+
+void VkCompute::DispatchGroups(VkCommandBuffer commandBuffer, const ComputePipeline& pipeline, VkDescriptorSet set, const void* pushConstants, uint32_t x, uint32_t y, uint32_t z) {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.pipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.layout, 0, 1, &set, 0, nullptr);
+    if (pipeline.pushConstantSize > 0) {
+        vkCmdPushConstants(commandBuffer, pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pipeline.pushConstantSize, pushConstants);
+    }
+    vkCmdDispatch(commandBuffer, x, y, z);
+}
+
+void VkCompute::Barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void AsyncComputeQueue::Init(VkDevice vkDevice, uint32_t queueFamily, VkQueue vkQueue, uint32_t framesInFlight) {
+    device = vkDevice;
+    family = queueFamily;
+    queue = vkQueue;
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = family;
+
+    if (vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute command pool!");
+    }
+
+    commandBuffers.resize(framesInFlight);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = framesInFlight;
+
+    if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate compute command buffers!");
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    semaphores.resize(framesInFlight);
+    for (VkSemaphore& semaphore : semaphores) {
+        if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute semaphore!");
+        }
+    }
+    recording.assign(framesInFlight, false);
+}
+
+void AsyncComputeQueue::Destroy() {
+    if (queue == VK_NULL_HANDLE) {
+        return;
+    }
+
+    for (VkSemaphore semaphore : semaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    vkDestroyCommandPool(device, commandPool, nullptr);
+
+    *this = AsyncComputeQueue{};
+}
+
+VkCommandBuffer AsyncComputeQueue::Begin(uint32_t frame) {
+    VkCommandBuffer commandBuffer = commandBuffers[frame];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording compute command buffer!");
+    }
+    recording[frame] = true;
+    return commandBuffer;
+}
+
+VkSemaphore AsyncComputeQueue::Submit(uint32_t frame) {
+    if (!recording[frame]) {
+        return VK_NULL_HANDLE;
+    }
+    recording[frame] = false;
+
+    if (vkEndCommandBuffer(commandBuffers[frame]) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record compute command buffer!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffers[frame];
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &semaphores[frame];
+
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit compute command buffer!");
+    }
+    return semaphores[frame];
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "VulkanMain/Descriptors/Descriptors.h"
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A compute shader with everything needed to dispatch it: one descriptor
+// set layout (owned by the DescriptorLayoutCache it came from), an update
+// template for that layout, and push constants of pushConstantSize bytes.
+struct ComputePipeline {
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorUpdateTemplate updateTemplate = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    uint32_t pushConstantSize = 0;
+    // Must match local_size_x in the shader; Dispatch() rounds up to it.
+    uint32_t localSizeX = 1;
+};
+
+namespace VkCompute {
+    // count storage buffers at bindings 0..count-1, visible to compute and
+    // to extraStages (e.g. a vertex shader reading what compute wrote).
+    std::vector<VkDescriptorSetLayoutBinding> StorageBufferBindings(uint32_t count, VkShaderStageFlags extraStages = 0);
+
+    ComputePipeline CreatePipeline
+    (
+        VkDevice device,
+        DescriptorLayoutCache& layouts,
+        const std::string& shaderPath,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+        uint32_t pushConstantSize,
+        uint32_t localSizeX
+    );
+    void DestroyPipeline(VkDevice device, ComputePipeline& pipeline);
+
+    // descriptors holds one DescriptorInfo per descriptor, in binding order.
+    void WriteSet(VkDevice device, const ComputePipeline& pipeline, VkDescriptorSet set, const DescriptorInfo* descriptors);
+
+    // One invocation per item, in ceil(itemCount / localSizeX) workgroups.
+    void Dispatch(VkCommandBuffer commandBuffer, const ComputePipeline& pipeline, VkDescriptorSet set, const void* pushConstants, uint32_t itemCount);
+    void DispatchGroups(VkCommandBuffer commandBuffer, const ComputePipeline& pipeline, VkDescriptorSet set, const void* pushConstants, uint32_t x, uint32_t y, uint32_t z);
+
+    // Global memory barrier within one queue, for work recorded outside the
+    // render graph.
+    void Barrier(VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+}
+
+// Compute work submitted to a dedicated compute queue family, overlapping
+// with the graphics queue. Each frame in flight has a command buffer and a
+// semaphore; the graphics submit that consumes the results waits on the
+// semaphore, so once that frame's fence has signaled the command buffer can
+// be recorded again.
+//
+// Resources touched by both queues are created with
+// VK_SHARING_MODE_CONCURRENT, so no ownership transfers are needed; the
+// semaphore wait orders and makes visible everything the compute submit
+// wrote.
+class AsyncComputeQueue {
+public:
+    void Init(VkDevice device, uint32_t family, VkQueue queue, uint32_t framesInFlight);
+    void Destroy();
+
+    // Resets and begins frame's command buffer.
+    VkCommandBuffer Begin(uint32_t frame);
+    // Ends and submits frame's command buffer if Begin() was called for it,
+    // and returns the semaphore it signals, or VK_NULL_HANDLE if nothing
+    // was recorded.
+    VkSemaphore Submit(uint32_t frame);
+
+    bool Active() const { return queue != VK_NULL_HANDLE; }
+    uint32_t Family() const { return family; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t family = 0;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkSemaphore> semaphores;
+    std::vector<bool> recording;
+};
@@ -0,0 +1,177 @@
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/Jobs/Jobs.h"
+#include "VulkanMain/Simd/Simd.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Frustum VkCulling::ExtractFrustum(const glm::mat4& viewProj) {
+    auto row = [&](int r) {
+        return glm::vec4(viewProj[0][r], viewProj[1][r], viewProj[2][r], viewProj[3][r]);
+    };
+
+    Frustum frustum{};
+    frustum.planes[0] = row(3) + row(0);
+    frustum.planes[1] = row(3) - row(0);
+    frustum.planes[2] = row(3) + row(1);
+    frustum.planes[3] = row(3) - row(1);
+    frustum.planes[4] = row(2);
+    frustum.planes[5] = row(3) - row(2);
+
+    for (auto& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+        plane = plane / length;
+    }
+
+    return frustum;
+}
+
+bool VkCulling::IsVisible(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extents, float radius) {
+    for (const auto& plane : frustum.planes) {
+        glm::vec3 normal(plane.x, plane.y, plane.z);
+        float distance = glm::dot(normal, center) + plane.w;
+        float boxRadius = glm::dot(glm::abs(normal), extents);
+
+        if (distance < -std::min(radius, boxRadius)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CullingSystem::Resize(size_t count) {
+    for (auto* stream : { &localCenterX, &localCenterY, &localCenterZ, &localExtentX, &localExtentY, &localExtentZ, &localRadius,
+                          &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius }) {
+        stream->resize(count, 0.0f);
+    }
+}
+
+void CullingSystem::SetLocalBounds(uint32_t index, const MeshBounds& bounds) {
+    glm::vec3 center = bounds.box.Center();
+    glm::vec3 extents = bounds.box.Extents();
+
+    localCenterX[index] = center.x;
+    localCenterY[index] = center.y;
+    localCenterZ[index] = center.z;
+    localExtentX[index] = extents.x;
+    localExtentY[index] = extents.y;
+    localExtentZ[index] = extents.z;
+    localRadius[index] = bounds.sphere.radius;
+}
+
+void CullingSystem::UpdateWorldBound(size_t i, const glm::mat4& m) {
+    glm::vec4 c = m * glm::vec4(localCenterX[i], localCenterY[i], localCenterZ[i], 1.0f);
+    centerX[i] = c.x;
+    centerY[i] = c.y;
+    centerZ[i] = c.z;
+
+    // Arvo: the world extent on each axis is the local extents
+    // projected through the absolute rotation/scale part.
+    float ex = localExtentX[i], ey = localExtentY[i], ez = localExtentZ[i];
+    extentX[i] = std::fabs(m[0][0]) * ex + std::fabs(m[1][0]) * ey + std::fabs(m[2][0]) * ez;
+    extentY[i] = std::fabs(m[0][1]) * ex + std::fabs(m[1][1]) * ey + std::fabs(m[2][1]) * ez;
+    extentZ[i] = std::fabs(m[0][2]) * ex + std::fabs(m[1][2]) * ey + std::fabs(m[2][2]) * ez;
+
+    float scale = std::max({
+        glm::length(glm::vec3(m[0])),
+        glm::length(glm::vec3(m[1])),
+        glm::length(glm::vec3(m[2]))
+    });
+    radius[i] = localRadius[i] * scale;
+}
+
+void CullingSystem::UpdateWorldBounds(const std::vector<glm::mat4>& world) {
+    VkJobs::ParallelFor(Size(), CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            UpdateWorldBound(i, world[i]);
+        }
+    });
+}
+
+void CullingSystem::UpdateWorldBounds(const std::vector<glm::mat4>& world, const std::vector<uint32_t>& changed) {
+    VkJobs::ParallelFor(changed.size(), CHUNK_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            UpdateWorldBound(changed[i], world[changed[i]]);
+        }
+    });
+}
+
+void CullingSystem::CullRange(const Frustum& frustum, size_t begin, size_t end, std::vector<uint32_t>& out) const {
+    size_t i = begin;
+
+#if defined(VK3D_SIMD)
+    using L = VkSimd::Lanes;
+
+    L::Reg px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+    for (int p = 0; p < 6; p++) {
+        const glm::vec4& plane = frustum.planes[p];
+        px[p] = L::Set(plane.x);
+        py[p] = L::Set(plane.y);
+        pz[p] = L::Set(plane.z);
+        pw[p] = L::Set(plane.w);
+        ax[p] = L::Set(std::fabs(plane.x));
+        ay[p] = L::Set(std::fabs(plane.y));
+        az[p] = L::Set(std::fabs(plane.z));
+    }
+
+    for (; i + L::WIDTH <= end; i += L::WIDTH) {
+        L::Reg cx = L::Load(&centerX[i]), cy = L::Load(&centerY[i]), cz = L::Load(&centerZ[i]);
+        L::Reg ex = L::Load(&extentX[i]), ey = L::Load(&extentY[i]), ez = L::Load(&extentZ[i]);
+        L::Reg r = L::Load(&radius[i]);
+
+        L::Reg inside = L::AllTrue();
+        for (int p = 0; p < 6; p++) {
+            L::Reg distance = L::Add(L::Add(L::Add(L::Mul(px[p], cx), L::Mul(py[p], cy)), L::Mul(pz[p], cz)), pw[p]);
+            L::Reg boxRadius = L::Add(L::Add(L::Mul(ax[p], ex), L::Mul(ay[p], ey)), L::Mul(az[p], ez));
+            L::Reg reach = L::Min(r, boxRadius);
+            inside = L::And(inside, L::GreaterEqual(L::Add(distance, reach), L::Set(0.0f)));
+        }
+
+        uint32_t mask = L::Mask(inside);
+        while (mask != 0) {
+            uint32_t lane = 0;
+            while (((mask >> lane) & 1u) == 0) {
+                lane++;
+            }
+            out.push_back(static_cast<uint32_t>(i + lane));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for (; i < end; i++) {
+        glm::vec3 center(centerX[i], centerY[i], centerZ[i]);
+        glm::vec3 extents(extentX[i], extentY[i], extentZ[i]);
+        if (VkCulling::IsVisible(frustum, center, extents, radius[i])) {
+            out.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+CullStats CullingSystem::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) {
+    auto start = std::chrono::steady_clock::now();
+
+    size_t chunkCount = (Size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkVisible.resize(chunkCount);
+
+    VkJobs::ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; chunk++) {
+            chunkVisible[chunk].clear();
+            size_t begin = chunk * CHUNK_SIZE;
+            CullRange(frustum, begin, std::min(Size(), begin + CHUNK_SIZE), chunkVisible[chunk]);
+        }
+    });
+
+    visible.clear();
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+        visible.insert(visible.end(), chunkVisible[chunk].begin(), chunkVisible[chunk].end());
+    }
+
+    CullStats stats;
+    stats.tested = static_cast<uint32_t>(Size());
+    stats.visible = static_cast<uint32_t>(visible.size());
+    stats.culled = stats.tested - stats.visible;
+    stats.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "VulkanMain/Mesh/Mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Normalized planes with normals pointing into the frustum:
+// left, right, bottom, top, near, far.
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+struct CullStats {
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t culled = 0;
+    double cpuMs = 0.0;
+    // GPU occlusion culling only: objects in the frustum the Hi-Z test hid
+    // and the triangles they would have drawn, and draws of the late phase
+    // for objects that came into view. occlusionGpuMs is what the pyramid
+    // and the late phase cost; negative without timestamps.
+    bool occlusion = false;
+    uint32_t occluded = 0;
+    uint64_t occludedTriangles = 0;
+    uint32_t lateDraws = 0;
+    double occlusionGpuMs = -1.0;
+};
+
+// World-space bounds of every object in SoA form, tested against the camera
+// frustum several objects per instruction.
+class CullingSystem {
+public:
+    void Resize(size_t count);
+    size_t Size() const { return localRadius.size(); }
+
+    void SetLocalBounds(uint32_t index, const MeshBounds& bounds);
+
+    // Moves every object's bounds into world space. world must have Size() entries.
+    void UpdateWorldBounds(const std::vector<glm::mat4>& world);
+
+    // Same for the listed objects only, e.g. SceneGraph::Changed().
+    void UpdateWorldBounds(const std::vector<glm::mat4>& world, const std::vector<uint32_t>& changed);
+
+    // Fills visible with the indices of the objects that intersect the frustum,
+    // in ascending order.
+    CullStats Cull(const Frustum& frustum, std::vector<uint32_t>& visible);
+
+    // Objects handed to a single job; a multiple of every SIMD width.
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+private:
+    void UpdateWorldBound(size_t i, const glm::mat4& m);
+    void CullRange(const Frustum& frustum, size_t begin, size_t end, std::vector<uint32_t>& out) const;
+
+    std::vector<float> localCenterX, localCenterY, localCenterZ;
+    std::vector<float> localExtentX, localExtentY, localExtentZ;
+    std::vector<float> localRadius;
+
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+    std::vector<std::vector<uint32_t>> chunkVisible;
+};
+
+namespace VkCulling {
+    // Planes of the Vulkan clip volume (-w <= x, y <= w, 0 <= z <= w).
+    Frustum ExtractFrustum(const glm::mat4& viewProj);
+
+    // Scalar reference for one object, used for the tails of SIMD batches.
+    bool IsVisible(const Frustum& frustum, const glm::vec3& center, const glm::vec3& extents, float radius);
+}
@@ -0,0 +1,74 @@
+#include "VulkanMain/Depth/Depth.h"
+#include "VulkanMain/Main/Main.h"
+
+#include <stdexcept>
+
+VkFormat VkDepth::FindDepthFormat(VkPhysicalDevice physicalDevice) {
+    const VkFormat candidates[] = {
+        VK_FORMAT_D32_SFLOAT,
+        VK_FORMAT_D32_SFLOAT_S8_UINT,
+        VK_FORMAT_D24_UNORM_S8_UINT
+    };
+
+    for (VkFormat format : candidates) {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+        if (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("failed to find supported depth format!");
+}
+
+// Same draws as the forward pass through the depth-only pipelines, front to
+// back as the draw list is sorted, so the forward pass shades each pixel once.
+// The late pass of occlusion culling follows compute work, so it rebinds.
+void VkMain::RecordDepthPrepass(VkCommandBuffer commandBuffer, DrawPhase phase) {
+    SetFrameViewport(commandBuffer);
+    if (phase == DrawPhase::Late) {
+        drawState.Invalidate();
+    }
+    else {
+        drawState.Begin(commandBuffer);
+    }
+    RecordDraws(commandBuffer, true, phase);
+}
+
+void VkMain::CreateFragmentQueries() {
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    queryPoolInfo.queryCount = 2 * MAX_FRAMES_IN_FLIGHT;
+    queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    if (vkCreateQueryPool(device, &queryPoolInfo, nullptr, &fragmentQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create fragment statistics query pool!");
+    }
+}
+
+// Called once the frame's fence has signaled, so the result is available
+// without waiting.
+void VkMain::ReadFragmentQueries(uint32_t frame) {
+    frameStats.depth.prepass = depthPrepass;
+    if (fragmentQueryPool == VK_NULL_HANDLE || frameStats.frame < static_cast<uint64_t>(MAX_FRAMES_IN_FLIGHT)) {
+        return;
+    }
+
+    // The late forward pass only exists with occlusion culling and no
+    // pre-pass; an unused query would never become available.
+    uint32_t queries = occlusionCulling && !depthPrepass ? 2 : 1;
+    uint64_t fragments[2] = {};
+    VkResult result = vkGetQueryPoolResults(device, fragmentQueryPool, frame * 2, queries, sizeof(fragments), fragments, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
+
+    frameStats.depth.fragments = fragments[0] + fragments[1];
+    frameStats.depth.pixels = static_cast<uint64_t>(swapChainExtent.width) * swapChainExtent.height;
+}
+
+void VkMain::DestroyFragmentQueries() {
+    vkDestroyQueryPool(device, fragmentQueryPool, nullptr);
+    fragmentQueryPool = VK_NULL_HANDLE;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstdint>
+
+// Fragment shader invocations of the forward pass, from a pipeline
+// statistics query. fragments / pixels is the overdraw the depth pre-pass
+// is meant to bring down to 1; pixels stays 0 until a query result is in.
+struct DepthStats {
+    bool prepass = false;
+    uint64_t fragments = 0;
+    uint64_t pixels = 0;
+};
+
+namespace VkDepth {
+    // The first of D32, D32S8 and D24S8 the device can render depth to.
+    VkFormat FindDepthFormat(VkPhysicalDevice physicalDevice);
+}
@@ -0,0 +1,196 @@
+#include "VulkanMain/Descriptors/Descriptors.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <stdexcept>
+
+VkDescriptorUpdateTemplate VkDescriptors::CreateUpdateTemplate
+(
+    VkDevice device,
+    VkDescriptorSetLayout layout,
+    const std::vector<VkDescriptorSetLayoutBinding>& bindings
+)
+{
+    std::vector<VkDescriptorUpdateTemplateEntry> entries(bindings.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < bindings.size(); i++) {
+        entries[i].dstBinding = bindings[i].binding;
+        entries[i].dstArrayElement = 0;
+        entries[i].descriptorCount = bindings[i].descriptorCount;
+        entries[i].descriptorType = bindings[i].descriptorType;
+        entries[i].offset = offset;
+        entries[i].stride = sizeof(DescriptorInfo);
+        offset += sizeof(DescriptorInfo) * bindings[i].descriptorCount;
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+    createInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+    createInfo.pDescriptorUpdateEntries = entries.data();
+    createInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    createInfo.descriptorSetLayout = layout;
+
+    VkDescriptorUpdateTemplate updateTemplate;
+    if (vkCreateDescriptorUpdateTemplate(device, &createInfo, nullptr, &updateTemplate) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor update template!");
+    }
+    return updateTemplate;
+}
+
+void DescriptorLayoutCache::Init(VkDevice vkDevice) {
+    device = vkDevice;
+}
+
+void DescriptorLayoutCache::Destroy() {
+    for (auto& entry : layouts) {
+        vkDestroyDescriptorSetLayout(device, entry.second, nullptr);
+    }
+    layouts.clear();
+}
+
+VkDescriptorSetLayout DescriptorLayoutCache::Get(const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+    assert(device != VK_NULL_HANDLE);
+
+    // Binding order does not change the layout, so it is not part of the key.
+    std::vector<VkDescriptorSetLayoutBinding> key = bindings;
+    std::sort(key.begin(), key.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+        return a.binding < b.binding;
+    });
+
+    auto found = layouts.find(key);
+    if (found != layouts.end()) {
+        return found->second;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(key.size());
+    layoutInfo.pBindings = key.data();
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+
+    layouts.emplace(std::move(key), layout);
+    return layout;
+}
+
+size_t DescriptorLayoutCache::KeyHash::operator()(const std::vector<VkDescriptorSetLayoutBinding>& bindings) const {
+    size_t hash = std::hash<size_t>()(bindings.size());
+    for (const auto& b : bindings) {
+        // binding, type, count and stages packed into one 64-bit value
+        uint64_t packed = uint64_t(b.binding) | uint64_t(b.descriptorType) << 8 | uint64_t(b.descriptorCount) << 16 | uint64_t(b.stageFlags) << 32;
+        hash ^= std::hash<uint64_t>()(packed) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+bool DescriptorLayoutCache::KeyEqual::operator()(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b) const {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].binding != b[i].binding || a[i].descriptorType != b[i].descriptorType ||
+            a[i].descriptorCount != b[i].descriptorCount || a[i].stageFlags != b[i].stageFlags ||
+            a[i].pImmutableSamplers != b[i].pImmutableSamplers) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DescriptorAllocator::Init(VkDevice vkDevice, uint32_t initialSets, const std::vector<PoolRatio>& poolRatios) {
+    device = vkDevice;
+    ratios = poolRatios;
+    setsPerPool = std::max(1u, initialSets);
+    current = CreatePool(setsPerPool);
+}
+
+void DescriptorAllocator::Destroy() {
+    for (VkDescriptorPool pool : fullPools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    for (VkDescriptorPool pool : readyPools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    if (current != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, current, nullptr);
+    }
+
+    fullPools.clear();
+    readyPools.clear();
+    current = VK_NULL_HANDLE;
+    allocatedSets = 0;
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout) {
+    assert(current != VK_NULL_HANDLE);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = current;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+
+    // A full pool stays full until Reset(); move on to the next one.
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        fullPools.push_back(current);
+        current = NextPool();
+        allocInfo.descriptorPool = current;
+        result = vkAllocateDescriptorSets(device, &allocInfo, &set);
+    }
+
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate descriptor set!");
+    }
+
+    allocatedSets++;
+    return set;
+}
+
+void DescriptorAllocator::Reset() {
+    for (VkDescriptorPool pool : fullPools) {
+        vkResetDescriptorPool(device, pool, 0);
+        readyPools.push_back(pool);
+    }
+    fullPools.clear();
+
+    vkResetDescriptorPool(device, current, 0);
+    allocatedSets = 0;
+}
+
+VkDescriptorPool DescriptorAllocator::NextPool() {
+    if (!readyPools.empty()) {
+        VkDescriptorPool pool = readyPools.back();
+        readyPools.pop_back();
+        return pool;
+    }
+
+    setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+    return CreatePool(setsPerPool);
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto& ratio : ratios) {
+        uint32_t count = static_cast<uint32_t>(ratio.perSet * static_cast<float>(setCount));
+        poolSizes.push_back({ ratio.type, std::max(1u, count) });
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = setCount;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+    return pool;
+}
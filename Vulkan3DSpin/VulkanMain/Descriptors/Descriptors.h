@@ -0,0 +1,93 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// One descriptor as read by a VkDescriptorUpdateTemplate made with
+// VkDescriptors::CreateUpdateTemplate. Buffer and image infos share one
+// stride, so a set's descriptors are a plain array of these.
+union DescriptorInfo {
+    VkDescriptorBufferInfo buffer;
+    VkDescriptorImageInfo image;
+
+    DescriptorInfo() : buffer{} {}
+    DescriptorInfo(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE) : buffer{ buffer, offset, range } {}
+    DescriptorInfo(VkSampler sampler, VkImageView view, VkImageLayout layout) : image{ sampler, view, layout } {}
+};
+
+namespace VkDescriptors {
+    // Template that writes every binding of layout from consecutive
+    // DescriptorInfo records: descriptorCount records per binding, in the
+    // order of bindings. Pass the data to vkUpdateDescriptorSetWithTemplate.
+    VkDescriptorUpdateTemplate CreateUpdateTemplate
+    (
+        VkDevice device,
+        VkDescriptorSetLayout layout,
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings
+    );
+}
+
+// Hands out one VkDescriptorSetLayout per distinct binding list, so modules
+// that describe the same interface share a layout. Layouts that need a pNext
+// chain (binding flags) are not cached.
+class DescriptorLayoutCache {
+public:
+    void Init(VkDevice device);
+    void Destroy();
+
+    VkDescriptorSetLayout Get(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+    size_t Size() const { return layouts.size(); }
+
+private:
+    struct KeyHash {
+        size_t operator()(const std::vector<VkDescriptorSetLayoutBinding>& bindings) const;
+    };
+    struct KeyEqual {
+        bool operator()(const std::vector<VkDescriptorSetLayoutBinding>& a, const std::vector<VkDescriptorSetLayoutBinding>& b) const;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::unordered_map<std::vector<VkDescriptorSetLayoutBinding>, VkDescriptorSetLayout, KeyHash, KeyEqual> layouts;
+};
+
+// Descriptor sets from a growing list of pools. When the current pool runs
+// out, the next one is taken from the reset pools or created with twice the
+// capacity, so allocation never fails for lack of pool space. Sets are not
+// freed one by one; Reset() recycles every pool at once, which suits
+// allocators owned by one frame in flight.
+class DescriptorAllocator {
+public:
+    // Descriptors of each type per set in a pool, e.g. 2 storage buffers.
+    struct PoolRatio {
+        VkDescriptorType type;
+        float perSet;
+    };
+
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    void Init(VkDevice device, uint32_t initialSets, const std::vector<PoolRatio>& ratios);
+    void Destroy();
+
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+    void Reset();
+
+    size_t PoolCount() const { return fullPools.size() + readyPools.size() + (current != VK_NULL_HANDLE ? 1 : 0); }
+    uint32_t AllocatedSets() const { return allocatedSets; }
+
+private:
+    VkDescriptorPool NextPool();
+    VkDescriptorPool CreatePool(uint32_t setCount);
+
+    VkDevice device = VK_NULL_HANDLE;
+    std::vector<PoolRatio> ratios;
+    uint32_t setsPerPool = 0;
+    uint32_t allocatedSets = 0;
+
+    VkDescriptorPool current = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> fullPools;
+    std::vector<VkDescriptorPool> readyPools;
+};
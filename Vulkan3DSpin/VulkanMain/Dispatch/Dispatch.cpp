@@ -0,0 +1,93 @@
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#define VK_DISPATCH_DEFINE(name) PFN_##name name = nullptr;
+PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = nullptr;
+VK_DISPATCH_GLOBAL(VK_DISPATCH_DEFINE)
+VK_DISPATCH_INSTANCE(VK_DISPATCH_DEFINE)
+VK_DISPATCH_DEVICE(VK_DISPATCH_DEFINE)
+#undef VK_DISPATCH_DEFINE
+
+namespace {
+    // The loader stays open until the process exits.
+    PFN_vkGetInstanceProcAddr loaderGetInstanceProcAddr = nullptr;
+
+    // Device-level entry points as LoadInstance found them; the fallback
+    // for anything vkGetDeviceProcAddr does not return.
+    DeviceDispatch trampolines;
+
+    PFN_vkGetInstanceProcAddr OpenLoader() {
+#if defined(_WIN32)
+        HMODULE library = LoadLibraryA("vulkan-1.dll");
+        if (library == nullptr) {
+            return nullptr;
+        }
+        return reinterpret_cast<PFN_vkGetInstanceProcAddr>(reinterpret_cast<void (*)()>(GetProcAddress(library, "vkGetInstanceProcAddr")));
+#else
+#if defined(__APPLE__)
+        const char* names[] = { "libvulkan.1.dylib", "libvulkan.dylib" };
+#else
+        const char* names[] = { "libvulkan.so.1", "libvulkan.so" };
+#endif
+        for (const char* name : names) {
+            if (void* library = dlopen(name, RTLD_NOW | RTLD_LOCAL)) {
+                return reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(library, "vkGetInstanceProcAddr"));
+            }
+        }
+        return nullptr;
+#endif
+    }
+}
+
+bool VkDispatch::LoadLoader() {
+    if (loaderGetInstanceProcAddr == nullptr) {
+        loaderGetInstanceProcAddr = OpenLoader();
+        if (loaderGetInstanceProcAddr == nullptr) {
+            return false;
+        }
+    }
+    Load(loaderGetInstanceProcAddr);
+    return true;
+}
+
+void VkDispatch::Load(PFN_vkGetInstanceProcAddr getInstanceProcAddr) {
+    vkGetInstanceProcAddr = getInstanceProcAddr;
+
+#define VK_DISPATCH_LOAD(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(VK_NULL_HANDLE, #name));
+    VK_DISPATCH_GLOBAL(VK_DISPATCH_LOAD)
+#undef VK_DISPATCH_LOAD
+}
+
+void VkDispatch::LoadInstance(VkInstance instance) {
+#define VK_DISPATCH_LOAD(name) name = reinterpret_cast<PFN_##name>(vkGetInstanceProcAddr(instance, #name));
+    VK_DISPATCH_INSTANCE(VK_DISPATCH_LOAD)
+    VK_DISPATCH_DEVICE(VK_DISPATCH_LOAD)
+#undef VK_DISPATCH_LOAD
+
+#define VK_DISPATCH_SAVE(name) trampolines.name = name;
+    VK_DISPATCH_DEVICE(VK_DISPATCH_SAVE)
+#undef VK_DISPATCH_SAVE
+}
+
+void VkDispatch::LoadDevice(VkDevice device, DeviceDispatch& table) {
+#define VK_DISPATCH_LOAD(name) \
+    table.name = reinterpret_cast<PFN_##name>(vkGetDeviceProcAddr(device, #name)); \
+    if (table.name == nullptr) { \
+        table.name = trampolines.name; \
+    }
+    VK_DISPATCH_DEVICE(VK_DISPATCH_LOAD)
+#undef VK_DISPATCH_LOAD
+}
+
+void VkDispatch::Use(const DeviceDispatch& table) {
+#define VK_DISPATCH_USE(name) name = table.name;
+    VK_DISPATCH_DEVICE(VK_DISPATCH_USE)
+#undef VK_DISPATCH_USE
+}
@@ -0,0 +1,162 @@
+#pragma once
+// Every Vulkan entry point the engine calls is a function pointer of the
+// same name, so call sites read as plain Vulkan but can be pointed at the
+// system loader or at the null backend (see Null.h). Include this instead of
+// <vulkan/vulkan.h>; the loader library is opened at run time, not linked.
+#ifndef VK_NO_PROTOTYPES
+#define VK_NO_PROTOTYPES
+#endif
+#include <vulkan/vulkan.h>
+
+// Loaded with vkGetInstanceProcAddr(VK_NULL_HANDLE, ...).
+#define VK_DISPATCH_GLOBAL(X) \
+    X(vkCreateInstance) \
+    X(vkEnumerateInstanceLayerProperties)
+
+#define VK_DISPATCH_INSTANCE(X) \
+    X(vkDestroyInstance) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceProperties2) \
+    X(vkGetPhysicalDeviceFeatures2) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties2) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceFormatProperties) \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR) \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkCreateDevice) \
+    X(vkGetDeviceProcAddr) \
+    X(vkDestroySurfaceKHR)
+
+// Everything whose first parameter is a device, queue or command buffer.
+#define VK_DISPATCH_DEVICE(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit) \
+    X(vkQueueWaitIdle) \
+    X(vkQueuePresentKHR) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkUnmapMemory) \
+    X(vkInvalidateMappedMemoryRanges) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkBindBufferMemory) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkBindImageMemory) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreateRenderPass) \
+    X(vkDestroyRenderPass) \
+    X(vkCreateFramebuffer) \
+    X(vkDestroyFramebuffer) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkResetDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkFreeDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateDescriptorUpdateTemplate) \
+    X(vkDestroyDescriptorUpdateTemplate) \
+    X(vkUpdateDescriptorSetWithTemplate) \
+    X(vkCreateQueryPool) \
+    X(vkDestroyQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkResetFences) \
+    X(vkWaitForFences) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkFreeCommandBuffers) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkResetCommandBuffer) \
+    X(vkCmdBeginRenderPass) \
+    X(vkCmdEndRenderPass) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdBindVertexBuffers) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdPushConstants) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDrawIndexed) \
+    X(vkCmdDrawIndexedIndirectCount) \
+    X(vkCmdDispatch) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdCopyImage) \
+    X(vkCmdCopyImageToBuffer) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdBeginQuery) \
+    X(vkCmdEndQuery) \
+    X(vkCmdWriteTimestamp)
+
+#define VK_DISPATCH_DECLARE(name) extern PFN_##name name;
+extern PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
+VK_DISPATCH_GLOBAL(VK_DISPATCH_DECLARE)
+VK_DISPATCH_INSTANCE(VK_DISPATCH_DECLARE)
+VK_DISPATCH_DEVICE(VK_DISPATCH_DECLARE)
+#undef VK_DISPATCH_DECLARE
+
+// The device-level entry points of one VkDevice, owned next to the device.
+struct DeviceDispatch {
+#define VK_DISPATCH_MEMBER(name) PFN_##name name = nullptr;
+    VK_DISPATCH_DEVICE(VK_DISPATCH_MEMBER)
+#undef VK_DISPATCH_MEMBER
+};
+
+namespace VkDispatch {
+    // Opens the system Vulkan loader and loads the global entry points;
+    // false when there is no loader. Safe to call again.
+    bool LoadLoader();
+
+    // Points everything at getInstanceProcAddr and loads the global entry
+    // points through it; the null backend comes in this way.
+    void Load(PFN_vkGetInstanceProcAddr getInstanceProcAddr);
+
+    // Instance and device entry points, right after vkCreateInstance.
+    // Device-level calls go through the loader's trampolines.
+    void LoadInstance(VkInstance instance);
+
+    // Fills table with the device's entry points from vkGetDeviceProcAddr,
+    // right after vkCreateDevice, so they call into the driver without the
+    // loader's trampoline. Anything the device does not return keeps the
+    // trampoline LoadInstance loaded.
+    void LoadDevice(VkDevice device, DeviceDispatch& table);
+
+    // Points the global device-level names at table. There is one set of
+    // globals, so while a table is in use they only work with its device;
+    // call Use again when switching devices. LoadInstance puts the
+    // trampolines back.
+    void Use(const DeviceDispatch& table);
+}
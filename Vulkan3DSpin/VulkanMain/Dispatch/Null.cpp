@@ -0,0 +1,540 @@
+#include "VulkanMain/Dispatch/Null.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+
+// Looked up by name by the engine rather than kept in the dispatch table.
+#define VK_NULL_EXTENSIONS(X) \
+    X(vkGetInstanceProcAddr) \
+    X(vkCmdBeginRenderingKHR) \
+    X(vkCmdEndRenderingKHR) \
+    X(vkCreateDebugUtilsMessengerEXT) \
+    X(vkDestroyDebugUtilsMessengerEXT)
+
+#define VK_NULL_ENTRIES(X) \
+    VK_DISPATCH_GLOBAL(X) \
+    VK_DISPATCH_INSTANCE(X) \
+    VK_DISPATCH_DEVICE(X) \
+    VK_NULL_EXTENSIONS(X)
+
+namespace {
+    enum class Entry : size_t {
+#define VK_NULL_ENUM(name) name,
+        VK_NULL_ENTRIES(VK_NULL_ENUM)
+#undef VK_NULL_ENUM
+        Count
+    };
+
+    const char* const ENTRY_NAMES[] = {
+#define VK_NULL_NAME(name) #name,
+        VK_NULL_ENTRIES(VK_NULL_NAME)
+#undef VK_NULL_NAME
+    };
+
+    constexpr size_t ENTRY_COUNT = static_cast<size_t>(Entry::Count);
+    std::atomic<uint64_t> calls[ENTRY_COUNT];
+
+    std::atomic<uintptr_t> nextHandle{ 0x1000 };
+
+    // Non-dispatchable handles are pointers on 64-bit targets, which are the
+    // only ones the engine builds for.
+    template <typename Handle>
+    Handle NewHandle() {
+        return reinterpret_cast<Handle>(nextHandle.fetch_add(1, std::memory_order_relaxed));
+    }
+
+    // A create call's last parameter: where to store the new handle.
+    template <typename T>
+    constexpr bool IS_HANDLE_OUTPUT =
+        std::is_pointer_v<T> &&
+        std::is_pointer_v<std::remove_pointer_t<T>> &&
+        !std::is_const_v<std::remove_pointer_t<T>> &&
+        std::is_class_v<std::remove_pointer_t<std::remove_pointer_t<T>>>;
+
+    // Every entry point without its own implementation below: succeeds, and
+    // fills in the handle if it creates one.
+    template <typename PFN>
+    struct Default;
+
+    template <typename R, typename... Args>
+    struct Default<R (VKAPI_PTR*)(Args...)> {
+        static R VKAPI_CALL Call(Args... args) {
+            if constexpr (sizeof...(Args) > 0) {
+                using Last = std::tuple_element_t<sizeof...(Args) - 1, std::tuple<Args...>>;
+                if constexpr (IS_HANDLE_OUTPUT<Last>) {
+                    Last output = std::get<sizeof...(Args) - 1>(std::tie(args...));
+                    if (output != nullptr) {
+                        *output = NewHandle<std::remove_pointer_t<Last>>();
+                    }
+                }
+            }
+            ((void)args, ...);
+            if constexpr (!std::is_void_v<R>) {
+                return R{};
+            }
+        }
+    };
+
+    template <Entry E, typename PFN, PFN Function>
+    struct Counted;
+
+    template <Entry E, typename R, typename... Args, R (VKAPI_PTR* Function)(Args...)>
+    struct Counted<E, R (VKAPI_PTR*)(Args...), Function> {
+        static R VKAPI_CALL Call(Args... args) {
+            calls[static_cast<size_t>(E)].fetch_add(1, std::memory_order_relaxed);
+            return Function(args...);
+        }
+    };
+
+    struct Defaults {
+#define VK_NULL_DEFAULT(name) static constexpr PFN_##name name = &Default<PFN_##name>::Call;
+        VK_NULL_ENTRIES(VK_NULL_DEFAULT)
+#undef VK_NULL_DEFAULT
+    };
+
+    // Members declared here hide the defaults of the same name.
+    struct Implementation : Defaults {
+        static PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char* pName);
+        static PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char* pName);
+        static VkResult VKAPI_CALL vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties* pProperties);
+
+        static VkResult VKAPI_CALL vkEnumeratePhysicalDevices(VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices);
+        static void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties);
+        static void VKAPI_CALL vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2* pProperties);
+        static void VKAPI_CALL vkGetPhysicalDeviceFeatures2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures2* pFeatures);
+        static void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties);
+        static void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2* pMemoryProperties);
+        static void VKAPI_CALL vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice physicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties);
+        static void VKAPI_CALL vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties* pFormatProperties);
+        static VkResult VKAPI_CALL vkEnumerateDeviceExtensionProperties(VkPhysicalDevice physicalDevice, const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties);
+
+        static VkResult VKAPI_CALL vkAllocateMemory(VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory);
+        static void VKAPI_CALL vkFreeMemory(VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator);
+        static VkResult VKAPI_CALL vkMapMemory(VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void** ppData);
+        static VkResult VKAPI_CALL vkCreateBuffer(VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer);
+        static void VKAPI_CALL vkDestroyBuffer(VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator);
+        static void VKAPI_CALL vkGetBufferMemoryRequirements(VkDevice device, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements);
+        static VkResult VKAPI_CALL vkCreateImage(VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage);
+        static void VKAPI_CALL vkDestroyImage(VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator);
+        static void VKAPI_CALL vkGetImageMemoryRequirements(VkDevice device, VkImage image, VkMemoryRequirements* pMemoryRequirements);
+
+        static VkResult VKAPI_CALL vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+        static VkResult VKAPI_CALL vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo* pCreateInfos, const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines);
+        static VkResult VKAPI_CALL vkAllocateDescriptorSets(VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets);
+        static VkResult VKAPI_CALL vkAllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers);
+        static VkResult VKAPI_CALL vkGetSwapchainImagesKHR(VkDevice device, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages);
+        static VkResult VKAPI_CALL vkGetQueryPoolResults(VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* pData, VkDeviceSize stride, VkQueryResultFlags flags);
+
+        static VkResult VKAPI_CALL vkCreateFence(VkDevice device, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFence* pFence);
+        static void VKAPI_CALL vkDestroyFence(VkDevice device, VkFence fence, const VkAllocationCallbacks* pAllocator);
+        static VkResult VKAPI_CALL vkResetFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences);
+        static VkResult VKAPI_CALL vkWaitForFences(VkDevice device, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout);
+        static VkResult VKAPI_CALL vkQueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence);
+    };
+
+    struct NamedEntry {
+        const char* name;
+        PFN_vkVoidFunction function;
+    };
+
+    const NamedEntry ENTRIES[] = {
+#define VK_NULL_NAMED(name) { #name, reinterpret_cast<PFN_vkVoidFunction>(&Counted<Entry::name, PFN_##name, Implementation::name>::Call) },
+        VK_NULL_ENTRIES(VK_NULL_NAMED)
+#undef VK_NULL_NAMED
+    };
+
+    PFN_vkVoidFunction Lookup(const char* name) {
+        for (const auto& entry : ENTRIES) {
+            if (strcmp(entry.name, name) == 0) {
+                return entry.function;
+            }
+        }
+        return nullptr;
+    }
+
+    // Host memory stands in for every memory type; it is only allocated
+    // once something maps it.
+    struct Allocation {
+        VkDeviceSize size = 0;
+        uint32_t memoryType = 0;
+        std::unique_ptr<char[]> data;
+    };
+
+    std::mutex objectMutex;
+    std::unordered_map<const void*, Allocation> allocations;
+    std::unordered_map<const void*, VkDeviceSize> resourceSizes;
+    std::unordered_map<const void*, bool> fenceSignaled;
+
+    constexpr VkDeviceSize GIB = 1024ull * 1024ull * 1024ull;
+    constexpr uint32_t ALL_MEMORY_TYPES = 0xf;
+
+    template <typename T, size_t N>
+    VkResult Enumerate(const T (&available)[N], uint32_t* count, T* out) {
+        if (out == nullptr) {
+            *count = static_cast<uint32_t>(N);
+            return VK_SUCCESS;
+        }
+        uint32_t written = std::min(*count, static_cast<uint32_t>(N));
+        std::copy(available, available + written, out);
+        *count = written;
+        return written < N ? VK_INCOMPLETE : VK_SUCCESS;
+    }
+
+    VkExtensionProperties Extension(const char* name) {
+        VkExtensionProperties extension{};
+        snprintf(extension.extensionName, sizeof(extension.extensionName), "%s", name);
+        extension.specVersion = 1;
+        return extension;
+    }
+
+    // Sets every VkBool32 member of a feature struct that follows sType and pNext.
+    void EnableAll(void* features, size_t size) {
+        auto* first = reinterpret_cast<VkBool32*>(static_cast<char*>(features) + sizeof(VkBaseOutStructure));
+        std::fill(first, first + (size - sizeof(VkBaseOutStructure)) / sizeof(VkBool32), VK_TRUE);
+    }
+
+    void EnableAll(VkPhysicalDeviceFeatures& features) {
+        auto* first = reinterpret_cast<VkBool32*>(&features);
+        std::fill(first, first + sizeof(features) / sizeof(VkBool32), VK_TRUE);
+    }
+}
+
+PFN_vkVoidFunction VKAPI_CALL Implementation::vkGetInstanceProcAddr(VkInstance, const char* pName) {
+    return Lookup(pName);
+}
+
+PFN_vkVoidFunction VKAPI_CALL Implementation::vkGetDeviceProcAddr(VkDevice, const char* pName) {
+    return Lookup(pName);
+}
+
+// Reports the validation layer so debug builds start; it does nothing.
+VkResult VKAPI_CALL Implementation::vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties* pProperties) {
+    static const VkLayerProperties layers[] = { [] {
+        VkLayerProperties layer{};
+        snprintf(layer.layerName, sizeof(layer.layerName), "%s", "VK_LAYER_KHRONOS_validation");
+        snprintf(layer.description, sizeof(layer.description), "%s", "null backend stand-in");
+        return layer;
+    }() };
+    return Enumerate(layers, pPropertyCount, pProperties);
+}
+
+VkResult VKAPI_CALL Implementation::vkEnumeratePhysicalDevices(VkInstance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices) {
+    static const VkPhysicalDevice devices[] = { NewHandle<VkPhysicalDevice>() };
+    return Enumerate(devices, pPhysicalDeviceCount, pPhysicalDevices);
+}
+
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* pProperties) {
+    VkPhysicalDeviceProperties& properties = *pProperties;
+    properties = {};
+    properties.apiVersion = VK_API_VERSION_1_2;
+    properties.driverVersion = 1;
+    properties.deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    snprintf(properties.deviceName, sizeof(properties.deviceName), "%s", "Null Vulkan device");
+
+    VkPhysicalDeviceLimits& limits = properties.limits;
+    limits.maxImageDimension1D = 16384;
+    limits.maxImageDimension2D = 16384;
+    limits.maxImageDimension3D = 2048;
+    limits.maxImageArrayLayers = 2048;
+    limits.maxUniformBufferRange = 65536;
+    limits.maxStorageBufferRange = 1u << 30;
+    limits.maxPushConstantsSize = 256;
+    limits.maxMemoryAllocationCount = 4096;
+    limits.maxBoundDescriptorSets = 8;
+    limits.maxComputeSharedMemorySize = 32768;
+    limits.maxComputeWorkGroupCount[0] = limits.maxComputeWorkGroupCount[1] = limits.maxComputeWorkGroupCount[2] = 65535;
+    limits.maxComputeWorkGroupInvocations = 1024;
+    limits.maxComputeWorkGroupSize[0] = limits.maxComputeWorkGroupSize[1] = 1024;
+    limits.maxComputeWorkGroupSize[2] = 64;
+    limits.maxDrawIndexedIndexValue = UINT32_MAX;
+    limits.maxDrawIndirectCount = UINT32_MAX;
+    limits.maxSamplerAnisotropy = 16.0f;
+    limits.minMemoryMapAlignment = 64;
+    limits.minUniformBufferOffsetAlignment = 256;
+    limits.minStorageBufferOffsetAlignment = 256;
+    limits.timestampPeriod = 1.0f;
+    limits.optimalBufferCopyOffsetAlignment = 16;
+    limits.optimalBufferCopyRowPitchAlignment = 16;
+    limits.nonCoherentAtomSize = 64;
+}
+
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties2* pProperties) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &pProperties->properties);
+
+    for (auto* next = static_cast<VkBaseOutStructure*>(pProperties->pNext); next != nullptr; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES) {
+            auto* properties12 = reinterpret_cast<VkPhysicalDeviceVulkan12Properties*>(next);
+            const uint32_t many = 1u << 20;
+            properties12->maxUpdateAfterBindDescriptorsInAllPools = many;
+            properties12->maxPerStageDescriptorUpdateAfterBindSamplers = many;
+            properties12->maxPerStageDescriptorUpdateAfterBindStorageBuffers = many;
+            properties12->maxPerStageDescriptorUpdateAfterBindSampledImages = many;
+            properties12->maxPerStageUpdateAfterBindResources = many;
+            properties12->maxDescriptorSetUpdateAfterBindSamplers = many;
+            properties12->maxDescriptorSetUpdateAfterBindStorageBuffers = many;
+            properties12->maxDescriptorSetUpdateAfterBindSampledImages = many;
+        }
+    }
+}
+
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceFeatures2(VkPhysicalDevice, VkPhysicalDeviceFeatures2* pFeatures) {
+    EnableAll(pFeatures->features);
+
+    for (auto* next = static_cast<VkBaseOutStructure*>(pFeatures->pNext); next != nullptr; next = next->pNext) {
+        if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES) {
+            EnableAll(next, sizeof(VkPhysicalDeviceVulkan12Features));
+        }
+        else if (next->sType == VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR) {
+            EnableAll(next, sizeof(VkPhysicalDeviceDynamicRenderingFeaturesKHR));
+        }
+    }
+}
+
+// A device-local heap, a host heap, and a small host-visible window into
+// device memory.
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties) {
+    VkPhysicalDeviceMemoryProperties& memory = *pMemoryProperties;
+    memory = {};
+    memory.memoryHeapCount = 3;
+    memory.memoryHeaps[0] = { 8 * GIB, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+    memory.memoryHeaps[1] = { 16 * GIB, 0 };
+    memory.memoryHeaps[2] = { 256ull * 1024ull * 1024ull, VK_MEMORY_HEAP_DEVICE_LOCAL_BIT };
+
+    const VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    memory.memoryTypeCount = 4;
+    memory.memoryTypes[0] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0 };
+    memory.memoryTypes[1] = { hostVisible, 1 };
+    memory.memoryTypes[2] = { hostVisible | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, 1 };
+    memory.memoryTypes[3] = { VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | hostVisible, 2 };
+}
+
+// Every process may use 90% of each heap, and this one is the only user.
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceMemoryProperties2(VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties2* pMemoryProperties) {
+    VkPhysicalDeviceMemoryProperties& memory = pMemoryProperties->memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory);
+
+    for (auto* next = static_cast<VkBaseOutStructure*>(pMemoryProperties->pNext); next != nullptr; next = next->pNext) {
+        if (next->sType != VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT) {
+            continue;
+        }
+        auto* budget = reinterpret_cast<VkPhysicalDeviceMemoryBudgetPropertiesEXT*>(next);
+        std::fill(std::begin(budget->heapUsage), std::end(budget->heapUsage), 0);
+        std::fill(std::begin(budget->heapBudget), std::end(budget->heapBudget), 0);
+        for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+            budget->heapBudget[i] = memory.memoryHeaps[i].size / 10 * 9;
+        }
+        std::lock_guard<std::mutex> lock(objectMutex);
+        for (const auto& [handle, allocation] : allocations) {
+            budget->heapUsage[memory.memoryTypes[allocation.memoryType].heapIndex] += allocation.size;
+        }
+    }
+}
+
+// Family 0 does everything; family 1 is compute-only, for async compute.
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties) {
+    static const VkQueueFamilyProperties families[] = {
+        { VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 0, { 1, 1, 1 } },
+        { VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT, 1, 0, { 1, 1, 1 } },
+    };
+    Enumerate(families, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+void VKAPI_CALL Implementation::vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat, VkFormatProperties* pFormatProperties) {
+    pFormatProperties->linearTilingFeatures = ~0u;
+    pFormatProperties->optimalTilingFeatures = ~0u;
+    pFormatProperties->bufferFeatures = ~0u;
+}
+
+VkResult VKAPI_CALL Implementation::vkEnumerateDeviceExtensionProperties(VkPhysicalDevice, const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties) {
+    static const VkExtensionProperties extensions[] = {
+        Extension(VK_KHR_SWAPCHAIN_EXTENSION_NAME),
+        Extension(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME),
+        Extension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME),
+    };
+    return Enumerate(extensions, pPropertyCount, pProperties);
+}
+
+VkResult VKAPI_CALL Implementation::vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory) {
+    *pMemory = NewHandle<VkDeviceMemory>();
+    std::lock_guard<std::mutex> lock(objectMutex);
+    Allocation& allocation = allocations[*pMemory];
+    allocation.size = pAllocateInfo->allocationSize;
+    allocation.memoryType = std::min(pAllocateInfo->memoryTypeIndex, 3u);
+    return VK_SUCCESS;
+}
+
+void VKAPI_CALL Implementation::vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    allocations.erase(memory);
+}
+
+VkResult VKAPI_CALL Implementation::vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    auto it = allocations.find(memory);
+    if (it == allocations.end()) {
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    }
+    Allocation& allocation = it->second;
+    if (allocation.data == nullptr) {
+        allocation.data = std::make_unique<char[]>(static_cast<size_t>(allocation.size));
+    }
+    *ppData = allocation.data.get() + offset;
+    return VK_SUCCESS;
+}
+
+VkResult VKAPI_CALL Implementation::vkCreateBuffer(VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer) {
+    *pBuffer = NewHandle<VkBuffer>();
+    std::lock_guard<std::mutex> lock(objectMutex);
+    resourceSizes[*pBuffer] = pCreateInfo->size;
+    return VK_SUCCESS;
+}
+
+void VKAPI_CALL Implementation::vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    resourceSizes.erase(buffer);
+}
+
+void VKAPI_CALL Implementation::vkGetBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    pMemoryRequirements->size = (resourceSizes[buffer] + 255) & ~VkDeviceSize(255);
+    pMemoryRequirements->alignment = 256;
+    pMemoryRequirements->memoryTypeBits = ALL_MEMORY_TYPES;
+}
+
+// Sizes assume four bytes per texel.
+VkResult VKAPI_CALL Implementation::vkCreateImage(VkDevice, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkImage* pImage) {
+    VkDeviceSize size = 0;
+    for (uint32_t level = 0; level < std::max(pCreateInfo->mipLevels, 1u); level++) {
+        size += static_cast<VkDeviceSize>(std::max(pCreateInfo->extent.width >> level, 1u)) *
+            std::max(pCreateInfo->extent.height >> level, 1u) *
+            std::max(pCreateInfo->extent.depth >> level, 1u) * 4;
+    }
+    size *= std::max(pCreateInfo->arrayLayers, 1u);
+
+    *pImage = NewHandle<VkImage>();
+    std::lock_guard<std::mutex> lock(objectMutex);
+    resourceSizes[*pImage] = size;
+    return VK_SUCCESS;
+}
+
+void VKAPI_CALL Implementation::vkDestroyImage(VkDevice, VkImage image, const VkAllocationCallbacks*) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    resourceSizes.erase(image);
+}
+
+void VKAPI_CALL Implementation::vkGetImageMemoryRequirements(VkDevice, VkImage image, VkMemoryRequirements* pMemoryRequirements) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    pMemoryRequirements->size = (resourceSizes[image] + 4095) & ~VkDeviceSize(4095);
+    pMemoryRequirements->alignment = 4096;
+    pMemoryRequirements->memoryTypeBits = ALL_MEMORY_TYPES;
+}
+
+VkResult VKAPI_CALL Implementation::vkCreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline* pPipelines) {
+    std::generate(pPipelines, pPipelines + createInfoCount, NewHandle<VkPipeline>);
+    return VK_SUCCESS;
+}
+
+VkResult VKAPI_CALL Implementation::vkCreateComputePipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo*, const VkAllocationCallbacks*, VkPipeline* pPipelines) {
+    std::generate(pPipelines, pPipelines + createInfoCount, NewHandle<VkPipeline>);
+    return VK_SUCCESS;
+}
+
+VkResult VKAPI_CALL Implementation::vkAllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets) {
+    std::generate(pDescriptorSets, pDescriptorSets + pAllocateInfo->descriptorSetCount, NewHandle<VkDescriptorSet>);
+    return VK_SUCCESS;
+}
+
+VkResult VKAPI_CALL Implementation::vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers) {
+    std::generate(pCommandBuffers, pCommandBuffers + pAllocateInfo->commandBufferCount, NewHandle<VkCommandBuffer>);
+    return VK_SUCCESS;
+}
+
+VkResult VKAPI_CALL Implementation::vkGetSwapchainImagesKHR(VkDevice, VkSwapchainKHR, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages) {
+    static const VkImage images[] = { NewHandle<VkImage>(), NewHandle<VkImage>(), NewHandle<VkImage>() };
+    return Enumerate(images, pSwapchainImageCount, pSwapchainImages);
+}
+
+// Nothing ever runs, so there are never results.
+VkResult VKAPI_CALL Implementation::vkGetQueryPoolResults(VkDevice, VkQueryPool, uint32_t, uint32_t, size_t, void*, VkDeviceSize, VkQueryResultFlags) {
+    return VK_NOT_READY;
+}
+
+VkResult VKAPI_CALL Implementation::vkCreateFence(VkDevice, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkFence* pFence) {
+    *pFence = NewHandle<VkFence>();
+    std::lock_guard<std::mutex> lock(objectMutex);
+    fenceSignaled[*pFence] = (pCreateInfo->flags & VK_FENCE_CREATE_SIGNALED_BIT) != 0;
+    return VK_SUCCESS;
+}
+
+void VKAPI_CALL Implementation::vkDestroyFence(VkDevice, VkFence fence, const VkAllocationCallbacks*) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    fenceSignaled.erase(fence);
+}
+
+VkResult VKAPI_CALL Implementation::vkResetFences(VkDevice, uint32_t fenceCount, const VkFence* pFences) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    for (uint32_t i = 0; i < fenceCount; i++) {
+        fenceSignaled[pFences[i]] = false;
+    }
+    return VK_SUCCESS;
+}
+
+// A fence nothing was submitted with would never signal on a real device;
+// report the timeout instead of hanging.
+VkResult VKAPI_CALL Implementation::vkWaitForFences(VkDevice, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t) {
+    std::lock_guard<std::mutex> lock(objectMutex);
+    uint32_t signaled = 0;
+    for (uint32_t i = 0; i < fenceCount; i++) {
+        signaled += fenceSignaled[pFences[i]] ? 1 : 0;
+    }
+    bool done = waitAll ? signaled == fenceCount : signaled > 0;
+    return done ? VK_SUCCESS : VK_TIMEOUT;
+}
+
+// The work completes immediately.
+VkResult VKAPI_CALL Implementation::vkQueueSubmit(VkQueue, uint32_t, const VkSubmitInfo*, VkFence fence) {
+    if (fence != VK_NULL_HANDLE) {
+        std::lock_guard<std::mutex> lock(objectMutex);
+        fenceSignaled[fence] = true;
+    }
+    return VK_SUCCESS;
+}
+
+void VkNull::Install() {
+    VkDispatch::Load(&Implementation::vkGetInstanceProcAddr);
+}
+
+void VkNull::ResetCalls() {
+    for (auto& count : calls) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t VkNull::TotalCalls() {
+    uint64_t total = 0;
+    for (const auto& count : calls) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::vector<std::pair<std::string, uint64_t>> VkNull::Calls() {
+    std::vector<std::pair<std::string, uint64_t>> result;
+    for (size_t i = 0; i < ENTRY_COUNT; i++) {
+        uint64_t count = calls[i].load(std::memory_order_relaxed);
+        if (count > 0) {
+            result.emplace_back(ENTRY_NAMES[i], count);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return result;
+}
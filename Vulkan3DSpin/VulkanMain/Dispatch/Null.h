@@ -0,0 +1,28 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A Vulkan implementation that does no GPU work, for measuring the CPU cost
+// of the renderer and running it where there is no driver at all. Every
+// call succeeds and is counted:
+//   - one physical device with every feature, a graphics queue family and a
+//     compute-only one, and no timestamps;
+//   - create calls hand out unique handles, host-visible memory is real host
+//     memory while mapped;
+//   - a submit signals its fence at once, so waits never block.
+// Only headless use makes sense; there is no surface.
+namespace VkNull {
+    // Points the dispatch table at the null backend; VkDispatch::LoadInstance
+    // then picks up the rest as usual.
+    void Install();
+
+    void ResetCalls();
+    uint64_t TotalCalls();
+
+    // Calls since the last reset by entry point, most frequent first.
+    std::vector<std::pair<std::string, uint64_t>> Calls();
+}
@@ -0,0 +1,276 @@
+#include "VulkanMain/DrawList/DrawList.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Vertex/UBO/Ubo.h"
+#include "VulkanMain/Jobs/Jobs.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Items per histogram/scatter chunk; smaller lists sort on one thread.
+    constexpr size_t SORT_CHUNK = 16384;
+    // Below this a comparison sort wins over the radix passes' fixed cost.
+    constexpr size_t SMALL_SORT = 2048;
+    constexpr uint32_t RADIX = 256;
+}
+
+uint64_t VkDrawList::MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth, bool backToFront) {
+    // Non-negative floats order the same as their bit patterns.
+    uint32_t depthBits;
+    float clamped = std::max(depth, 0.0f);
+    std::memcpy(&depthBits, &clamped, sizeof(depthBits));
+    if (backToFront) {
+        depthBits = ~depthBits;
+    }
+
+    return uint64_t(pass & (MAX_PASSES - 1)) << 60
+         | uint64_t(pipeline & (MAX_PIPELINES - 1)) << 48
+         | uint64_t(material & (MAX_MATERIALS - 1)) << 32
+         | depthBits;
+}
+
+void VkDrawList::Sort(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch) {
+    size_t count = items.size();
+    if (count < 2) {
+        return;
+    }
+    if (count <= SMALL_SORT) {
+        std::stable_sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) {
+            return a.key < b.key;
+        });
+        return;
+    }
+    scratch.resize(count);
+
+    size_t chunkCount = (count + SORT_CHUNK - 1) / SORT_CHUNK;
+    std::vector<uint64_t> chunkAnd(chunkCount, ~0ull);
+    std::vector<uint64_t> chunkOr(chunkCount, 0);
+    std::vector<uint32_t> histograms(chunkCount * RADIX);
+
+    auto chunkRange = [&](size_t chunk, size_t& begin, size_t& end) {
+        begin = chunk * SORT_CHUNK;
+        end = std::min(begin + SORT_CHUNK, count);
+    };
+
+    // Bits that differ between any two keys.
+    VkJobs::ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            size_t begin, end;
+            chunkRange(c, begin, end);
+            for (size_t i = begin; i < end; i++) {
+                chunkAnd[c] &= items[i].key;
+                chunkOr[c] |= items[i].key;
+            }
+        }
+    });
+
+    uint64_t allAnd = ~0ull, allOr = 0;
+    for (size_t c = 0; c < chunkCount; c++) {
+        allAnd &= chunkAnd[c];
+        allOr |= chunkOr[c];
+    }
+    uint64_t varying = allAnd ^ allOr;
+
+    const DrawItem* src = items.data();
+    DrawItem* dst = scratch.data();
+    bool inScratch = false;
+
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        VkJobs::ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) {
+                uint32_t* histogram = &histograms[c * RADIX];
+                std::fill(histogram, histogram + RADIX, 0u);
+
+                size_t begin, end;
+                chunkRange(c, begin, end);
+                for (size_t i = begin; i < end; i++) {
+                    histogram[(src[i].key >> shift) & 0xFF]++;
+                }
+            }
+        });
+
+        // Digit-major, chunk-minor offsets keep equal keys in input order.
+        uint32_t offset = 0;
+        for (uint32_t digit = 0; digit < RADIX; digit++) {
+            for (size_t c = 0; c < chunkCount; c++) {
+                uint32_t bucket = histograms[c * RADIX + digit];
+                histograms[c * RADIX + digit] = offset;
+                offset += bucket;
+            }
+        }
+
+        VkJobs::ParallelFor(chunkCount, 1, [&](size_t first, size_t last) {
+            for (size_t c = first; c < last; c++) {
+                uint32_t* offsets = &histograms[c * RADIX];
+
+                size_t begin, end;
+                chunkRange(c, begin, end);
+                for (size_t i = begin; i < end; i++) {
+                    dst[offsets[(src[i].key >> shift) & 0xFF]++] = src[i];
+                }
+            }
+        });
+
+        inScratch = !inScratch;
+        src = inScratch ? scratch.data() : items.data();
+        dst = inScratch ? items.data() : scratch.data();
+    }
+
+    if (inScratch) {
+        items.swap(scratch);
+    }
+}
+
+void CommandStateCache::Begin(VkCommandBuffer vkCommandBuffer) {
+    *this = CommandStateCache{};
+    commandBuffer = vkCommandBuffer;
+}
+
+void CommandStateCache::Invalidate() {
+    CommandStateCache fresh;
+    fresh.commandBuffer = commandBuffer;
+    fresh.stats = stats;
+    *this = fresh;
+}
+
+bool CommandStateCache::BindPipeline(VkPipeline newPipeline) {
+    stats.requested.pipelines++;
+    if (newPipeline == pipeline) {
+        return false;
+    }
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, newPipeline);
+    pipeline = newPipeline;
+    stats.issued.pipelines++;
+    return true;
+}
+
+bool CommandStateCache::BindDescriptorSet(VkPipelineLayout newLayout, VkDescriptorSet newSet, uint32_t dynamicOffsetCount, const uint32_t* dynamicOffsets) {
+    stats.requested.descriptorSets++;
+
+    // Only single-offset sets are cached by their offset.
+    uint32_t newOffset = dynamicOffsetCount > 0 ? dynamicOffsets[0] : 0;
+    if (newLayout == layout && newSet == set && newOffset == dynamicOffset && dynamicOffsetCount <= 1) {
+        return false;
+    }
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, newLayout, 0, 1, &newSet, dynamicOffsetCount, dynamicOffsets);
+    layout = newLayout;
+    set = newSet;
+    dynamicOffset = newOffset;
+    stats.issued.descriptorSets++;
+    return true;
+}
+
+bool CommandStateCache::BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset) {
+    stats.requested.vertexBuffers++;
+    if (buffer == vertexBuffer && offset == vertexOffset) {
+        return false;
+    }
+
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+    vertexBuffer = buffer;
+    vertexOffset = offset;
+    stats.issued.vertexBuffers++;
+    return true;
+}
+
+bool CommandStateCache::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType type) {
+    stats.requested.indexBuffers++;
+    if (buffer == indexBuffer && offset == indexOffset && type == indexType) {
+        return false;
+    }
+
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, type);
+    indexBuffer = buffer;
+    indexOffset = offset;
+    indexType = type;
+    stats.issued.indexBuffers++;
+    return true;
+}
+
+void CommandStateCache::PushConstants(VkPipelineLayout pushLayout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data) {
+    vkCmdPushConstants(commandBuffer, pushLayout, stages, offset, size, data);
+    stats.pushConstants++;
+}
+
+void CommandStateCache::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, uint32_t firstInstance) {
+    vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, firstInstance);
+    stats.draws++;
+}
+
+void CommandStateCache::DrawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride) {
+    vkCmdDrawIndexedIndirectCount(commandBuffer, buffer, offset, countBuffer, countOffset, maxDrawCount, stride);
+    stats.draws++;
+}
+
+void VkMain::BuildDrawList(const Frustum& frustum, const glm::vec3& cameraPosition, float projectionScale) {
+    drawItems.clear();
+    frameStats.clusters = ClusterStats{};
+    frameStats.lods = LodStats{};
+
+    // One opaque pass and one material for now; the pipeline follows the
+    // descriptor mode.
+    uint32_t pipeline = bindless ? BINDLESS_PIPELINE : FORWARD_PIPELINE;
+
+    for (uint32_t i : visibleObjects) {
+        float worldScale;
+        float distance = VkLod::DistanceToSphere(scene.World()[i], meshBounds.sphere, cameraPosition, worldScale);
+        uint32_t lod = lodSelector.Select(i, meshLods, distance, worldScale, projectionScale);
+        frameStats.lods.objects[lod]++;
+
+        uint64_t key = VkDrawList::MakeKey(0, pipeline, 0, distance);
+
+        // Meshlets only cover LOD 0.
+        if (lod > 0 || !clusterCulling) {
+            drawItems.push_back({ key, i, meshLods[lod].firstIndex, meshLods[lod].indexCount });
+            frameStats.lods.triangles += meshLods[lod].indexCount / 3;
+            continue;
+        }
+
+        clusterDraws.clear();
+        ClusterStats clusterStats = VkMeshlet::Cull(meshlets, scene.World()[i], frustum, cameraPosition, clusterDraws);
+        frameStats.clusters.Add(clusterStats);
+        frameStats.lods.triangles += clusterStats.triangles;
+
+        for (const auto& range : clusterDraws) {
+            drawItems.push_back({ key, i, range.firstIndex, range.indexCount });
+        }
+    }
+
+    VkDrawList::Sort(drawItems, drawItemsScratch);
+}
+
+void VkMain::RecordDrawList(const glm::mat4& viewProj, bool depthOnly) {
+    uint32_t dynamicOffset = 0;
+    uint32_t pushedObject = UINT32_MAX;
+    VkPipeline forward = depthOnly ? depthPipeline : graphicsPipeline;
+
+    // Every draw asks for its full state; the cache only records changes.
+    for (const DrawItem& item : drawItems) {
+        if (VkDrawList::KeyPipeline(item.key) == BINDLESS_PIPELINE) {
+            BindBindless(viewProj, depthOnly);
+        }
+        else {
+            if (drawState.BindPipeline(forward)) {
+                pushedObject = UINT32_MAX;
+            }
+            drawState.BindDescriptorSet(pipelineLayout, descriptorSets[currentFrame], 1, &dynamicOffset);
+
+            // firstInstance already selects the object in bindless.vert;
+            // the forward shader needs its matrix pushed.
+            if (item.object != pushedObject) {
+                drawState.PushConstants(pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(UBO), &objectMvps[item.object]);
+                pushedObject = item.object;
+            }
+        }
+
+        drawState.BindVertexBuffer(vertexBuffer);
+        drawState.BindIndexBuffer(indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        drawState.DrawIndexed(item.indexCount, item.firstIndex, item.object);
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One indexed draw of an object. Everything the recorder needs to bind is
+// encoded in key; object doubles as firstInstance.
+struct DrawItem {
+    uint64_t key;
+    uint32_t object;
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+namespace VkDrawList {
+    // Sort key, most significant bits first:
+    //   63..60 pass, 59..48 pipeline, 47..32 material, 31..0 depth
+    // so a sorted list changes pass least often and depth most often.
+    constexpr uint32_t MAX_PASSES = 1u << 4;
+    constexpr uint32_t MAX_PIPELINES = 1u << 12;
+    constexpr uint32_t MAX_MATERIALS = 1u << 16;
+
+    // depth >= 0 sorts front to back, or back to front when backToFront is
+    // set (blended passes).
+    uint64_t MakeKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth, bool backToFront = false);
+
+    inline uint32_t KeyPass(uint64_t key) { return static_cast<uint32_t>(key >> 60); }
+    inline uint32_t KeyPipeline(uint64_t key) { return static_cast<uint32_t>(key >> 48) & (MAX_PIPELINES - 1); }
+    inline uint32_t KeyMaterial(uint64_t key) { return static_cast<uint32_t>(key >> 32) & (MAX_MATERIALS - 1); }
+
+    // Stable LSD radix sort by key, one byte per pass. Bytes that are equal
+    // in every key are skipped, so the constant pass/pipeline bits of a
+    // typical frame cost nothing. Lists above one chunk are histogrammed and
+    // scattered in parallel, short ones fall back to std::stable_sort;
+    // scratch is resized as needed.
+    void Sort(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch);
+}
+
+// Binds of each kind in one frame.
+struct BindCounts {
+    uint32_t pipelines = 0;
+    uint32_t descriptorSets = 0;
+    uint32_t vertexBuffers = 0;
+    uint32_t indexBuffers = 0;
+
+    uint32_t Total() const { return pipelines + descriptorSets + vertexBuffers + indexBuffers; }
+};
+
+// requested counts every bind the recording code asked for, as a recorder
+// without the cache would issue them; issued counts what reached the
+// command buffer.
+struct StateChangeStats {
+    BindCounts requested;
+    BindCounts issued;
+    uint32_t pushConstants = 0;
+    uint32_t draws = 0;
+};
+
+// Remembers the graphics state bound in one command buffer and drops binds
+// that would not change it. Each Bind* returns true if it recorded a command.
+class CommandStateCache {
+public:
+    void Begin(VkCommandBuffer commandBuffer);
+    // Forgets what is bound but keeps counting, for draws that resume after
+    // compute work in the same command buffer.
+    void Invalidate();
+
+    bool BindPipeline(VkPipeline pipeline);
+    bool BindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet set, uint32_t dynamicOffsetCount = 0, const uint32_t* dynamicOffsets = nullptr);
+    bool BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset = 0);
+    bool BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+
+    void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+    void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, uint32_t firstInstance);
+    void DrawIndexedIndirectCount(VkBuffer buffer, VkDeviceSize offset, VkBuffer countBuffer, VkDeviceSize countOffset, uint32_t maxDrawCount, uint32_t stride);
+
+    const StateChangeStats& Stats() const { return stats; }
+
+private:
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    uint32_t dynamicOffset = 0;
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize vertexOffset = 0;
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize indexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+    StateChangeStats stats;
+};
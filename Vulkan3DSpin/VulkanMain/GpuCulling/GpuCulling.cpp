@@ -0,0 +1,254 @@
+#include "VulkanMain/GpuCulling/GpuCulling.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <cstddef>
+
+GpuObjectData VkGpuCulling::PackObject(const glm::mat4& world, const MeshBounds& bounds, uint32_t textureIndex) {
+    GpuObjectData object{};
+    object.model = world;
+    object.boundsCenterRadius = glm::vec4(bounds.box.Center(), bounds.sphere.radius);
+    object.boundsExtents = bounds.box.Extents();
+    object.textureIndex = textureIndex;
+    return object;
+}
+
+GpuCullConstants VkGpuCulling::MakeConstants(const Frustum& frustum, uint32_t objectCount, uint32_t indexCount) {
+    GpuCullConstants constants{};
+    for (int i = 0; i < 6; i++) {
+        constants.planes[i] = frustum.planes[i];
+    }
+    constants.objectCount = objectCount;
+    constants.indexCount = indexCount;
+    return constants;
+}
+
+void VkMain::CreateObjectBuffers() {
+    assert(device != VK_NULL_HANDLE);
+
+    VkDeviceSize objectSize = sizeof(GpuObjectData) * objectCount;
+
+    objectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    objectBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    objectBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        CreateBuffer(
+            objectSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryCategory::Geometry,
+            objectBuffers[i],
+            objectBuffersMemory[i],
+            true
+        );
+        vkMapMemory(device, objectBuffersMemory[i], 0, objectSize, 0, &objectBuffersMapped[i]);
+    }
+
+    // Every buffer starts empty and takes the whole scene on its first frame.
+    objectUploads.resize(MAX_FRAMES_IN_FLIGHT);
+    for (auto& uploads : objectUploads) {
+        uploads.Resize(scene.Size());
+        uploads.AddAll();
+    }
+}
+
+void VkMain::DestroyObjectBuffers() {
+    for (size_t i = 0; i < objectBuffers.size(); i++) {
+        vkDestroyBuffer(device, objectBuffers[i], nullptr);
+        VkMemory::Free(device, objectBuffersMemory[i]);
+    }
+
+    objectBuffers.clear();
+    objectBuffersMemory.clear();
+    objectBuffersMapped.clear();
+    objectUploads.clear();
+}
+
+void VkMain::CreateGpuCulling() {
+    assert(device != VK_NULL_HANDLE);
+    assert(indexBuffer != VK_NULL_HANDLE);
+    assert(objectBuffers.size() == MAX_FRAMES_IN_FLIGHT);
+
+    // binding 0: objects, 1: draw commands, 2: draw count; the indirect
+    // vertex shader reads the objects through the same layout.
+    std::vector<VkDescriptorSetLayoutBinding> bindings = VkCompute::StorageBufferBindings(3);
+    bindings[0].stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+
+    cullPipeline = VkCompute::CreatePipeline(device, descriptorLayouts, shaderDirectory + "cull.spv", bindings, sizeof(GpuCullConstants), VkGpuCulling::WORKGROUP_SIZE);
+
+    // Occlusion culling keeps its late list after the early one.
+    VkDeviceSize drawSize = sizeof(VkDrawIndexedIndirectCommand) * objectCount * (occlusionCulling ? 2 : 1);
+
+    drawCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    drawCommandBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    drawCountBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    drawCountBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    drawCountBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        CreateBuffer(
+            drawSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            MemoryCategory::Geometry,
+            drawCommandBuffers[i],
+            drawCommandBuffersMemory[i],
+            true
+        );
+
+        // Host visible so the counts can be read back for the frame stats.
+        CreateBuffer(
+            sizeof(GpuDrawCounts),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryCategory::Geometry,
+            drawCountBuffers[i],
+            drawCountBuffersMemory[i],
+            true
+        );
+        vkMapMemory(device, drawCountBuffersMemory[i], 0, sizeof(GpuDrawCounts), 0, &drawCountBuffersMapped[i]);
+        memset(drawCountBuffersMapped[i], 0, sizeof(GpuDrawCounts));
+    }
+
+    // Filled by AllocateCullingSets each frame.
+    cullDescriptorSets.assign(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+
+    // Indirect graphics pipeline: model comes from the object buffer,
+    // viewProj from a push constant.
+    VkPushConstantRange drawRange{};
+    drawRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    drawRange.offset = 0;
+    drawRange.size = sizeof(glm::mat4);
+
+    VkPipelineLayoutCreateInfo drawLayoutInfo{};
+    drawLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    drawLayoutInfo.setLayoutCount = 1;
+    drawLayoutInfo.pSetLayouts = &cullPipeline.setLayout;
+    drawLayoutInfo.pushConstantRangeCount = 1;
+    drawLayoutInfo.pPushConstantRanges = &drawRange;
+
+    if (vkCreatePipelineLayout(device, &drawLayoutInfo, nullptr, &indirectPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create indirect pipeline layout!");
+    }
+
+    indirectPipeline = BuildGraphicsPipeline(shaderDirectory + "indirect.spv", shaderDirectory + "frag.spv", indirectPipelineLayout);
+    if (depthPrepass) {
+        indirectDepthPipeline = BuildGraphicsPipeline(shaderDirectory + "indirect.spv", "", indirectPipelineLayout);
+    }
+}
+
+// Before anything that records the culling or indirect draws of the frame.
+void VkMain::AllocateCullingSets(uint32_t frame) {
+    cullDescriptorSets[frame] = frameDescriptorAllocators[frame].Allocate(cullPipeline.setLayout);
+
+    DescriptorInfo descriptors[3] = {
+        DescriptorInfo(objectBuffers[frame]),
+        DescriptorInfo(drawCommandBuffers[frame]),
+        DescriptorInfo(drawCountBuffers[frame])
+    };
+    VkCompute::WriteSet(device, cullPipeline, cullDescriptorSets[frame], descriptors);
+}
+
+void VkMain::UploadObjectChanges(uint32_t frame) {
+    auto* objects = static_cast<GpuObjectData*>(objectBuffersMapped[frame]);
+    const auto& world = scene.World();
+
+    for (uint32_t i : objectUploads[frame].Indices()) {
+        objects[i] = VkGpuCulling::PackObject(world[i], meshBounds, sceneTextureSlot);
+    }
+
+    objectUploads[frame].Clear();
+}
+
+// The count is cleared by the pass before this one; the graph orders the
+// clear, the dispatch and the indirect draw with barriers.
+void VkMain::RecordGpuCulling(VkCommandBuffer commandBuffer, const glm::mat4& viewProj) {
+    GpuCullConstants constants = VkGpuCulling::MakeConstants(
+        VkCulling::ExtractFrustum(viewProj),
+        objectCount,
+        meshLods[0].indexCount
+    );
+
+    VkCompute::Dispatch(commandBuffer, cullPipeline, cullDescriptorSets[currentFrame], &constants, objectCount);
+}
+
+// The same work on the async compute queue, outside the graph: clear,
+// cull, and make the count readable by ReadGpuCullingStats. The graphics
+// submit waits on the queue's semaphore at the indirect draw stage.
+void VkMain::RecordAsyncGpuCulling(const glm::mat4& viewProj) {
+    VkCommandBuffer commandBuffer = asyncCompute.Begin(currentFrame);
+
+    vkCmdFillBuffer(commandBuffer, drawCountBuffers[currentFrame], 0, sizeof(GpuDrawCounts), 0);
+    VkCompute::Barrier(commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    RecordGpuCulling(commandBuffer, viewProj);
+
+    VkCompute::Barrier(commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+}
+
+void VkMain::RecordIndirectDraws(VkCommandBuffer commandBuffer, const glm::mat4& viewProj, bool depthOnly, DrawPhase phase) {
+    // In bindless mode the pipeline and the global set are already bound.
+    if (!bindless) {
+        drawState.BindPipeline(depthOnly ? indirectDepthPipeline : indirectPipeline);
+        drawState.BindDescriptorSet(indirectPipelineLayout, cullDescriptorSets[currentFrame]);
+        drawState.PushConstants(indirectPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProj);
+    }
+    drawState.BindIndexBuffer(indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (phase != DrawPhase::Late) {
+        drawState.DrawIndexedIndirectCount(
+            drawCommandBuffers[currentFrame], 0,
+            drawCountBuffers[currentFrame], offsetof(GpuDrawCounts, early),
+            objectCount,
+            stride
+        );
+    }
+    if (phase != DrawPhase::Early) {
+        drawState.DrawIndexedIndirectCount(
+            drawCommandBuffers[currentFrame], static_cast<VkDeviceSize>(stride) * objectCount,
+            drawCountBuffers[currentFrame], offsetof(GpuDrawCounts, late),
+            objectCount,
+            stride
+        );
+    }
+}
+
+void VkMain::ReadGpuCullingStats(uint32_t frame) {
+    const auto* counts = static_cast<const GpuDrawCounts*>(drawCountBuffersMapped[frame]);
+    uint32_t visible = counts->early + counts->late;
+    uint64_t trianglesPerObject = meshLods[0].indexCount / 3;
+
+    frameStats.culling.tested = objectCount;
+    frameStats.culling.visible = visible;
+    frameStats.culling.culled = objectCount - visible;
+    frameStats.culling.cpuMs = 0.0;
+    frameStats.culling.occlusion = occlusionCulling;
+    frameStats.culling.occluded = counts->occluded;
+    frameStats.culling.occludedTriangles = counts->occluded * trianglesPerObject;
+    frameStats.culling.lateDraws = counts->late;
+
+    frameStats.lods = LodStats{};
+    frameStats.lods.objects[0] = visible;
+    frameStats.lods.triangles = visible * trianglesPerObject;
+}
+
+void VkMain::DestroyGpuCulling() {
+    for (size_t i = 0; i < drawCommandBuffers.size(); i++) {
+        vkDestroyBuffer(device, drawCommandBuffers[i], nullptr);
+        VkMemory::Free(device, drawCommandBuffersMemory[i]);
+        vkDestroyBuffer(device, drawCountBuffers[i], nullptr);
+        VkMemory::Free(device, drawCountBuffersMemory[i]);
+    }
+
+    vkDestroyPipeline(device, indirectPipeline, nullptr);
+    vkDestroyPipeline(device, indirectDepthPipeline, nullptr);
+    vkDestroyPipelineLayout(device, indirectPipelineLayout, nullptr);
+    // The sets go with frameDescriptorAllocators and the layout with descriptorLayouts.
+    VkCompute::DestroyPipeline(device, cullPipeline);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "VulkanMain/Mesh/Mesh.h"
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/Bindless/Bindless.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// One object as read by cull.comp, indirect.vert and bindless.vert (std430,
+// 96 bytes). Bounds stay in object space; the shader moves them with model.
+// textureIndex is a bindless image slot or VkBindless::INVALID_INDEX.
+struct GpuObjectData {
+    glm::mat4 model;
+    glm::vec4 boundsCenterRadius;
+    glm::vec3 boundsExtents;
+    uint32_t textureIndex;
+};
+
+// Push constants of cull.comp (104 bytes).
+struct GpuCullConstants {
+    glm::vec4 planes[6];
+    uint32_t objectCount;
+    uint32_t indexCount;
+};
+
+// The draw count buffer. cull.comp only counts the early list;
+// occlusion.comp also fills the late list and counts the objects the Hi-Z
+// test hid.
+struct GpuDrawCounts {
+    uint32_t early;
+    uint32_t late;
+    uint32_t occluded;
+    uint32_t padding;
+};
+
+namespace VkGpuCulling {
+    // Must match local_size_x in cull.comp.
+    constexpr uint32_t WORKGROUP_SIZE = 64;
+
+    GpuObjectData PackObject(const glm::mat4& world, const MeshBounds& bounds, uint32_t textureIndex = VkBindless::INVALID_INDEX);
+    GpuCullConstants MakeConstants(const Frustum& frustum, uint32_t objectCount, uint32_t indexCount);
+}
@@ -0,0 +1,143 @@
+#include "VulkanMain/Jobs/Jobs.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    class WorkerPool {
+    public:
+        WorkerPool() {
+            uint32_t hardware = std::max(1u, std::thread::hardware_concurrency());
+            for (uint32_t i = 0; i + 1 < hardware; i++) {
+                workers.emplace_back([this]() { WorkerLoop(); });
+            }
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        uint32_t WorkerCount() const {
+            return static_cast<uint32_t>(workers.size());
+        }
+
+        void Push(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+
+    private:
+        void WorkerLoop() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if (stopping && tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping = false;
+    };
+
+    WorkerPool& Pool() {
+        static WorkerPool pool;
+        return pool;
+    }
+
+    // Shared between the caller and the helper tasks. Helpers may be dequeued
+    // after the caller has returned, so they only touch this block and never
+    // the caller's stack.
+    struct ParallelBatch {
+        const std::function<void(size_t, size_t)>* func = nullptr;
+        size_t count = 0;
+        size_t chunkSize = 0;
+        size_t chunkCount = 0;
+        std::atomic<size_t> nextChunk{ 0 };
+        std::atomic<size_t> doneChunks{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+
+    void RunChunks(ParallelBatch& batch) {
+        size_t chunk;
+        while ((chunk = batch.nextChunk.fetch_add(1)) < batch.chunkCount) {
+            size_t begin = chunk * batch.chunkSize;
+            size_t end = std::min(batch.count, begin + batch.chunkSize);
+            (*batch.func)(begin, end);
+
+            if (batch.doneChunks.fetch_add(1) + 1 == batch.chunkCount) {
+                std::lock_guard<std::mutex> lock(batch.mutex);
+                batch.finished.notify_all();
+            }
+        }
+    }
+}
+
+uint32_t VkJobs::ThreadCount() {
+    return Pool().WorkerCount() + 1;
+}
+
+void VkJobs::ParallelFor
+(
+    size_t count,
+    size_t minBatch,
+    const std::function<void(size_t begin, size_t end)>& func
+)
+{
+    if (count == 0) {
+        return;
+    }
+
+    minBatch = std::max<size_t>(minBatch, 1);
+    size_t threads = ThreadCount();
+    size_t chunkCount = std::min((count + minBatch - 1) / minBatch, threads * 4);
+
+    if (chunkCount <= 1 || threads == 1) {
+        func(0, count);
+        return;
+    }
+
+    auto batch = std::make_shared<ParallelBatch>();
+    batch->func = &func;
+    batch->count = count;
+    batch->chunkSize = (count + chunkCount - 1) / chunkCount;
+    batch->chunkCount = (count + batch->chunkSize - 1) / batch->chunkSize;
+
+    size_t helpers = std::min(threads - 1, batch->chunkCount - 1);
+    for (size_t i = 0; i < helpers; i++) {
+        Pool().Push([batch]() { RunChunks(*batch); });
+    }
+
+    RunChunks(*batch);
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&]() { return batch->doneChunks.load() == batch->chunkCount; });
+}
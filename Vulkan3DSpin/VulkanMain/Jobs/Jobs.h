@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace VkJobs {
+    // Number of worker threads plus the calling thread.
+    uint32_t ThreadCount();
+
+    // Splits [0, count) into chunks of at least minBatch elements and runs them
+    // on the worker pool. The calling thread takes part and returns once every
+    // chunk has finished.
+    void ParallelFor
+    (
+        size_t count,
+        size_t minBatch,
+        const std::function<void(size_t begin, size_t end)>& func
+    );
+}
@@ -0,0 +1,327 @@
+#include "VulkanMain/Lod/Lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+namespace {
+    // Symmetric 4x4 matrix of the plane equations summed into one vertex.
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        void AddPlane(const glm::vec3& n, float d, double weight) {
+            double a = n.x, b = n.y, c = n.z, e = d;
+            a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * e;
+            b2 += weight * b * b; bc += weight * b * c; bd += weight * b * e;
+            c2 += weight * c * c; cd += weight * c * e;
+            d2 += weight * e * e;
+        }
+
+        void Add(const Quadric& q) {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+            b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd;
+            d2 += q.d2;
+        }
+
+        double Evaluate(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double r = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                     + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                     + c2 * z * z + 2 * cd * z
+                     + d2;
+            return std::max(r, 0.0);
+        }
+    };
+
+    struct Collapse {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+    };
+
+    uint64_t EdgeKey(uint32_t a, uint32_t b) {
+        return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+    }
+
+    void BuildQuadrics(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<Quadric>& quadrics) {
+        quadrics.assign(vertices.size(), Quadric{});
+
+        std::unordered_map<uint64_t, uint32_t> edgeUse;
+        edgeUse.reserve(indices.size());
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (int k = 0; k < 3; k++) {
+                edgeUse[EdgeKey(indices[t + k], indices[t + (k + 1) % 3])]++;
+            }
+        }
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const glm::vec3& p0 = vertices[indices[t]].pos;
+            const glm::vec3& p1 = vertices[indices[t + 1]].pos;
+            const glm::vec3& p2 = vertices[indices[t + 2]].pos;
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length <= 0.0f) {
+                continue;
+            }
+            n = n / length;
+
+            for (int k = 0; k < 3; k++) {
+                quadrics[indices[t + k]].AddPlane(n, -glm::dot(n, p0), 1.0);
+            }
+
+            // Open edges get a heavily weighted plane through the edge and
+            // perpendicular to the face, which keeps borders in place.
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = indices[t + k];
+                uint32_t b = indices[t + (k + 1) % 3];
+                if (edgeUse[EdgeKey(a, b)] != 1) {
+                    continue;
+                }
+
+                glm::vec3 edge = vertices[b].pos - vertices[a].pos;
+                glm::vec3 side = glm::cross(edge, n);
+                float sideLength = glm::length(side);
+                if (sideLength <= 0.0f) {
+                    continue;
+                }
+                side = side / sideLength;
+
+                quadrics[a].AddPlane(side, -glm::dot(side, vertices[a].pos), 10.0);
+                quadrics[b].AddPlane(side, -glm::dot(side, vertices[a].pos), 10.0);
+            }
+        }
+    }
+
+    // True if moving vertex from onto to turns any surviving triangle
+    // around from upside down.
+    bool FlipsTriangle
+    (
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        const std::vector<uint32_t>& triangles,
+        uint32_t from,
+        uint32_t to
+    )
+    {
+        for (uint32_t t : triangles) {
+            const uint32_t* tri = &indices[t * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to) {
+                continue;
+            }
+
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++) {
+                before[k] = vertices[tri[k]].pos;
+                after[k] = tri[k] == from ? vertices[to].pos : before[k];
+            }
+
+            glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            if (glm::dot(n0, n1) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+std::vector<uint32_t> VkLod::Simplify
+(
+    const std::vector<Vertex>& vertices,
+    const std::vector<uint32_t>& indices,
+    size_t targetIndexCount,
+    float& error
+)
+{
+    std::vector<uint32_t> result = indices;
+    std::vector<Quadric> quadrics;
+    BuildQuadrics(vertices, indices, quadrics);
+
+    double maxCost = 0.0;
+    std::vector<uint32_t> triangleStart, triangleList;
+    std::vector<Collapse> collapses;
+    std::vector<uint8_t> locked(vertices.size());
+    std::vector<uint32_t> remap(vertices.size());
+
+    while (result.size() > targetIndexCount) {
+        size_t triangleCount = result.size() / 3;
+
+        // vertex -> triangles, as offsets into triangleList
+        triangleStart.assign(vertices.size() + 1, 0);
+        for (uint32_t v : result) {
+            triangleStart[v + 1]++;
+        }
+        for (size_t v = 0; v < vertices.size(); v++) {
+            triangleStart[v + 1] += triangleStart[v];
+        }
+        triangleList.resize(result.size());
+        std::vector<uint32_t> fill(triangleStart.begin(), triangleStart.end() - 1);
+        for (size_t i = 0; i < result.size(); i++) {
+            triangleList[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        // Cheapest direction of every edge, once per edge.
+        collapses.clear();
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++) {
+                uint32_t a = result[t * 3 + k];
+                uint32_t b = result[t * 3 + (k + 1) % 3];
+                if (a > b) {
+                    continue;
+                }
+
+                Quadric q = quadrics[a];
+                q.Add(quadrics[b]);
+                double toB = q.Evaluate(vertices[b].pos);
+                double toA = q.Evaluate(vertices[a].pos);
+                collapses.push_back(toB <= toA ? Collapse{ toB, a, b } : Collapse{ toA, b, a });
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) {
+            return x.cost < y.cost;
+        });
+
+        std::fill(locked.begin(), locked.end(), 0);
+        for (size_t v = 0; v < remap.size(); v++) {
+            remap[v] = static_cast<uint32_t>(v);
+        }
+
+        // Every collapse removes the two triangles on its edge; stop once the
+        // target is reached. Touched neighborhoods are locked for the rest of
+        // the pass so the adjacency above stays valid.
+        size_t removeTriangles = triangleCount - targetIndexCount / 3;
+        size_t removed = 0;
+        size_t applied = 0;
+
+        for (const auto& c : collapses) {
+            if (removed >= removeTriangles) {
+                break;
+            }
+            if (locked[c.from] || locked[c.to]) {
+                continue;
+            }
+
+            std::vector<uint32_t> around(triangleList.begin() + triangleStart[c.from], triangleList.begin() + triangleStart[c.from + 1]);
+            if (FlipsTriangle(vertices, result, around, c.from, c.to)) {
+                continue;
+            }
+
+            for (uint32_t t : around) {
+                const uint32_t* tri = &result[t * 3];
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    removed++;
+                }
+                for (int k = 0; k < 3; k++) {
+                    locked[tri[k]] = 1;
+                }
+            }
+
+            remap[c.from] = c.to;
+            quadrics[c.to].Add(quadrics[c.from]);
+            maxCost = std::max(maxCost, c.cost);
+            applied++;
+        }
+
+        if (applied == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t t = 0; t < triangleCount; t++) {
+            uint32_t a = remap[result[t * 3]];
+            uint32_t b = remap[result[t * 3 + 1]];
+            uint32_t c = remap[result[t * 3 + 2]];
+            if (a == b || b == c || a == c) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    error = static_cast<float>(std::sqrt(maxCost));
+    return result;
+}
+
+std::vector<MeshLod> VkLod::BuildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::vector<MeshLod> lods;
+    lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+    const std::vector<uint32_t> base(indices.begin(), indices.end());
+    size_t previousCount = base.size();
+    float previousError = 0.0f;
+
+    for (uint32_t level = 1; level < MAX_LODS; level++) {
+        size_t target = (base.size() / 3 >> level) * 3;
+        if (target < 3) {
+            break;
+        }
+
+        float error = 0.0f;
+        std::vector<uint32_t> simplified = Simplify(vertices, base, target, error);
+
+        if (simplified.empty() || simplified.size() > previousCount * 9 / 10) {
+            break;
+        }
+
+        previousError = std::max(previousError, error);
+        lods.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(simplified.size()), previousError });
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        previousCount = simplified.size();
+    }
+
+    return lods;
+}
+
+float VkLod::ScreenSpaceError(float error, float distance, float projectionScale) {
+    return error / std::max(distance, 1e-4f) * projectionScale;
+}
+
+float VkLod::DistanceToSphere(const glm::mat4& world, const BoundingSphere& sphere, const glm::vec3& cameraPosition, float& worldScale) {
+    worldScale = std::max({
+        glm::length(glm::vec3(world[0])),
+        glm::length(glm::vec3(world[1])),
+        glm::length(glm::vec3(world[2]))
+    });
+
+    glm::vec3 center = glm::vec3(world * glm::vec4(sphere.center, 1.0f));
+    return std::max(glm::length(center - cameraPosition) - sphere.radius * worldScale, 0.0f);
+}
+
+void LodSelector::Resize(size_t count) {
+    current.resize(count, 0);
+}
+
+uint32_t LodSelector::Select
+(
+    uint32_t index,
+    const std::vector<MeshLod>& lods,
+    float distance,
+    float worldScale,
+    float projectionScale
+)
+{
+    auto pixels = [&](uint32_t level) {
+        return VkLod::ScreenSpaceError(lods[level].error * worldScale, distance, projectionScale);
+    };
+
+    uint32_t lod = std::min<uint32_t>(current[index], static_cast<uint32_t>(lods.size()) - 1);
+
+    while (lod > 0 && pixels(lod) > thresholdPixels * (1.0f + hysteresis)) {
+        lod--;
+    }
+    while (lod + 1 < lods.size() && pixels(lod + 1) <= thresholdPixels * (1.0f - hysteresis)) {
+        lod++;
+    }
+
+    current[index] = static_cast<uint8_t>(lod);
+    return lod;
+}
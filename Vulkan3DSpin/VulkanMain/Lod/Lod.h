@@ -0,0 +1,78 @@
+#pragma once
+#include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Mesh/Mesh.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One level of detail: a range of the mesh index buffer. All levels share
+// the vertex buffer. error is the object-space deviation from LOD 0.
+struct MeshLod {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float error;
+};
+
+namespace VkLod {
+    constexpr uint32_t MAX_LODS = 5;
+
+    // Quadric-error edge collapse down to about targetIndexCount indices.
+    // Vertices only ever collapse onto other existing vertices, so the
+    // result indexes the same vertex buffer. error receives the largest
+    // collapse error, in object-space units.
+    std::vector<uint32_t> Simplify
+    (
+        const std::vector<Vertex>& vertices,
+        const std::vector<uint32_t>& indices,
+        size_t targetIndexCount,
+        float& error
+    );
+
+    // indices holds LOD 0 on entry; each coarser level (half the triangles
+    // of the previous one) is appended to it. Stops early once the
+    // simplifier can no longer reduce the mesh meaningfully.
+    std::vector<MeshLod> BuildLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Size in pixels of an object-space error seen at the given distance.
+    // projectionScale is viewport height / (2 * tan(fovY / 2)).
+    float ScreenSpaceError(float error, float distance, float projectionScale);
+
+    // Distance from the camera to the surface of an object's bounding
+    // sphere; worldScale receives the largest axis scale of world.
+    float DistanceToSphere(const glm::mat4& world, const BoundingSphere& sphere, const glm::vec3& cameraPosition, float& worldScale);
+}
+
+// Objects drawn at each level and triangles submitted in one frame.
+struct LodStats {
+    uint32_t objects[VkLod::MAX_LODS] = {};
+    uint64_t triangles = 0;
+};
+
+// Keeps the current level of every object between frames so that small
+// camera movements around a threshold do not make meshes pop back and forth.
+class LodSelector {
+public:
+    void Resize(size_t count);
+
+    // Coarsest level whose screen-space error stays under thresholdPixels.
+    // A coarser level is only taken once its error is below
+    // thresholdPixels * (1 - hysteresis), and the current level is only left
+    // for a finer one once its error exceeds thresholdPixels * (1 + hysteresis).
+    uint32_t Select
+    (
+        uint32_t index,
+        const std::vector<MeshLod>& lods,
+        float distance,
+        float worldScale,
+        float projectionScale
+    );
+
+    float thresholdPixels = 1.0f;
+    float hysteresis = 0.25f;
+
+private:
+    std::vector<uint8_t> current;
+};
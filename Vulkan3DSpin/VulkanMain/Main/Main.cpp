@@ -1,5 +1,6 @@
 #include "VulkanMain/Main/Main.h"
 #include "VulkanMain/VulkanDebug/VulkanDebug.h"
+#include "VulkanMain/VulkanDebug/Log.h"
 #include "VulkanMain/Utils/Utils.h"
 #include "VulkanMain/Vertex/Vertex.h"
 #include "VulkanMain/Vertex/UBO/Ubo.h"
@@ -8,6 +9,9 @@ void VkMain::CreateInstance() {
     if (VkDebug::enableValidationLayers && !VkUtils::CheckValidationLayerSupport()) {
         throw std::runtime_error("validation layers requested, but not available!");
     }
+    if (VkDebug::enableValidationLayers) {
+        VkLog::Start();
+    }
 
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -21,7 +25,7 @@ void VkMain::CreateInstance() {
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
 
-    auto extensions = VkUtils::GetRequiredExtensions();
+    auto extensions = VkUtils::GetRequiredExtensions(!benchmarking);
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -42,6 +46,7 @@ void VkMain::CreateInstance() {
     if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
         throw std::runtime_error("failed to create instance!");
     }
+    VkDispatch::LoadInstance(instance);
 }
 
 void VkMain::CreateSurface() {
@@ -79,6 +84,16 @@ void VkMain::CreateLogicalDevice() {
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
+    if (asyncComputeEnabled && !indices.computeFamily.has_value()) {
+        std::cout << "No dedicated compute queue family, running compute on the graphics queue" << std::endl;
+        asyncComputeEnabled = false;
+    }
+    if (asyncComputeEnabled) {
+        computeQueueFamily = indices.computeFamily.value();
+        computeSharingFamilies = { indices.graphicsFamily.value(), computeQueueFamily };
+        uniqueQueueFamilies.insert(computeQueueFamily);
+    }
+
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
         VkDeviceQueueCreateInfo queueCreateInfo{};
@@ -89,18 +104,139 @@ void VkMain::CreateLogicalDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // GPU-driven culling needs vkCmdDrawIndexedIndirectCount (core in 1.2)
+    // and multi-draw indirect with firstInstance as the object index.
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &deviceProperties);
+
+    VkPhysicalDeviceVulkan12Features supported12{};
+    supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+    VkPhysicalDeviceFeatures2 supported{};
+    supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        supported.pNext = &supported12;
+    }
+
+    // Dynamic rendering builds on render pass 2 and depth/stencil resolve,
+    // both core in 1.2, so only 1.2 devices take the extension.
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR supportedDynamicRendering{};
+    supportedDynamicRendering.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    bool hasDynamicRendering = deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+        VkUtils::HasDeviceExtension(physicalDevice, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    if (hasDynamicRendering) {
+        supportedDynamicRendering.pNext = supported.pNext;
+        supported.pNext = &supportedDynamicRendering;
+    }
+    vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+
+    if (dynamicRendering && (!hasDynamicRendering || !supportedDynamicRendering.dynamicRendering)) {
+        std::cout << "Dynamic rendering is not supported by this device, using render passes" << std::endl;
+        dynamicRendering = false;
+    }
+
+    if (gpuDrivenCulling &&
+        (!supported12.drawIndirectCount || !supported.features.multiDrawIndirect ||
+         !supported.features.drawIndirectFirstInstance || deviceProperties.limits.maxDrawIndirectCount < objectCount)) {
+        std::cout << "GPU-driven culling is not supported by this device, using CPU culling" << std::endl;
+        gpuDrivenCulling = false;
+    }
+
+    // Both phases and the pyramid between them run in the frame's command
+    // buffer, between the draws.
+    if (occlusionCulling && (!gpuDrivenCulling || asyncComputeEnabled)) {
+        std::cout << "Occlusion culling needs GPU-driven culling on the graphics queue, disabling it" << std::endl;
+        occlusionCulling = false;
+    }
+
+    // Bindless mode needs descriptor indexing (core in 1.2): runtime-sized,
+    // partially bound arrays that can be updated while bound.
+    if (bindless &&
+        (!supported12.runtimeDescriptorArray || !supported12.descriptorBindingPartiallyBound ||
+         !supported12.descriptorBindingVariableDescriptorCount || !supported12.descriptorBindingUpdateUnusedWhilePending ||
+         !supported12.descriptorBindingStorageBufferUpdateAfterBind || !supported12.descriptorBindingSampledImageUpdateAfterBind ||
+         !supported12.shaderSampledImageArrayNonUniformIndexing || !supported.features.shaderStorageBufferArrayDynamicIndexing)) {
+        std::cout << "Descriptor indexing is not supported by this device, using per-frame descriptor sets" << std::endl;
+        bindless = false;
+    }
+
+    if (bindless) {
+        VkPhysicalDeviceVulkan12Properties properties12{};
+        properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &properties12;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+        // Combined image samplers count as both a sampler and a sampled image.
+        bindlessBufferCapacity = std::min({
+            VkBindless::MAX_BUFFERS,
+            properties12.maxDescriptorSetUpdateAfterBindStorageBuffers,
+            properties12.maxPerStageDescriptorUpdateAfterBindStorageBuffers
+        });
+        bindlessImageCapacity = std::min({
+            VkBindless::MAX_IMAGES,
+            properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+            properties12.maxDescriptorSetUpdateAfterBindSamplers,
+            properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            properties12.maxPerStageDescriptorUpdateAfterBindSamplers
+        });
+
+        uint32_t perStage = properties12.maxPerStageUpdateAfterBindResources;
+        if (bindlessBufferCapacity + bindlessImageCapacity > perStage) {
+            bindlessImageCapacity = perStage > bindlessBufferCapacity ? perStage - bindlessBufferCapacity : 0;
+        }
+    }
+
+    // Only used for the fragment counts in the stats line.
+    fragmentStatistics = supported.features.pipelineStatisticsQuery == VK_TRUE;
+
     VkPhysicalDeviceFeatures deviceFeatures{};
+    deviceFeatures.pipelineStatisticsQuery = fragmentStatistics ? VK_TRUE : VK_FALSE;
+    deviceFeatures.multiDrawIndirect = gpuDrivenCulling ? VK_TRUE : VK_FALSE;
+    deviceFeatures.drawIndirectFirstInstance = gpuDrivenCulling ? VK_TRUE : VK_FALSE;
+    deviceFeatures.shaderStorageBufferArrayDynamicIndexing = bindless ? VK_TRUE : VK_FALSE;
+
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.drawIndirectCount = gpuDrivenCulling ? VK_TRUE : VK_FALSE;
+    features12.runtimeDescriptorArray = bindless ? VK_TRUE : VK_FALSE;
+    features12.descriptorBindingPartiallyBound = bindless ? VK_TRUE : VK_FALSE;
+    features12.descriptorBindingVariableDescriptorCount = bindless ? VK_TRUE : VK_FALSE;
+    features12.descriptorBindingUpdateUnusedWhilePending = bindless ? VK_TRUE : VK_FALSE;
+    features12.descriptorBindingStorageBufferUpdateAfterBind = bindless ? VK_TRUE : VK_FALSE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = bindless ? VK_TRUE : VK_FALSE;
+    features12.shaderSampledImageArrayNonUniformIndexing = bindless ? VK_TRUE : VK_FALSE;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = deviceProperties.apiVersion >= VK_API_VERSION_1_2 ? &features12 : nullptr;
+
+    // Nothing is presented when benchmarking, so no swapchain extension.
+    std::vector<const char*> enabledExtensions = benchmarking ? std::vector<const char*>() : deviceExtensions;
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    if (dynamicRendering) {
+        enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+        dynamicRenderingFeatures.pNext = const_cast<void*>(createInfo.pNext);
+        createInfo.pNext = &dynamicRenderingFeatures;
+    }
+    // Budgets come from the driver when it can tell; otherwise VkMemory
+    // estimates them from the heap sizes.
+    bool memoryBudget = VkUtils::HasDeviceExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudget) {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (VkDebug::enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(VkDebug::validationLayers.size());
@@ -113,9 +249,25 @@ void VkMain::CreateLogicalDevice() {
     if (vkCreateDevice(physicalDevice, &createInfo, nullptr, &device) != VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
     }
+    if (directDispatch) {
+        VkDispatch::LoadDevice(device, deviceDispatch);
+        VkDispatch::Use(deviceDispatch);
+    }
+    VkMemory::Init(physicalDevice, memoryBudget);
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    if (asyncComputeEnabled) {
+        vkGetDeviceQueue(device, computeQueueFamily, 0, &computeQueue);
+    }
+
+    if (dynamicRendering) {
+        cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+        cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+        if (cmdBeginRendering == nullptr || cmdEndRendering == nullptr) {
+            throw std::runtime_error("failed to load dynamic rendering commands!");
+        }
+    }
 }
 
 void VkMain::CreateSwapChain() {
@@ -141,6 +293,17 @@ void VkMain::CreateSwapChain() {
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
+    // Frame capture copies out of the swapchain images.
+    if (!captureDirectory.empty()) {
+        if ((swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) && VkCapture::SupportsFormat(surfaceFormat.format)) {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        }
+        else {
+            std::cout << "Swapchain images cannot be copied out, frame capture disabled" << std::endl;
+            captureDirectory.clear();
+        }
+    }
+
     QueueFamilyIndices indices = VkUtils::FindQueueFamilies(physicalDevice, surface);
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
 
@@ -206,61 +369,52 @@ void VkMain::CreateImageViews() {
     }
 }
 
-void VkMain::CreateRenderPass() {
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = swapChainImageFormat;
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &colorAttachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create render pass!");
-    }
-}
-
 void VkMain::CreateGraphicsPipeline() {
     // DescriptorSetLayout
     assert(descriptorSetLayout != VK_NULL_HANDLE && //X߰
         "descriptorSetLayout is VK_NULL_HANDLE(CreateDescriptorSetLayout not called ? )");
 
-    auto vertShaderCode = VkUtils::ReadFile("C:/Users/kym10/source/repos/Vulkan3DEngine/Vulkan3DEngine/VulkanMain/Shader/vert.spv");
-    auto fragShaderCode = VkUtils::ReadFile("C:/Users/kym10/source/repos/Vulkan3DEngine/Vulkan3DEngine/VulkanMain/Shader/frag.spv"); //link shader
+    // 1.  Push Constant  մϴ.
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;  
+    pushConstantRange.size = 64;                              
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+    // pPushConstantRanges nullptr ƴ 
+    assert(pipelineLayoutInfo.pPushConstantRanges != nullptr && "ERROR: PushConstantRange pointer is NULL!");
+    assert(pipelineLayoutInfo.pushConstantRangeCount > 0 && "ERROR: PushConstantRange count is 0!");
+
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline layout!");
+    }
+
+    graphicsPipeline = BuildGraphicsPipeline(shaderDirectory + "vert.spv", shaderDirectory + "frag.spv", pipelineLayout);
+    if (depthPrepass) {
+        depthPipeline = BuildGraphicsPipeline(shaderDirectory + "vert.spv", "", pipelineLayout);
+    }
+}
+
+VkPipeline VkMain::BuildGraphicsPipeline(const std::string& vertPath, const std::string& fragPath, VkPipelineLayout layout) {
+    bool depthOnly = fragPath.empty();
+    uint32_t graphPass = depthOnly ? depthPrepassPass : forwardPass;
+
+    auto vertShaderCode = VkStartup::ReadShader(vertPath);
 
     auto bindingDesc = Vertex::GetBindingDescription();
     auto attrDesc = Vertex::GetAttributeDescriptions();
 
     VkShaderModule vertShaderModule = VkUtils::CreateShaderModule(device, vertShaderCode);
-    VkShaderModule fragShaderModule = VkUtils::CreateShaderModule(device, fragShaderCode);
+    VkShaderModule fragShaderModule = VK_NULL_HANDLE;
+    if (!depthOnly) {
+        fragShaderModule = VkUtils::CreateShaderModule(device, VkStartup::ReadShader(fragPath));
+    }
 
     VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
     vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -309,6 +463,17 @@ void VkMain::CreateGraphicsPipeline() {
     multisampling.sampleShadingEnable = VK_FALSE;
     multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
+    // After a pre-pass the depth buffer is final: the color pass only tests
+    // for the surface that won and leaves the buffer alone.
+    bool equalTest = depthPrepass && !depthOnly;
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = equalTest ? VK_FALSE : VK_TRUE;
+    depthStencil.depthCompareOp = equalTest ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
+    depthStencil.depthBoundsTestEnable = VK_FALSE;
+    depthStencil.stencilTestEnable = VK_FALSE;
+
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
     colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     colorBlendAttachment.blendEnable = VK_FALSE;
@@ -317,7 +482,7 @@ void VkMain::CreateGraphicsPipeline() {
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable = VK_FALSE;
     colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount = 1;
+    colorBlending.attachmentCount = depthOnly ? 0 : 1;
     colorBlending.pAttachments = &colorBlendAttachment;
     colorBlending.blendConstants[0] = 0.0f;
     colorBlending.blendConstants[1] = 0.0f;
@@ -333,65 +498,63 @@ void VkMain::CreateGraphicsPipeline() {
     dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
     dynamicState.pDynamicStates = dynamicStates.data();
 
-    // 1.  Push Constant  մϴ.
-    VkPushConstantRange pushConstantRange{};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstantRange.offset = 0;  
-    pushConstantRange.size = 64;                              
-
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 1;
-    pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-    // pPushConstantRanges nullptr ƴ 
-    assert(pipelineLayoutInfo.pPushConstantRanges != nullptr && "ERROR: PushConstantRange pointer is NULL!");
-    assert(pipelineLayoutInfo.pushConstantRangeCount > 0 && "ERROR: PushConstantRange count is 0!");
-
-    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
+    // Without a render pass the pipeline names the formats it renders to.
+    const std::vector<VkFormat>& colorFormats = frameGraph.ColorFormats(graphPass);
+    VkPipelineRenderingCreateInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+    renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorFormats.size());
+    renderingInfo.pColorAttachmentFormats = colorFormats.data();
+    renderingInfo.depthAttachmentFormat = frameGraph.DepthFormat(graphPass);
 
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
+    pipelineInfo.pNext = frameGraph.DynamicRendering() ? &renderingInfo : nullptr;
+    pipelineInfo.stageCount = depthOnly ? 1 : 2;
     pipelineInfo.pStages = shaderStages;
     pipelineInfo.pVertexInputState = &vertexInputInfo;
     pipelineInfo.pInputAssemblyState = &inputAssembly;
     pipelineInfo.pViewportState = &viewportState;
     pipelineInfo.pRasterizationState = &rasterizer;
     pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
     pipelineInfo.pColorBlendState = &colorBlending;
     pipelineInfo.pDynamicState = &dynamicState;
-    pipelineInfo.layout = pipelineLayout;
-    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.layout = layout;
+    pipelineInfo.renderPass = frameGraph.RenderPass(graphPass);
     pipelineInfo.subpass = 0;
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
     vkDestroyShaderModule(device, fragShaderModule, nullptr);
     vkDestroyShaderModule(device, vertShaderModule, nullptr);
+
+    return pipeline;
 }
 
 void VkMain::CreateDescriptorPool()
 {
-    VkDescriptorPoolSize poolSize{};
-    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-    poolSize.descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    assert(device != VK_NULL_HANDLE);
+
+    // The UBO sets live as long as the renderer. The culling and Hi-Z sets
+    // are rewritten every frame from that frame's allocator, which DrawFrame
+    // resets once the frame's fence has signaled.
+    std::vector<DescriptorAllocator::PoolRatio> ratios = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f }
+    };
 
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = 1;
-    poolInfo.pPoolSizes = &poolSize;
-    poolInfo.maxSets = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
+    descriptorAllocator.Init(device, static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT), ratios);
 
-    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
+    frameDescriptorAllocators.resize(MAX_FRAMES_IN_FLIGHT);
+    for (auto& allocator : frameDescriptorAllocators) {
+        allocator.Init(device, 16, ratios);
     }
 }
 
@@ -405,14 +568,11 @@ void VkMain::CreateDescriptorSetLayout()
     uboLayoutBinding.descriptorCount = 1;
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = 1;
-    layoutInfo.pBindings = &uboLayoutBinding;
+    std::vector<VkDescriptorSetLayoutBinding> bindings = { uboLayoutBinding };
 
-    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor set layout!");
-    }
+    descriptorLayouts.Init(device);
+    descriptorSetLayout = descriptorLayouts.Get(bindings);
+    uboUpdateTemplate = VkDescriptors::CreateUpdateTemplate(device, descriptorSetLayout, bindings);
 }
 
 void VkMain::CreateDescriptorSets()
@@ -421,45 +581,28 @@ void VkMain::CreateDescriptorSets()
     assert(descriptorSetLayout != VK_NULL_HANDLE);
     descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
 
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT); // 2
-    allocInfo.pSetLayouts = layouts.data(); // 2 ̾ƿ ּ
-
-    // 2.  ۿ   Ҵ ( 2 Ѳ ä)
-    if (vkAllocateDescriptorSets(device, &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-
     for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) 
     {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = uniformBuffers[i];
-        bufferInfo.offset = 0;
-        bufferInfo.range = sizeof(UBO);
-
-        VkWriteDescriptorSet write{};
-        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        write.dstSet = descriptorSets[i];
-        write.dstBinding = 0;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-        write.descriptorCount = 1;
-        write.pBufferInfo = &bufferInfo;
+        descriptorSets[i] = descriptorAllocator.Allocate(descriptorSetLayout);
 
-        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+        DescriptorInfo ubo(uniformBuffers[i], 0, sizeof(UBO));
+        vkUpdateDescriptorSetWithTemplate(device, descriptorSets[i], uboUpdateTemplate, &ubo);
     }
 }
 
-void VkMain::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+void VkMain::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category, VkBuffer& buffer, VkDeviceMemory& bufferMemory, bool sharedWithCompute) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    if (sharedWithCompute && asyncComputeEnabled) {
+        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(computeSharingFamilies.size());
+        bufferInfo.pQueueFamilyIndices = computeSharingFamilies.data();
+    }
+
     if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to create buffer!");
     }
@@ -472,7 +615,7 @@ void VkMain::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
     allocInfo.allocationSize = memRequirements.size;
     allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits, properties);
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+    if (VkMemory::Allocate(device, allocInfo, category, bufferMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate buffer memory!");
     }
 
@@ -480,29 +623,6 @@ void VkMain::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryP
 }
 
 
-void VkMain::CreateFramebuffers() {
-    swapChainFramebuffers.resize(swapChainImageViews.size());
-
-    for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-        VkImageView attachments[] = {
-            swapChainImageViews[i]
-        };
-
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = renderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = swapChainExtent.width;
-        framebufferInfo.height = swapChainExtent.height;
-        framebufferInfo.layers = 1;
-
-        if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &swapChainFramebuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create framebuffer!");
-        }
-    }
-}
-
 void VkMain::CreateCommandPool() {
     QueueFamilyIndices queueFamilyIndices = VkUtils::FindQueueFamilies(physicalDevice, surface);
 
@@ -545,48 +665,22 @@ void VkMain::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = renderPass;
-    renderPassInfo.framebuffer = swapChainFramebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = swapChainExtent;
-
-    VkClearValue clearColor = { {{0.1f, 0.1f, 0.4f, 1.0f}} };
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = &clearColor;
-
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    assert(graphicsPipeline != VK_NULL_HANDLE && "ERROR: Graphics Pipeline is NULL!");
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-
-    // 2. Descriptor Set ε Ȯ (̰    Ȯ 99%)
-    assert(descriptorSets[currentFrame] != VK_NULL_HANDLE && "ERROR: Descriptor Set is NULL!");
-    assert(pipelineLayout != VK_NULL_HANDLE && "ERROR: Pipeline Layout is NULL!");
-
-    VkBuffer vertexBuffers[] = { vertexBuffer };
-    VkDeviceSize offsets[] = { 0 };
-
-    vkCmdBindVertexBuffers(
-        commandBuffer,
-        0,      // binding = 0
-        1,
-        vertexBuffers,
-        offsets
-    );
+    // Queries are reset outside the render passes; the forward passes fill them.
+    if (fragmentQueryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, fragmentQueryPool, currentFrame * 2, 2);
+    }
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool, currentFrame * TIMESTAMPS_PER_FRAME, TIMESTAMPS_PER_FRAME);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, currentFrame * TIMESTAMPS_PER_FRAME);
+    }
+    StreamTextures(commandBuffer);
 
     UBO constants;
-    float time = static_cast<float>(glfwGetTime());
+    float time = static_cast<float>(FrameTime());
     //glm̳  ִ°
 
-    glm::mat4 model = glm::mat4(1.0f);
     // ð  Z ߽ ʴ  90 ȸ
-    model = glm::rotate (
-        model, 
-        time * glm::radians(90.0f), 
-        glm::vec3(0.0f, 0.0f, 1.0f)
-    );
+    scene.SetRotation(0, glm::angleAxis(time * glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
     // (ʿ ) ü ũ⸦ ϰų ġ ̵ų  
     // model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f)); 
 
@@ -608,7 +702,33 @@ void VkMain::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
 
     proj[1][1] *= -1;
 
-    constants.mvp = proj * view * model;
+    glm::mat4 viewProj = proj * view;
+    Frustum frustum = VkCulling::ExtractFrustum(viewProj);
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+
+    // Only nodes touched since the last frame are rebuilt, and only those
+    // reach the culling bounds and the GPU object buffers.
+    auto sceneStart = std::chrono::steady_clock::now();
+    frameStats.scene = SceneStats{};
+    frameStats.scene.nodes = static_cast<uint32_t>(scene.Size());
+    frameStats.scene.updated = static_cast<uint32_t>(scene.Update());
+
+    if (!objectBuffers.empty()) {
+        for (auto& uploads : objectUploads) {
+            uploads.Add(scene.Changed());
+        }
+        frameStats.scene.uploaded = static_cast<uint32_t>(objectUploads[currentFrame].Indices().size());
+        UploadObjectChanges(currentFrame);
+    }
+    if (!gpuDrivenCulling) {
+        culling.UpdateWorldBounds(scene.World(), scene.Changed());
+    }
+    frameStats.scene.cpuMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sceneStart).count();
+
+    if (!gpuDrivenCulling) {
+        frameStats.culling = culling.Cull(frustum, visibleObjects);
+    }
+    constants.mvp = viewProj * scene.World()[0];
 
     void* data;
     // uniformBuffersMemory[currentFrame] CreateDescriptorSets   ޸𸮿 մϴ.
@@ -616,15 +736,83 @@ void VkMain::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
         memcpy(data, &constants, sizeof(constants));
     vkUnmapMemory(device, uniformBuffersMemory[currentFrame]);
 
-    vkCmdPushConstants(
-        commandBuffer,
-        pipelineLayout,             // CreateGraphicsPipeline   ̾ƿ
-        VK_SHADER_STAGE_VERTEX_BIT, // ̴ ġؾ 
-        0,                          // 
-        sizeof(UBO),  //  ũ (64Ʈ)
-        &constants                  //   ּ
-    );
+    // The CPU path sorts its draw list up front; the forward pass only
+    // records it.
+    if (!gpuDrivenCulling) {
+        float projectionScale = 0.5f * static_cast<float>(swapChainExtent.height) * std::fabs(proj[1][1]);
+        BuildDrawList(frustum, cameraPosition, projectionScale);
+        if (!bindless) {
+            VkTransform::ComputeMvps(viewProj, scene.World(), visibleObjects, objectMvps);
+        }
+    }
+
+    frameViewProj = viewProj;
+    if (gpuDrivenCulling) {
+        AllocateCullingSets(currentFrame);
+    }
+    if (occlusionCulling) {
+        AllocateOcclusionSets(currentFrame);
+    }
+    if (gpuDrivenCulling && asyncComputeEnabled) {
+        RecordAsyncGpuCulling(viewProj);
+    }
+    frameGraph.SetImage(backbufferResource, swapChainImages[imageIndex], swapChainImageViews[imageIndex]);
+    if (frameCapture.Active()) {
+        captureThisFrame = frameCapture.Begin(frameStats.frame, currentFrame);
+        frameGraph.SetBuffer(captureResource, frameCapture.Buffer());
+    }
+    if (gpuDrivenCulling) {
+        frameGraph.SetBuffer(drawCommandsResource, drawCommandBuffers[currentFrame]);
+        frameGraph.SetBuffer(drawCountResource, drawCountBuffers[currentFrame]);
+    }
+    if (occlusionCulling) {
+        frameGraph.SetImage(hizResource, hizImages[currentFrame], hizViews[currentFrame]);
+        frameGraph.SetBuffer(visibilityResource, visibilityBuffer);
+    }
+    frameGraph.Execute(commandBuffer);
+
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, currentFrame * TIMESTAMPS_PER_FRAME + 1);
+    }
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+// Runs inside the render pass the graph begins for the forward pass.
+void VkMain::RecordForwardPass(VkCommandBuffer commandBuffer, DrawPhase phase) {
+    assert(graphicsPipeline != VK_NULL_HANDLE && "ERROR: Graphics Pipeline is NULL!");
+    assert(descriptorSets[currentFrame] != VK_NULL_HANDLE && "ERROR: Descriptor Set is NULL!");
+    assert(pipelineLayout != VK_NULL_HANDLE && "ERROR: Pipeline Layout is NULL!");
+
+    SetFrameViewport(commandBuffer);
 
+    // Pipeline, descriptor set and buffer binds all go through drawState,
+    // which drops the ones that would not change anything. After a depth
+    // pre-pass it still holds that pass's binds; they outlive the render
+    // pass, so only the pipelines change here. The late pass of occlusion
+    // culling follows compute work and binds everything again.
+    if (phase == DrawPhase::Late) {
+        drawState.Invalidate();
+    }
+    else if (!depthPrepass) {
+        drawState.Begin(commandBuffer);
+    }
+
+    uint32_t query = currentFrame * 2 + (phase == DrawPhase::Late ? 1 : 0);
+    if (fragmentQueryPool != VK_NULL_HANDLE) {
+        vkCmdBeginQuery(commandBuffer, fragmentQueryPool, query, 0);
+    }
+    RecordDraws(commandBuffer, false, phase);
+    if (fragmentQueryPool != VK_NULL_HANDLE) {
+        vkCmdEndQuery(commandBuffer, fragmentQueryPool, query);
+    }
+
+    frameStats.state = drawState.Stats();
+}
+
+void VkMain::SetFrameViewport(VkCommandBuffer commandBuffer) {
     VkViewport viewport{};
     viewport.x = 0.0f;
     viewport.y = 0.0f;
@@ -638,27 +826,19 @@ void VkMain::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIn
     scissor.offset = { 0, 0 };
     scissor.extent = swapChainExtent;
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
 
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
-
-    uint32_t dynamicOffset = 0;
-    vkCmdBindDescriptorSets(
-        commandBuffer,
-        VK_PIPELINE_BIND_POINT_GRAPHICS,
-        pipelineLayout,
-        0,
-        1,
-        &descriptorSets[currentFrame], //  ̰ Ʋ?
-        1, 
-        &dynamicOffset
-    );
-
-    vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
-
-    vkCmdEndRenderPass(commandBuffer);
-
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to record command buffer!");
+// The frame's draws, with the depth-only pipelines for the pre-pass.
+void VkMain::RecordDraws(VkCommandBuffer commandBuffer, bool depthOnly, DrawPhase phase) {
+    if (gpuDrivenCulling) {
+        if (bindless) {
+            BindBindless(frameViewProj, depthOnly);
+        }
+        drawState.BindVertexBuffer(vertexBuffer);
+        RecordIndirectDraws(commandBuffer, frameViewProj, depthOnly, phase);
+    }
+    else {
+        RecordDrawList(frameViewProj, depthOnly);
     }
 }
 
@@ -670,17 +850,11 @@ uint32_t VkMain::FindMemoryType(
     VkPhysicalDeviceMemoryProperties memProperties;
     vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        bool typeSupported = typeFilter & (1 << i);
-        bool hasProperties =
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties;
-
-        if (typeSupported && hasProperties) {
-            return i;
-        }
+    std::optional<uint32_t> memoryType = VkUtils::FindMemoryType(memProperties, typeFilter, properties);
+    if (!memoryType) {
+        throw std::runtime_error("failed to find suitable memory type!");
     }
-
-    throw std::runtime_error("failed to find suitable memory type!");
+    return *memoryType;
 }
 
 void VkMain::CreateVertexBuffer() { //CreateBuffer
@@ -708,7 +882,7 @@ void VkMain::CreateVertexBuffer() { //CreateBuffer
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
         );
 
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &vertexBufferMemory) != VK_SUCCESS) {
+    if (VkMemory::Allocate(device, allocInfo, MemoryCategory::Geometry, vertexBufferMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate vertex buffer memory!");
     }
 
@@ -720,6 +894,51 @@ void VkMain::CreateVertexBuffer() { //CreateBuffer
     vkUnmapMemory(device, vertexBufferMemory);
 }
 
+void VkMain::CreateIndexBuffer() {
+    VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+
+    CreateBuffer(
+        bufferSize,
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        MemoryCategory::Geometry,
+        indexBuffer,
+        indexBufferMemory
+    );
+
+    void* data;
+    vkMapMemory(device, indexBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(data, indices.data(), (size_t)bufferSize);
+    vkUnmapMemory(device, indexBufferMemory);
+}
+
+void VkMain::CreateSceneObjects() {
+    // Square grid on the z = 0 plane; object 0 is the one that spins and sits
+    // at the origin when it is alone.
+    const float spacing = 1.5f;
+    uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(objectCount))));
+
+    scene.Clear();
+    for (uint32_t i = 0; i < objectCount; i++) {
+        float x = (static_cast<float>(i % side) - static_cast<float>(side / 2)) * spacing;
+        float y = (static_cast<float>(i / side) - static_cast<float>(side / 2)) * spacing;
+        scene.AddNode(SceneGraph::NO_PARENT, glm::vec3(x, y, 0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+    }
+
+    culling.Resize(scene.Size());
+    lodSelector.Resize(scene.Size());
+    objectMvps.assign(scene.Size(), glm::mat4(1.0f));
+    for (uint32_t i = 0; i < objectCount; i++) {
+        culling.SetLocalBounds(i, meshBounds);
+    }
+
+    // Every node starts dirty; build them all once here so the first frame
+    // only pays for what it animates.
+    scene.Update();
+    culling.UpdateWorldBounds(scene.World());
+}
+
 void VkMain::CreateUniformBuffers()
 {
     assert(device != VK_NULL_HANDLE);
@@ -737,6 +956,7 @@ void VkMain::CreateUniformBuffers()
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            MemoryCategory::Uniform,
             uniformBuffers[i],
             uniformBuffersMemory[i]
         );
@@ -787,10 +1007,31 @@ void VkMain::UpdateUniformBuffer(uint32_t currentImage) {
 }
 
 void VkMain::DrawFrame() {
+    auto frameStart = std::chrono::steady_clock::now();
+
     vkWaitForFences(device, 1, &inFlightFence[currentFrame], VK_TRUE, UINT64_MAX); //e
 
-    uint32_t imageIndex;
-    vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    if (gpuDrivenCulling) {
+        ReadGpuCullingStats(currentFrame);
+    }
+    ReadFragmentQueries(currentFrame);
+    ReadTimestampQueries(currentFrame);
+    if (frameCapture.Active()) {
+        frameCapture.Collect(currentFrame);
+        frameStats.capture = frameCapture.Stats();
+    }
+
+    // Texture streaming reads the budget from here.
+    VkMemory::Query(frameStats.memory);
+
+    // The GPU is done with the sets this frame recorded last time.
+    frameDescriptorAllocators[currentFrame].Reset();
+
+    // Offscreen targets are used in frame order.
+    uint32_t imageIndex = currentFrame;
+    if (!benchmarking) {
+        vkAcquireNextImageKHR(device, swapChain, UINT64_MAX, imageAvailableSemaphore[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    }
 
 	if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) { //stacked frame
         vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
@@ -800,14 +1041,27 @@ void VkMain::DrawFrame() {
     vkResetFences(device, 1, &inFlightFence[currentFrame]);
     UpdateUniformBuffer(currentFrame);
     vkResetCommandBuffer(commandBuffer[currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
+    auto recordStart = std::chrono::steady_clock::now();
     RecordCommandBuffer(commandBuffer[currentFrame], imageIndex);
+    frameStats.recordMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordStart).count();
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = { imageAvailableSemaphore[currentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
+    // Async compute goes first; the draws wait for its indirect commands.
+    VkSemaphore waitSemaphores[2];
+    VkPipelineStageFlags waitStages[2];
+    if (!benchmarking) {
+        waitSemaphores[submitInfo.waitSemaphoreCount] = imageAvailableSemaphore[currentFrame];
+        waitStages[submitInfo.waitSemaphoreCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    if (asyncComputeEnabled) {
+        VkSemaphore computeDone = asyncCompute.Submit(currentFrame);
+        if (computeDone != VK_NULL_HANDLE) {
+            waitSemaphores[submitInfo.waitSemaphoreCount] = computeDone;
+            waitStages[submitInfo.waitSemaphoreCount++] = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        }
+    }
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
@@ -815,26 +1069,44 @@ void VkMain::DrawFrame() {
     submitInfo.pCommandBuffers = &commandBuffer[currentFrame];
 
     VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[imageIndex] };
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = benchmarking ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFence[currentFrame]) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    if (!benchmarking) {
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
 
-    VkSwapchainKHR swapChains[] = { swapChain };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
+        VkSwapchainKHR swapChains[] = { swapChain };
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
 
-    presentInfo.pImageIndices = &imageIndex;
+        presentInfo.pImageIndices = &imageIndex;
 
-    vkQueuePresentKHR(presentQueue, &presentInfo);
+        vkQueuePresentKHR(presentQueue, &presentInfo);
+    }
 
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+
+    frameStats.frame++;
+    frameStats.cpuFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    if (frameStats.frame == 1) {
+        startup.firstFrameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+        if (!benchmarking) {
+            std::cout << VkStartup::Format(startup, VkUtils::GetEnvFlag("VK3D_STARTUP_PROFILE")) << std::endl;
+        }
+    }
+
+    // The benchmark reports through its JSON instead.
+    double now = FrameTime();
+    if (!benchmarking && now - lastStatsReport >= 1.0) {
+        std::cout << VkStats::Format(frameStats) << std::endl;
+        lastStatsReport = now;
+    }
 }
\ No newline at end of file
@@ -1,11 +1,28 @@
 #pragma once
 #define GLFW_INCLUDE_VULKAN
+#include "VulkanMain/Dispatch/Dispatch.h"
 #include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Scene/Scene.h"
+#include "VulkanMain/Mesh/Mesh.h"
+#include "VulkanMain/Mesh/MeshFile.h"
+#include "VulkanMain/Meshlet/Meshlet.h"
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/Benchmark/Benchmark.h"
+#include "VulkanMain/Bindless/Bindless.h"
+#include "VulkanMain/Capture/Capture.h"
+#include "VulkanMain/Compute/Compute.h"
+#include "VulkanMain/Descriptors/Descriptors.h"
+#include "VulkanMain/DrawList/DrawList.h"
+#include "VulkanMain/Occlusion/Occlusion.h"
+#include "VulkanMain/RenderGraph/RenderGraph.h"
+#include "VulkanMain/Texture/Texture.h"
+#include "VulkanMain/Memory/Memory.h"
+#include "VulkanMain/Stats/Stats.h"
+#include "VulkanMain/Startup/Startup.h"
 
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <vulkan/vulkan.h>
 
 #include <iostream>
 #include <fstream>
@@ -20,17 +37,32 @@
 #include <set>
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <string>
 
 class VkMain {
 public:
     void run() 
     {
+        startupBegin = std::chrono::steady_clock::now();
         InitWindow();
         InitVulkan();
         MainLoop();
         Cleanup();
     }
 
+    // Headless on a simulated clock; see Benchmark.h.
+    void runBenchmark(const BenchmarkConfig& config, BenchmarkResult& result)
+    {
+        benchmarking = true;
+        benchmark = config;
+        startupBegin = std::chrono::steady_clock::now();
+        InitVulkan();
+        BenchmarkLoop(result);
+        Cleanup();
+    }
+
 private:
     void InitWindow();
     void InitVulkan();
@@ -44,30 +76,102 @@ private:
     void CreateLogicalDevice();
     void CreateSwapChain();
     void CreateImageViews();
-    void CreateRenderPass();
     void CreateGraphicsPipeline();
+    // An empty fragPath builds the depth-only variant for the depth pre-pass.
+    VkPipeline BuildGraphicsPipeline(const std::string& vertPath, const std::string& fragPath, VkPipelineLayout layout);
     void CreateDescriptorPool();
     void CreateDescriptorSetLayout();
-    void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    // sharedWithCompute: also used by the async compute queue.
+    void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, MemoryCategory category, VkBuffer& buffer, VkDeviceMemory& bufferMemory, bool sharedWithCompute = false);
     void CreateDescriptorSets();
-    void CreateFramebuffers();
     void CreateCommandPool();
     void CreateCommandBuffer();
     void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    // phase picks the GPU-driven draw lists; the CPU paths ignore it.
+    void RecordForwardPass(VkCommandBuffer commandBuffer, DrawPhase phase);
+    void SetFrameViewport(VkCommandBuffer commandBuffer);
+    void RecordDraws(VkCommandBuffer commandBuffer, bool depthOnly, DrawPhase phase);
+    // Fills vertices, indices, meshlets, LODs and bounds; CPU only, so it
+    // runs on a startup worker.
+    void BuildMesh();
     void CreateVertexBuffer();
+    void CreateIndexBuffer();
+    void CreateSceneObjects();
 	void CreateUniformBuffers();
     void CreateSyncObjects();
 	void UpdateUniformBuffer(uint32_t currentImage);
 	void DrawFrame();
 
-    GLFWwindow* window;
+    // GpuCulling.cpp
+    void CreateObjectBuffers();
+    void DestroyObjectBuffers();
+    void CreateGpuCulling();
+    void AllocateCullingSets(uint32_t frame);
+    void UploadObjectChanges(uint32_t frame);
+    void RecordGpuCulling(VkCommandBuffer commandBuffer, const glm::mat4& viewProj);
+    void RecordAsyncGpuCulling(const glm::mat4& viewProj);
+    void RecordIndirectDraws(VkCommandBuffer commandBuffer, const glm::mat4& viewProj, bool depthOnly, DrawPhase phase);
+    void ReadGpuCullingStats(uint32_t frame);
+    void DestroyGpuCulling();
+
+    // Occlusion.cpp
+    void CreateOcclusionCulling();
+    void AllocateOcclusionSets(uint32_t frame);
+    void RecordHiZ(VkCommandBuffer commandBuffer);
+    void RecordOcclusionCulling(VkCommandBuffer commandBuffer, DrawPhase phase);
+    void DestroyOcclusionCulling();
+
+    // Bindless.cpp
+    void CreateBindless();
+    void BindBindless(const glm::mat4& viewProj, bool depthOnly);
+    void DestroyBindless();
+
+    // DrawList.cpp
+    void BuildDrawList(const Frustum& frustum, const glm::vec3& cameraPosition, float projectionScale);
+    void RecordDrawList(const glm::mat4& viewProj, bool depthOnly);
+
+    // Depth.cpp
+    void RecordDepthPrepass(VkCommandBuffer commandBuffer, DrawPhase phase);
+    void CreateFragmentQueries();
+    void ReadFragmentQueries(uint32_t frame);
+    void DestroyFragmentQueries();
+
+    // Texture.cpp
+    void CreateTextures();
+    void StreamTextures(VkCommandBuffer commandBuffer);
+    void DestroyTextures();
+
+    // Capture.cpp
+    void CreateCapture();
+    void RecordCapture(VkCommandBuffer commandBuffer);
+
+    // RenderGraph.cpp
+    void CreateRenderGraph();
+
+    // Benchmark.cpp
+    void CreateOffscreenTargets();
+    void DestroyOffscreenTargets();
+    void CreateTimestampQueries();
+    void ReadTimestampQueries(uint32_t frame);
+    void DestroyTimestampQueries();
+    // Seconds the animation runs on: glfwGetTime(), or frames times the
+    // benchmark's fixed step.
+    double FrameTime() const;
+    void BenchmarkLoop(BenchmarkResult& result);
+
+    GLFWwindow* window = nullptr;
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
-    VkSurfaceKHR surface;
+    // VK_NULL_HANDLE when benchmarking; nothing is presented then.
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device;
+    // Device-level entry points come straight from the driver through
+    // vkGetDeviceProcAddr; VK3D_LOADER_DISPATCH keeps the loader's trampolines.
+    bool directDispatch = true;
+    DeviceDispatch deviceDispatch;
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
@@ -77,9 +181,7 @@ private:
     VkFormat swapChainImageFormat;
     VkExtent2D swapChainExtent;
     std::vector<VkImageView> swapChainImageViews;
-    std::vector<VkFramebuffer> swapChainFramebuffers;
 
-    VkRenderPass renderPass;
     VkPipelineLayout pipelineLayout;
     VkPipeline graphicsPipeline;
 
@@ -95,6 +197,99 @@ private:
     VkDeviceMemory vertexBufferMemory;
     std::vector<Vertex> vertices;
 
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+    std::vector<uint32_t> indices;
+
+    // === Objects ===
+    MeshBounds meshBounds{};
+    MeshletData meshlets;
+    std::vector<MeshLod> meshLods;
+    LodSelector lodSelector;
+    bool clusterCulling = false;
+    std::vector<MeshletDrawRange> clusterDraws;
+    SceneGraph scene;
+    CullingSystem culling;
+    std::vector<uint32_t> visibleObjects;
+    // viewProj * world of this frame's visible objects, indexed by object;
+    // the forward draw list pushes these instead of multiplying per draw.
+    std::vector<glm::mat4> objectMvps;
+    uint32_t objectCount = 1;
+
+    // === Draw List ===
+    // CPU-culled draws of the frame, sorted by key before recording. The
+    // pipeline field of the key is one of these.
+    static constexpr uint32_t FORWARD_PIPELINE = 0;
+    static constexpr uint32_t BINDLESS_PIPELINE = 1;
+    std::vector<DrawItem> drawItems;
+    std::vector<DrawItem> drawItemsScratch;
+    CommandStateCache drawState;
+
+    // === Render Graph ===
+    // Built and compiled once; each frame only binds the swapchain image
+    // and the frame's culling buffers before executing it.
+    RenderGraph frameGraph;
+    RgHandle backbufferResource = RG_INVALID;
+    RgHandle drawCommandsResource = RG_INVALID;
+    RgHandle drawCountResource = RG_INVALID;
+    uint32_t forwardPass = 0;
+    // VK_KHR_dynamic_rendering unless the device lacks it or
+    // VK3D_LEGACY_RENDER_PASS is set.
+    bool dynamicRendering = true;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+    // Read by pass callbacks while the graph executes.
+    glm::mat4 frameViewProj{ 1.0f };
+
+    // === Depth ===
+    // The depth buffer is a transient of frameGraph. With VK3D_DEPTH_PREPASS
+    // a depth-only pass lays down the nearest surfaces first and the forward
+    // pass shades only fragments that test EQUAL against them.
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    RgHandle depthResource = RG_INVALID;
+    bool depthPrepass = false;
+    uint32_t depthPrepassPass = 0;
+    // Vertex-only variant of graphicsPipeline for the pre-pass.
+    VkPipeline depthPipeline = VK_NULL_HANDLE;
+    // Fragment shader invocations of the forward passes, two queries per
+    // frame in flight (the second for the late pass of occlusion culling);
+    // null when the device has no pipelineStatisticsQuery.
+    bool fragmentStatistics = false;
+    VkQueryPool fragmentQueryPool = VK_NULL_HANDLE;
+
+    // === Capture ===
+    // VK3D_CAPTURE=<directory> writes presented frames there (png, or raw
+    // with VK3D_CAPTURE_FORMAT=raw), every VK3D_CAPTURE_EVERY-th frame.
+    std::string captureDirectory;
+    FrameCapture frameCapture;
+    RgHandle captureResource = RG_INVALID;
+    bool captureThisFrame = false;
+
+    // === Stats ===
+    FrameStats frameStats;
+    double lastStatsReport = 0.0;
+    // GPU time of each frame from timestamps around its command buffer,
+    // then around the Hi-Z build and the late cull of occlusion culling,
+    // then around the texture streamer's image moves; null when the
+    // graphics queue has no timestamp support.
+    static constexpr uint32_t TIMESTAMPS_PER_FRAME = 6;
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    uint32_t timestampValidBits = 0;
+    double timestampPeriodNs = 0.0;
+
+    // === Startup ===
+    // InitVulkan's steps as they ran, and the time until the first frame;
+    // see StartupGraph.
+    std::chrono::steady_clock::time_point startupBegin;
+    StartupStats startup;
+
+    // === Benchmark ===
+    // Set by runBenchmark: no window or surface, offscreen images stand in
+    // for the swapchain images, and time advances by a fixed step per frame.
+    bool benchmarking = false;
+    BenchmarkConfig benchmark;
+    std::vector<VkDeviceMemory> offscreenMemory;
+
     int width = 0;
 	int height = 0;
 
@@ -110,12 +305,106 @@ private:
     const int MAX_FRAMES_IN_FLIGHT = 2;
 
     // === Descriptor ===
-    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
     VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
     std::vector<VkDescriptorSet> descriptorSets;
+    VkDescriptorUpdateTemplate uboUpdateTemplate = VK_NULL_HANDLE;
+    DescriptorLayoutCache descriptorLayouts;
+    // Sets that live as long as the renderer.
+    DescriptorAllocator descriptorAllocator;
+    // Sets recorded into one frame's commands; reset once its fence signals.
+    std::vector<DescriptorAllocator> frameDescriptorAllocators;
 
 	// === Uniform Buffers UBO is already defined in Vertex.h ===
     std::vector<VkBuffer> uniformBuffers;
     std::vector<VkDeviceMemory> uniformBuffersMemory;
     std::vector<void*> uniformBuffersMapped;
+
+    // === Object Buffers ===
+    // GpuObjectData per object, one host-visible copy per frame in flight.
+    // Used by GPU culling and by bindless draws.
+    std::vector<VkBuffer> objectBuffers;
+    std::vector<VkDeviceMemory> objectBuffersMemory;
+    std::vector<void*> objectBuffersMapped;
+    // Objects each frame's buffer still has to receive.
+    std::vector<ChangeList> objectUploads;
+
+    // === GPU Culling ===
+    // cull.comp writes one VkDrawIndexedIndirectCommand per visible object and
+    // bumps drawCount; the draws are issued with vkCmdDrawIndexedIndirectCount.
+    // The sets are allocated per frame from frameDescriptorAllocators.
+    bool gpuDrivenCulling = false;
+    ComputePipeline cullPipeline;
+    std::vector<VkDescriptorSet> cullDescriptorSets;
+    VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline indirectPipeline = VK_NULL_HANDLE;
+    VkPipeline indirectDepthPipeline = VK_NULL_HANDLE;
+
+    std::vector<VkBuffer> drawCommandBuffers;
+    std::vector<VkDeviceMemory> drawCommandBuffersMemory;
+    std::vector<VkBuffer> drawCountBuffers;
+    std::vector<VkDeviceMemory> drawCountBuffersMemory;
+    std::vector<void*> drawCountBuffersMapped;
+
+    // === Occlusion Culling ===
+    // VK3D_OCCLUSION_CULLING=1 splits GPU culling in two phases around a
+    // Hi-Z pyramid built from the depth the early draws leave; see
+    // occlusion.comp. Needs GPU culling on the graphics queue and a depth
+    // format that can be sampled.
+    bool occlusionCulling = false;
+    ComputePipeline occlusionPipeline;
+    ComputePipeline hizPipeline;
+    std::vector<VkDescriptorSet> occlusionDescriptorSets;
+    VkSampler hizSampler = VK_NULL_HANDLE;
+    VkExtent2D hizExtent{};
+    uint32_t hizLevels = 0;
+    // One pyramid per frame in flight with a view of every level for the
+    // cull, and a view and a descriptor set per level for hiz.comp. Like
+    // the culling sets, the descriptor sets are allocated per frame.
+    std::vector<VkImage> hizImages;
+    std::vector<VkDeviceMemory> hizImagesMemory;
+    std::vector<VkImageView> hizViews;
+    std::vector<std::vector<VkImageView>> hizLevelViews;
+    std::vector<std::vector<VkDescriptorSet>> hizDescriptorSets;
+    // One uint per object, set if the late phase found it visible. Carried
+    // from each frame to the next; the first frame clears it.
+    VkBuffer visibilityBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory visibilityBufferMemory = VK_NULL_HANDLE;
+    bool visibilityCleared = false;
+    RgHandle hizResource = RG_INVALID;
+    RgHandle visibilityResource = RG_INVALID;
+
+    // === Async Compute ===
+    // VK3D_ASYNC_COMPUTE=1 moves GPU culling to a queue family with compute
+    // but no graphics, when the device has one. Buffers both queues touch
+    // are shared concurrently between computeSharingFamilies.
+    bool asyncComputeEnabled = false;
+    VkQueue computeQueue = VK_NULL_HANDLE;
+    uint32_t computeQueueFamily = 0;
+    std::vector<uint32_t> computeSharingFamilies;
+    AsyncComputeQueue asyncCompute;
+
+    // === Bindless ===
+    // One global descriptor set with every storage buffer and image; draws
+    // find their object through firstInstance, so the frame binds one set
+    // and pushes one set of constants.
+    bool bindless = false;
+    uint32_t bindlessBufferCapacity = VkBindless::MAX_BUFFERS;
+    uint32_t bindlessImageCapacity = VkBindless::MAX_IMAGES;
+    BindlessTable bindlessTable;
+    std::vector<uint32_t> objectBufferSlots;
+    VkPipelineLayout bindlessPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline bindlessPipeline = VK_NULL_HANDLE;
+    VkPipeline bindlessDepthPipeline = VK_NULL_HANDLE;
+
+    // === Textures ===
+    // VK3D_TEXTURE names a KTX2 file put on every object; only bindless.frag
+    // samples it. Larger mips stream in over the first frames.
+    static constexpr uint32_t NO_TEXTURE = UINT32_MAX;
+    TextureStreamer textureStreamer;
+    SamplerCache samplerCache;
+    VkSampler textureSampler = VK_NULL_HANDLE;
+    uint32_t sceneTexture = NO_TEXTURE;
+    uint32_t sceneTextureSlot = VkBindless::INVALID_INDEX;
+    // Slots of replaced views with the frame they were replaced in.
+    std::vector<std::pair<uint64_t, uint32_t>> retiredTextureSlots;
 };
\ No newline at end of file
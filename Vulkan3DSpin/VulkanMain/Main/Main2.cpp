@@ -1,5 +1,9 @@
 #include "VulkanMain/Main/Main.h"
 #include "VulkanMain/VulkanDebug/VulkanDebug.h"
+#include "VulkanMain/VulkanDebug/Log.h"
+#include "VulkanMain/Utils/Utils.h"
+#include "VulkanMain/Dispatch/Null.h"
+#include "VulkanMain/Startup/Startup.h"
 
 void VkMain::InitWindow() {
     glfwInit();
@@ -11,22 +15,163 @@ void VkMain::InitWindow() {
 }
 
 void VkMain::InitVulkan() {
-    CreateInstance();
-    SetupDebugMessenger();
-    CreateSurface();
-    PickPhysicalDevice();
-    CreateLogicalDevice();
-    CreateSwapChain();
-    CreateImageViews();
-    CreateRenderPass();
+    gpuDrivenCulling = VkUtils::GetEnvFlag("VK3D_GPU_CULLING");
+    objectCount = std::max(1u, VkUtils::GetEnvUint("VK3D_OBJECT_COUNT", 1));
+    clusterCulling = VkUtils::GetEnvFlag("VK3D_CLUSTER_CULLING");
+    lodSelector.thresholdPixels = static_cast<float>(VkUtils::GetEnvUint("VK3D_LOD_PIXELS", 1));
+    bindless = VkUtils::GetEnvFlag("VK3D_BINDLESS");
+    dynamicRendering = !VkUtils::GetEnvFlag("VK3D_LEGACY_RENDER_PASS");
+    depthPrepass = VkUtils::GetEnvFlag("VK3D_DEPTH_PREPASS");
+    asyncComputeEnabled = VkUtils::GetEnvFlag("VK3D_ASYNC_COMPUTE");
+    occlusionCulling = VkUtils::GetEnvFlag("VK3D_OCCLUSION_CULLING");
+    captureDirectory = VkUtils::GetEnvString("VK3D_CAPTURE");
+    directDispatch = !VkUtils::GetEnvFlag("VK3D_LOADER_DISPATCH");
+    startup.parallel = !VkUtils::GetEnvFlag("VK3D_SERIAL_INIT");
+
+    // A benchmark scene overrides the switches it describes.
+    if (benchmarking) {
+        objectCount = benchmark.scene.objects;
+        gpuDrivenCulling = benchmark.scene.gpuCulling;
+        occlusionCulling = benchmark.scene.occlusionCulling;
+        clusterCulling = benchmark.scene.clusterCulling;
+        bindless = benchmark.scene.bindless;
+        directDispatch = benchmark.directDispatch;
+        startup.parallel = benchmark.parallelInit;
+    }
+
+    // The null backend has no surface, so it is only offered headless.
+    if (benchmarking && benchmark.nullBackend) {
+        VkNull::Install();
+    }
+    else if (!VkDispatch::LoadLoader()) {
+        throw std::runtime_error("failed to load the Vulkan loader!");
+    }
+
+    std::vector<std::string> shaderPaths = { shaderDirectory + "vert.spv", shaderDirectory + "frag.spv" };
+    if (gpuDrivenCulling) {
+        shaderPaths.push_back(shaderDirectory + "cull.spv");
+        shaderPaths.push_back(shaderDirectory + "indirect.spv");
+    }
+    if (occlusionCulling) {
+        shaderPaths.push_back(shaderDirectory + "occlusion.spv");
+        shaderPaths.push_back(shaderDirectory + "hiz.spv");
+    }
+    if (bindless) {
+        shaderPaths.push_back(shaderDirectory + "bindless_vert.spv");
+        shaderPaths.push_back(shaderDirectory + "bindless_frag.spv");
+    }
+
+    // The instance, device and swapchain chain stays on this thread in its
+    // old order; shader I/O, mesh building and the main pipelines overlap
+    // with it on workers. Only main steps touch the queue and command pool.
+    StartupGraph graph;
+    auto shaders = graph.Worker("ReadShaders", {}, [&] { VkStartup::PrefetchShaders(shaderPaths); });
+    auto mesh = graph.Worker("BuildMesh", {}, [this] { BuildMesh(); });
+
+    graph.Main("CreateInstance", {}, [this] { CreateInstance(); });
+    graph.Main("SetupDebugMessenger", {}, [this] { SetupDebugMessenger(); });
+    if (!benchmarking) {
+        graph.Main("CreateSurface", {}, [this] { CreateSurface(); });
+    }
+    graph.Main("PickPhysicalDevice", {}, [this] { PickPhysicalDevice(); });
+    graph.Main("CreateLogicalDevice", {}, [this] { CreateLogicalDevice(); });
+    if (benchmarking) {
+        graph.Main("CreateOffscreenTargets", {}, [this] { CreateOffscreenTargets(); });
+    }
+    else {
+        graph.Main("CreateSwapChain", {}, [this] { CreateSwapChain(); });
+    }
+    graph.Main("CreateImageViews", {}, [this] { CreateImageViews(); });
+    // The swap chain or offscreen targets clear it when their format
+    // cannot be captured.
+    if (!captureDirectory.empty()) {
+        graph.Main("CreateCapture", {}, [this] {
+            if (!captureDirectory.empty()) {
+                CreateCapture();
+            }
+        });
+    }
+    graph.Main("CreateRenderGraph", {}, [this] { CreateRenderGraph(); });
 
     // 1. ̾ƿ  
-    CreateDescriptorSetLayout();
+    auto layout = graph.Main("CreateDescriptorSetLayout", {}, [this] { CreateDescriptorSetLayout(); });
 
-    CreateGraphicsPipeline();
-    CreateCommandPool(); //    Ŀǵ尡 ʿ  Ƿ ̸ 
+    // Also needs the render graph's formats and passes, built before the layout.
+    graph.Worker("CreateGraphicsPipeline", { shaders, layout }, [this] { CreateGraphicsPipeline(); });
+    graph.Main("CreateCommandPool", {}, [this] { CreateCommandPool(); }); //    Ŀǵ尡 ʿ  Ƿ ̸ 
+    // The steps are declared before CreateLogicalDevice and CreateRenderGraph
+    // settle the feature flags, so optional steps check them again when
+    // they run.
+    if (asyncComputeEnabled) {
+        graph.Main("InitAsyncCompute", {}, [this] {
+            if (asyncComputeEnabled) {
+                asyncCompute.Init(device, computeQueueFamily, computeQueue, MAX_FRAMES_IN_FLIGHT);
+            }
+        });
+    }
 
     // 2.  ҽ()  ܰ (߿!)
+    graph.Main("CreateMeshBuffers", { mesh }, [this] {
+        CreateVertexBuffer();
+        CreateIndexBuffer();
+    });
+    graph.Main("CreateSceneObjects", {}, [this] { CreateSceneObjects(); });
+
+    //  Լ ǵǾ ִ Ȯϰ ⼭ ȣؾ մϴ!
+    graph.Main("CreateUniformBuffers", {}, [this] { CreateUniformBuffers(); });
+
+    // 3. ҽ    ũ 
+    graph.Main("CreateDescriptorPool", {}, [this] { CreateDescriptorPool(); });
+    graph.Main("CreateDescriptorSets", {}, [this] { CreateDescriptorSets(); });
+
+    if (gpuDrivenCulling || bindless) {
+        graph.Main("CreateObjectBuffers", {}, [this] {
+            if (gpuDrivenCulling || bindless) {
+                CreateObjectBuffers();
+            }
+        });
+    }
+    if (gpuDrivenCulling) {
+        graph.Main("CreateGpuCulling", { shaders }, [this] {
+            if (gpuDrivenCulling) {
+                CreateGpuCulling();
+            }
+        });
+    }
+    if (occlusionCulling) {
+        graph.Main("CreateOcclusionCulling", { shaders }, [this] {
+            if (occlusionCulling) {
+                CreateOcclusionCulling();
+            }
+        });
+    }
+    if (bindless) {
+        graph.Main("CreateBindless", { shaders }, [this] {
+            if (bindless) {
+                CreateBindless();
+            }
+        });
+    }
+    graph.Main("CreateTextures", {}, [this] { CreateTextures(); });
+
+    // Only known once the device is.
+    graph.Main("CreateFragmentQueries", {}, [this] {
+        if (fragmentStatistics) {
+            CreateFragmentQueries();
+        }
+    });
+    graph.Main("CreateTimestampQueries", {}, [this] { CreateTimestampQueries(); });
+
+    graph.Main("CreateSyncObjects", {}, [this] { CreateSyncObjects(); });
+    graph.Main("CreateCommandBuffer", {}, [this] { CreateCommandBuffer(); });
+
+    auto initStart = std::chrono::steady_clock::now();
+    graph.Run(startup.parallel, startupBegin, startup.phases);
+    startup.initMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+    VkStartup::ClearShaders();
+}
+
+void VkMain::BuildMesh() {
     // vertex  ʱȭ  Լ  ϴ  մϴ.
     vertices = {
         {{ 0.0f, -0.5f,  0.0f}, {1.0f, 0.0f, 0.0f}}, //   ()
@@ -34,18 +179,26 @@ void VkMain::InitVulkan() {
         {{ 0.5f,  0.5f,  0.5f}, {0.0f, 0.0f, 1.0f}}, // ٴ 2 (Ķ)
         {{ 0.0f,  0.5f, -0.5f}, {1.0f, 1.0f, 1.0f}}  // ٴ 3 ()
     };
-    CreateVertexBuffer();
-
-    //  Լ ǵǾ ִ Ȯϰ ⼭ ȣؾ մϴ!
-    CreateUniformBuffers();
+    indices = {
+        0, 1, 2,
+        0, 2, 3,
+        0, 3, 1,
+        1, 3, 2
+    };
 
-    // 3. ҽ    ũ 
-    CreateDescriptorPool();
-    CreateDescriptorSets();
+    // VK3D_MESH replaces the tetrahedron with a mesh built by --import-mesh.
+    std::string meshPath = VkUtils::GetEnvString("VK3D_MESH");
+    if (benchmarking && benchmark.scene.sphereSegments > 0) {
+        VkBenchmark::BuildSphere(benchmark.scene.sphereSegments, vertices, indices);
+        meshPath.clear();
+    }
+    MeshAsset mesh = meshPath.empty() ? VkMesh::BuildAsset(vertices, indices) : VkMesh::LoadMesh(meshPath);
+    vertices = std::move(mesh.vertices);
+    indices = std::move(mesh.indices);
+    meshlets = std::move(mesh.meshlets);
+    meshLods = std::move(mesh.lods);
 
-    CreateFramebuffers();
-    CreateSyncObjects();
-    CreateCommandBuffer();
+    meshBounds = VkMesh::ComputeBounds(vertices);
 }
 /*
     CreateInstance();
@@ -91,30 +244,68 @@ void VkMain::Cleanup() {
         vkDestroyFence(device, inFlightFence[i], nullptr);
     }
     vkDestroyCommandPool(device, commandPool, nullptr);
+    asyncCompute.Destroy();
+    frameCapture.Destroy();
+
+    DestroyTextures();
+    if (bindless) {
+        DestroyBindless();
+    }
+    if (occlusionCulling) {
+        DestroyOcclusionCulling();
+    }
+    if (gpuDrivenCulling) {
+        DestroyGpuCulling();
+    }
+    DestroyObjectBuffers();
 
-    for (auto framebuffer : swapChainFramebuffers) {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
+    descriptorAllocator.Destroy();
+    for (auto& allocator : frameDescriptorAllocators) {
+        allocator.Destroy();
     }
+    frameDescriptorAllocators.clear();
+    vkDestroyDescriptorUpdateTemplate(device, uboUpdateTemplate, nullptr);
+    descriptorLayouts.Destroy();
 
+    vkDestroyBuffer(device, indexBuffer, nullptr);
+    VkMemory::Free(device, indexBufferMemory);
+
+    DestroyFragmentQueries();
+    DestroyTimestampQueries();
+    vkDestroyPipeline(device, depthPipeline, nullptr);
     vkDestroyPipeline(device, graphicsPipeline, nullptr);
     vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
-    vkDestroyRenderPass(device, renderPass, nullptr);
+    // Render passes, framebuffers and transient images.
+    frameGraph.Destroy();
 
     for (auto imageView : swapChainImageViews) {
         vkDestroyImageView(device, imageView, nullptr);
     }
 
-    vkDestroySwapchainKHR(device, swapChain, nullptr);
+    if (benchmarking) {
+        DestroyOffscreenTargets();
+    }
+    else {
+        vkDestroySwapchainKHR(device, swapChain, nullptr);
+    }
     vkDestroyDevice(device, nullptr);
 
     if (VkDebug::enableValidationLayers) {
         VkDebug::DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    // Benchmarks render offscreen and never create one.
+    if (surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance, surface, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
+    if (VkDebug::enableValidationLayers) {
+        VkLog::Stop();
+    }
 
-    glfwDestroyWindow(window);
+    if (window != nullptr) {
+        glfwDestroyWindow(window);
 
-    glfwTerminate();
+        glfwTerminate();
+    }
 }
\ No newline at end of file
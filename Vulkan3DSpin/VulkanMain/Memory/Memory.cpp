@@ -0,0 +1,132 @@
+#include "VulkanMain/Memory/Memory.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    struct Allocation {
+        uint32_t heap;
+        MemoryCategory category;
+        VkDeviceSize size;
+    };
+
+    // Guards everything below; the startup workers may allocate too.
+    std::mutex mutex;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    bool budgetExtension = false;
+    VkDeviceSize budgetCap = 0;
+    std::vector<uint32_t> typeHeaps;
+    std::vector<VkDeviceSize> heapAllocated;
+    VkDeviceSize categoryAllocated[MEMORY_CATEGORY_COUNT] = {};
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+}
+
+const char* VkMemory::CategoryName(MemoryCategory category) {
+    switch (category) {
+    case MemoryCategory::Geometry: return "geometry";
+    case MemoryCategory::Uniform: return "uniform";
+    case MemoryCategory::Texture: return "texture";
+    case MemoryCategory::Staging: return "staging";
+    case MemoryCategory::RenderTarget: return "renderTarget";
+    case MemoryCategory::Readback: return "readback";
+    default: return "unknown";
+    }
+}
+
+void VkMemory::Init(VkPhysicalDevice vkPhysicalDevice, bool hasBudgetExtension) {
+    VkPhysicalDeviceMemoryProperties properties;
+    vkGetPhysicalDeviceMemoryProperties(vkPhysicalDevice, &properties);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    physicalDevice = vkPhysicalDevice;
+    budgetExtension = hasBudgetExtension;
+    budgetCap = static_cast<VkDeviceSize>(VkUtils::GetEnvUint("VK3D_MEMORY_BUDGET_MB", 0)) << 20;
+    typeHeaps.resize(properties.memoryTypeCount);
+    for (uint32_t i = 0; i < properties.memoryTypeCount; i++) {
+        typeHeaps[i] = properties.memoryTypes[i].heapIndex;
+    }
+    heapAllocated.assign(std::max(properties.memoryHeapCount, 1u), 0);
+    std::fill(std::begin(categoryAllocated), std::end(categoryAllocated), 0);
+    allocations.clear();
+}
+
+uint32_t VkMemory::HeapOfType(uint32_t memoryType) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryType < typeHeaps.size() ? typeHeaps[memoryType] : 0;
+}
+
+VkResult VkMemory::Allocate(VkDevice device, const VkMemoryAllocateInfo& info, MemoryCategory category, VkDeviceMemory& memory) {
+    VkResult result = vkAllocateMemory(device, &info, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    uint32_t heap = info.memoryTypeIndex < typeHeaps.size() ? typeHeaps[info.memoryTypeIndex] : 0;
+    if (heap >= heapAllocated.size()) {
+        heapAllocated.resize(heap + 1, 0);
+    }
+    heapAllocated[heap] += info.allocationSize;
+    categoryAllocated[static_cast<size_t>(category)] += info.allocationSize;
+    allocations[memory] = { heap, category, info.allocationSize };
+    return VK_SUCCESS;
+}
+
+void VkMemory::Free(VkDevice device, VkDeviceMemory memory) {
+    if (memory == VK_NULL_HANDLE) {
+        return;
+    }
+    vkFreeMemory(device, memory, nullptr);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = allocations.find(memory);
+    if (it == allocations.end()) {
+        return;
+    }
+    heapAllocated[it->second.heap] -= it->second.size;
+    categoryAllocated[static_cast<size_t>(it->second.category)] -= it->second.size;
+    allocations.erase(it);
+}
+
+void VkMemory::Query(MemoryStats& stats) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = budgetExtension ? &budget : nullptr;
+    // Core since 1.1, but an older loader may still hand out null.
+    if (vkGetPhysicalDeviceMemoryProperties2 != nullptr) {
+        vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+    }
+    else {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &properties.memoryProperties);
+    }
+    bool driverBudget = budgetExtension && vkGetPhysicalDeviceMemoryProperties2 != nullptr;
+    const VkPhysicalDeviceMemoryProperties& memory = properties.memoryProperties;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.budgetExtension = driverBudget;
+    stats.heaps.resize(memory.memoryHeapCount);
+    for (uint32_t i = 0; i < memory.memoryHeapCount; i++) {
+        MemoryHeapStats& heap = stats.heaps[i];
+        heap.size = memory.memoryHeaps[i].size;
+        heap.deviceLocal = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heap.allocated = i < heapAllocated.size() ? heapAllocated[i] : 0;
+        if (driverBudget) {
+            heap.budget = budget.heapBudget[i];
+            heap.usage = budget.heapUsage[i];
+        }
+        else {
+            heap.budget = heap.size / 10 * 8;
+            heap.usage = heap.allocated;
+        }
+        if (heap.deviceLocal && budgetCap > 0) {
+            heap.budget = std::min(heap.budget, budgetCap);
+        }
+    }
+    std::copy(std::begin(categoryAllocated), std::end(categoryAllocated), std::begin(stats.categories));
+    stats.allocations = static_cast<uint32_t>(allocations.size());
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What an allocation holds, for the usage breakdown.
+enum class MemoryCategory : uint32_t {
+    // Vertex, index, object and indirect draw buffers.
+    Geometry,
+    Uniform,
+    Texture,
+    Staging,
+    // Offscreen targets and the render graph's transient heaps.
+    RenderTarget,
+    Readback,
+    Count,
+};
+
+constexpr size_t MEMORY_CATEGORY_COUNT = static_cast<size_t>(MemoryCategory::Count);
+
+struct MemoryHeapStats {
+    VkDeviceSize size = 0;
+    // With VK_EXT_memory_budget what the driver says this process may use
+    // and does use, its own allocations included. Without it the budget is
+    // 80% of the heap and usage is what the engine allocated.
+    // VK3D_MEMORY_BUDGET_MB caps the budget of device-local heaps.
+    VkDeviceSize budget = 0;
+    VkDeviceSize usage = 0;
+    // What the engine allocated from this heap.
+    VkDeviceSize allocated = 0;
+    bool deviceLocal = false;
+};
+
+struct MemoryStats {
+    bool budgetExtension = false;
+    std::vector<MemoryHeapStats> heaps;
+    VkDeviceSize categories[MEMORY_CATEGORY_COUNT] = {};
+    uint32_t allocations = 0;
+};
+
+// Every device allocation of the renderer goes through here, so usage is
+// known per heap and per category. Like the dispatch table there is one
+// device per process.
+namespace VkMemory {
+    const char* CategoryName(MemoryCategory category);
+
+    // Right after the device is created; budgetExtension says whether
+    // VK_EXT_memory_budget is enabled on it.
+    void Init(VkPhysicalDevice physicalDevice, bool budgetExtension);
+
+    // vkAllocateMemory, counted against the heap of info.memoryTypeIndex.
+    VkResult Allocate(VkDevice device, const VkMemoryAllocateInfo& info, MemoryCategory category, VkDeviceMemory& memory);
+    // Accepts VK_NULL_HANDLE, like vkFreeMemory.
+    void Free(VkDevice device, VkDeviceMemory memory);
+
+    uint32_t HeapOfType(uint32_t memoryType);
+
+    // Budgets and usage as of now. Cheap enough for every frame; stats is
+    // reused so nothing is allocated after the first call.
+    void Query(MemoryStats& stats);
+}
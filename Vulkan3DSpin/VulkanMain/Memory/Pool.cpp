@@ -0,0 +1,161 @@
+#include "VulkanMain/Memory/Pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+void MemoryPool::Init(VkDevice vkDevice, uint32_t type, MemoryCategory memoryCategory, VkDeviceSize size) {
+    device = vkDevice;
+    memoryType = type;
+    category = memoryCategory;
+    blockSize = size;
+    releasedBytes = 0;
+}
+
+void MemoryPool::Destroy() {
+    for (Block& block : blocks) {
+        VkMemory::Free(device, block.memory);
+    }
+    blocks.clear();
+    device = VK_NULL_HANDLE;
+}
+
+bool MemoryPool::AllocateIn(uint32_t index, const VkMemoryRequirements& requirements, PoolAllocation& allocation) {
+    Block& block = blocks[index];
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    for (auto it = block.free.begin(); it != block.free.end(); ++it) {
+        VkDeviceSize start = it->first;
+        VkDeviceSize end = it->first + it->second;
+        VkDeviceSize offset = AlignUp(start, alignment);
+        if (offset + requirements.size > end) {
+            continue;
+        }
+
+        // The padding before and the rest after stay free.
+        block.free.erase(it);
+        if (offset > start) {
+            block.free.emplace(start, offset - start);
+        }
+        if (offset + requirements.size < end) {
+            block.free.emplace(offset + requirements.size, end - offset - requirements.size);
+        }
+        block.used += requirements.size;
+        allocation = { block.memory, offset, requirements.size, index };
+        generation++;
+        return true;
+    }
+    return false;
+}
+
+bool MemoryPool::Allocate(const VkMemoryRequirements& requirements, uint32_t avoid, bool newBlock, PoolAllocation& allocation) {
+    if (!(requirements.memoryTypeBits & (1u << memoryType))) {
+        throw std::runtime_error("resource cannot live in its memory pool!");
+    }
+    for (uint32_t i = 0; i < blocks.size(); i++) {
+        if (i != avoid && blocks[i].memory != VK_NULL_HANDLE && AllocateIn(i, requirements, allocation)) {
+            return true;
+        }
+    }
+    if (!newBlock) {
+        return false;
+    }
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = std::max(blockSize, requirements.size);
+    allocInfo.memoryTypeIndex = memoryType;
+
+    Block block;
+    if (VkMemory::Allocate(device, allocInfo, category, block.memory) != VK_SUCCESS) {
+        return false;
+    }
+    block.size = allocInfo.allocationSize;
+    block.free.emplace(0, block.size);
+
+    auto slot = std::find_if(blocks.begin(), blocks.end(), [](const Block& b) { return b.memory == VK_NULL_HANDLE; });
+    uint32_t index = static_cast<uint32_t>(slot - blocks.begin());
+    if (slot == blocks.end()) {
+        blocks.push_back(std::move(block));
+    }
+    else {
+        *slot = std::move(block);
+    }
+    return AllocateIn(index, requirements, allocation);
+}
+
+void MemoryPool::Free(const PoolAllocation& allocation) {
+    Block& block = blocks[allocation.block];
+    block.used -= allocation.size;
+    generation++;
+
+    auto it = block.free.emplace(allocation.offset, allocation.size).first;
+    auto next = std::next(it);
+    if (next != block.free.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        block.free.erase(next);
+    }
+    if (it != block.free.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + previous->second == it->first) {
+            previous->second += it->second;
+            block.free.erase(it);
+        }
+    }
+}
+
+VkDeviceSize MemoryPool::ReleaseEmpty() {
+    VkDeviceSize released = 0;
+    for (Block& block : blocks) {
+        if (block.memory != VK_NULL_HANDLE && block.used == 0) {
+            VkMemory::Free(device, block.memory);
+            released += block.size;
+            block = Block{};
+        }
+    }
+    releasedBytes += released;
+    return released;
+}
+
+uint32_t MemoryPool::SparsestBlock() const {
+    uint32_t sparsest = NO_BLOCK;
+    for (uint32_t i = 0; i < blocks.size(); i++) {
+        if (blocks[i].memory != VK_NULL_HANDLE && blocks[i].used > 0 && (sparsest == NO_BLOCK || blocks[i].used < blocks[sparsest].used)) {
+            sparsest = i;
+        }
+    }
+    if (sparsest == NO_BLOCK) {
+        return NO_BLOCK;
+    }
+    const Block& block = blocks[sparsest];
+    return block.used <= FreeBytes() - (block.size - block.used) ? sparsest : NO_BLOCK;
+}
+
+VkDeviceSize MemoryPool::FreeBytes() const {
+    VkDeviceSize free = 0;
+    for (const Block& block : blocks) {
+        free += block.size - block.used;
+    }
+    return free;
+}
+
+MemoryPoolStats MemoryPool::Stats() const {
+    MemoryPoolStats stats;
+    for (const Block& block : blocks) {
+        if (block.memory == VK_NULL_HANDLE) {
+            continue;
+        }
+        stats.blocks++;
+        stats.blockBytes += block.size;
+        stats.usedBytes += block.used;
+        for (const auto& range : block.free) {
+            stats.largestFree = std::max(stats.largestFree, range.second);
+        }
+    }
+    stats.releasedBytes = releasedBytes;
+    return stats;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "VulkanMain/Memory/Memory.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// A range of one of the pool's blocks.
+struct PoolAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    uint32_t block = 0;
+};
+
+struct MemoryPoolStats {
+    uint32_t blocks = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize usedBytes = 0;
+    // The largest range one allocation can get without a new block.
+    VkDeviceSize largestFree = 0;
+    // Blocks given back to the driver since Init.
+    VkDeviceSize releasedBytes = 0;
+};
+
+// Suballocates one memory type out of large blocks, first fit, so resources
+// that come and go do not each cost a vkAllocateMemory. Block indices stay
+// valid until the block is released; a released index is reused.
+class MemoryPool {
+public:
+    static constexpr uint32_t NO_BLOCK = ~0u;
+
+    void Init(VkDevice device, uint32_t memoryType, MemoryCategory category, VkDeviceSize blockSize);
+    void Destroy();
+
+    bool Initialized() const { return device != VK_NULL_HANDLE; }
+    uint32_t MemoryType() const { return memoryType; }
+
+    // Never from block avoid. With newBlock false only existing blocks are
+    // tried; otherwise a block is added when none has room, sized for
+    // requirements if they exceed the block size. False when nothing fits.
+    bool Allocate(const VkMemoryRequirements& requirements, uint32_t avoid, bool newBlock, PoolAllocation& allocation);
+    void Free(const PoolAllocation& allocation);
+
+    // Releases every block without allocations and returns the bytes.
+    VkDeviceSize ReleaseEmpty();
+    // The least used block whose allocations would fit in the free space
+    // of the others, the one worth emptying; NO_BLOCK if none would.
+    uint32_t SparsestBlock() const;
+    VkDeviceSize Used(uint32_t block) const { return blocks[block].used; }
+    // Changes with every allocation and free, so a caller can tell whether
+    // a layout it gave up on is still the same.
+    uint64_t Generation() const { return generation; }
+
+    // Free space inside the blocks.
+    VkDeviceSize FreeBytes() const;
+    MemoryPoolStats Stats() const;
+
+private:
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        VkDeviceSize used = 0;
+        // Offset to size of each free range; adjacent ranges are merged.
+        std::map<VkDeviceSize, VkDeviceSize> free;
+    };
+
+    bool AllocateIn(uint32_t block, const VkMemoryRequirements& requirements, PoolAllocation& allocation);
+
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t memoryType = 0;
+    MemoryCategory category = MemoryCategory::Texture;
+    VkDeviceSize blockSize = 0;
+    // Released blocks stay as entries with no memory.
+    std::vector<Block> blocks;
+    VkDeviceSize releasedBytes = 0;
+    uint64_t generation = 0;
+};
@@ -0,0 +1,32 @@
+#include "VulkanMain/Mesh/Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+MeshBounds VkMesh::ComputeBounds(const std::vector<Vertex>& vertices) {
+    MeshBounds bounds{};
+
+    if (vertices.empty()) {
+        return bounds;
+    }
+
+    bounds.box.min = glm::vec3(std::numeric_limits<float>::max());
+    bounds.box.max = glm::vec3(-std::numeric_limits<float>::max());
+
+    for (const auto& vertex : vertices) {
+        bounds.box.min = glm::min(bounds.box.min, vertex.pos);
+        bounds.box.max = glm::max(bounds.box.max, vertex.pos);
+    }
+
+    bounds.sphere.center = bounds.box.Center();
+
+    float radiusSq = 0.0f;
+    for (const auto& vertex : vertices) {
+        glm::vec3 d = vertex.pos - bounds.sphere.center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    bounds.sphere.radius = std::sqrt(radiusSq);
+
+    return bounds;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "VulkanMain/Vertex/Vertex.h"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extents() const { return (max - min) * 0.5f; }
+};
+
+struct BoundingSphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// Object-space bounds of a mesh. The sphere is centered on the box so that
+// culling can test both with one center.
+struct MeshBounds {
+    AABB box;
+    BoundingSphere sphere;
+};
+
+namespace VkMesh {
+    MeshBounds ComputeBounds(const std::vector<Vertex>& vertices);
+}
@@ -0,0 +1,247 @@
+#include "VulkanMain/Mesh/MeshFile.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    template <typename T>
+    void WriteArray(std::ofstream& file, const std::vector<T>& values) {
+        if (!values.empty()) {
+            file.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+        }
+    }
+
+    template <typename T>
+    void ReadArray(std::ifstream& file, std::vector<T>& values, uint32_t count) {
+        values.resize(count);
+        if (count > 0) {
+            file.read(reinterpret_cast<char*>(values.data()), sizeof(T) * count);
+        }
+    }
+
+    uint64_t RemainingBytes(std::ifstream& file) {
+        std::streampos position = file.tellg();
+        file.seekg(0, std::ios::end);
+        std::streampos end = file.tellg();
+        file.seekg(position);
+        return static_cast<uint64_t>(end - position);
+    }
+
+    // Every index and range must stay inside the array it points into;
+    // the renderer and the culling code use them unchecked.
+    void ValidateMesh(const MeshAsset& mesh) {
+        size_t vertexCount = mesh.vertices.size();
+        for (uint32_t index : mesh.indices) {
+            if (index >= vertexCount) {
+                throw std::runtime_error("failed to read mesh file: index out of range!");
+            }
+        }
+        for (uint32_t vertex : mesh.meshlets.vertices) {
+            if (vertex >= vertexCount) {
+                throw std::runtime_error("failed to read mesh file: meshlet vertex out of range!");
+            }
+        }
+        for (const MeshLod& lod : mesh.lods) {
+            if (static_cast<uint64_t>(lod.firstIndex) + lod.indexCount > mesh.indices.size()) {
+                throw std::runtime_error("failed to read mesh file: bad lod range!");
+            }
+        }
+        for (const Meshlet& meshlet : mesh.meshlets.meshlets) {
+            uint64_t triangleBytes = static_cast<uint64_t>(meshlet.triangleCount) * 3;
+            if (static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount > mesh.meshlets.vertices.size() ||
+                meshlet.triangleOffset + triangleBytes > mesh.meshlets.triangles.size()) {
+                throw std::runtime_error("failed to read mesh file: bad meshlet range!");
+            }
+            for (uint64_t i = 0; i < triangleBytes; i++) {
+                if (mesh.meshlets.triangles[meshlet.triangleOffset + i] >= meshlet.vertexCount) {
+                    throw std::runtime_error("failed to read mesh file: meshlet triangle out of range!");
+                }
+            }
+        }
+    }
+
+    // The position index of a face corner: "p", "p/t", "p//n" or "p/t/n".
+    long ParseObjIndex(const std::string& corner) {
+        std::string position = corner.substr(0, corner.find('/'));
+        char* end = nullptr;
+        errno = 0;
+        long index = std::strtol(position.c_str(), &end, 10);
+        if (position.empty() || *end != '\0' || errno == ERANGE) {
+            throw std::runtime_error("failed to parse obj face index!");
+        }
+        return index;
+    }
+
+    // OBJ indices are 1-based, negative ones count back from the end.
+    uint32_t ResolveObjIndex(long index, size_t count) {
+        long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+        if (resolved < 0 || static_cast<size_t>(resolved) >= count) {
+            throw std::runtime_error("failed to parse obj face index!");
+        }
+        return static_cast<uint32_t>(resolved);
+    }
+}
+
+MeshAsset VkMesh::BuildAsset(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    MeshAsset mesh;
+    mesh.vertices = vertices;
+    mesh.meshlets = VkMeshlet::Build(vertices, indices);
+    mesh.indices = VkMeshlet::ExpandIndices(mesh.meshlets);
+    mesh.lods = VkLod::BuildLods(mesh.vertices, mesh.indices);
+    return mesh;
+}
+
+void VkMesh::SaveMesh(const std::string& path, const MeshAsset& mesh) {
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to create mesh file!");
+    }
+
+    MeshFileHeader header{};
+    memcpy(header.magic, "V3DM", 4);
+    header.version = MESH_FILE_VERSION;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.lodCount = static_cast<uint32_t>(mesh.lods.size());
+    header.meshletCount = static_cast<uint32_t>(mesh.meshlets.meshlets.size());
+    header.meshletVertexCount = static_cast<uint32_t>(mesh.meshlets.vertices.size());
+    header.meshletTriangleBytes = static_cast<uint32_t>(mesh.meshlets.triangles.size());
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteArray(file, mesh.vertices);
+    WriteArray(file, mesh.indices);
+    WriteArray(file, mesh.lods);
+    WriteArray(file, mesh.meshlets.meshlets);
+    WriteArray(file, mesh.meshlets.bounds);
+    WriteArray(file, mesh.meshlets.vertices);
+    WriteArray(file, mesh.meshlets.triangles);
+
+    if (!file) {
+        throw std::runtime_error("failed to write mesh file!");
+    }
+}
+
+MeshAsset VkMesh::LoadMesh(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open mesh file!");
+    }
+
+    MeshFileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || memcmp(header.magic, "V3DM", 4) != 0) {
+        throw std::runtime_error("failed to read mesh file: bad header!");
+    }
+    if (header.version != MESH_FILE_VERSION) {
+        throw std::runtime_error("failed to read mesh file: unsupported version!");
+    }
+
+    // Check the counts against the file before sizing anything by them.
+    uint64_t payloadBytes =
+        sizeof(Vertex) * static_cast<uint64_t>(header.vertexCount) +
+        sizeof(uint32_t) * static_cast<uint64_t>(header.indexCount) +
+        sizeof(MeshLod) * static_cast<uint64_t>(header.lodCount) +
+        (sizeof(Meshlet) + sizeof(MeshletBounds)) * static_cast<uint64_t>(header.meshletCount) +
+        sizeof(uint32_t) * static_cast<uint64_t>(header.meshletVertexCount) +
+        static_cast<uint64_t>(header.meshletTriangleBytes);
+    if (payloadBytes > RemainingBytes(file)) {
+        throw std::runtime_error("failed to read mesh file: truncated!");
+    }
+
+    MeshAsset mesh;
+    ReadArray(file, mesh.vertices, header.vertexCount);
+    ReadArray(file, mesh.indices, header.indexCount);
+    ReadArray(file, mesh.lods, header.lodCount);
+    ReadArray(file, mesh.meshlets.meshlets, header.meshletCount);
+    ReadArray(file, mesh.meshlets.bounds, header.meshletCount);
+    ReadArray(file, mesh.meshlets.vertices, header.meshletVertexCount);
+    ReadArray(file, mesh.meshlets.triangles, header.meshletTriangleBytes);
+
+    if (!file) {
+        throw std::runtime_error("failed to read mesh file: truncated!");
+    }
+    if (mesh.lods.empty() || mesh.lods.size() > VkLod::MAX_LODS) {
+        throw std::runtime_error("failed to read mesh file: bad lod count!");
+    }
+    ValidateMesh(mesh);
+
+    return mesh;
+}
+
+void VkMesh::LoadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::ifstream file(path);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open obj file!");
+    }
+
+    vertices.clear();
+    indices.clear();
+
+    std::string line;
+    std::vector<uint32_t> face;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        std::string type;
+        in >> type;
+
+        if (type == "v") {
+            Vertex vertex{};
+            in >> vertex.pos.x >> vertex.pos.y >> vertex.pos.z;
+            vertices.push_back(vertex);
+        }
+        else if (type == "f") {
+            face.clear();
+            std::string corner;
+            while (in >> corner) {
+                face.push_back(ResolveObjIndex(ParseObjIndex(corner), vertices.size()));
+            }
+
+            for (size_t i = 1; i + 1 < face.size(); i++) {
+                indices.push_back(face[0]);
+                indices.push_back(face[i]);
+                indices.push_back(face[i + 1]);
+            }
+        }
+    }
+
+    std::vector<glm::vec3> normals(vertices.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const glm::vec3& a = vertices[indices[i]].pos;
+        const glm::vec3& b = vertices[indices[i + 1]].pos;
+        const glm::vec3& c = vertices[indices[i + 2]].pos;
+        glm::vec3 n = glm::cross(b - a, c - a);
+        normals[indices[i]] += n;
+        normals[indices[i + 1]] += n;
+        normals[indices[i + 2]] += n;
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        float length = glm::length(normals[i]);
+        glm::vec3 n = length > 0.0f ? normals[i] / length : glm::vec3(0.0f, 0.0f, 1.0f);
+        vertices[i].color = n * 0.5f + glm::vec3(0.5f);
+    }
+}
+
+int VkMesh::ImportObj(const std::string& objPath, const std::string& meshPath) {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    LoadObj(objPath, vertices, indices);
+
+    MeshAsset mesh = BuildAsset(vertices, indices);
+    SaveMesh(meshPath, mesh);
+
+    std::cout << meshPath << ": " << mesh.vertices.size() << " vertices, "
+              << mesh.lods[0].indexCount / 3 << " triangles, "
+              << mesh.lods.size() << " lods, "
+              << mesh.meshlets.meshlets.size() << " meshlets" << std::endl;
+    return 0;
+}
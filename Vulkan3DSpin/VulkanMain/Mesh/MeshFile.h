@@ -0,0 +1,49 @@
+#pragma once
+#include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Meshlet/Meshlet.h"
+#include "VulkanMain/Lod/Lod.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mesh as stored in a .v3dm file. indices starts with LOD 0 in meshlet
+// order (see VkMeshlet::ExpandIndices), followed by the coarser levels.
+struct MeshAsset {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<MeshLod> lods;
+    MeshletData meshlets;
+};
+
+// .v3dm layout: this header followed by the vertices, indices, LODs,
+// meshlets, meshlet bounds, meshlet vertices and meshlet triangles, each
+// tightly packed.
+struct MeshFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t meshletCount;
+    uint32_t meshletVertexCount;
+    uint32_t meshletTriangleBytes;
+};
+
+namespace VkMesh {
+    constexpr uint32_t MESH_FILE_VERSION = 2;
+
+    // Builds meshlets for an indexed mesh, reorders its indices to match and
+    // bakes the LOD chain.
+    MeshAsset BuildAsset(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    void SaveMesh(const std::string& path, const MeshAsset& mesh);
+    MeshAsset LoadMesh(const std::string& path);
+
+    // Positions and faces of a Wavefront OBJ; polygons are fanned into
+    // triangles and vertices are colored by their smoothed normal.
+    void LoadObj(const std::string& path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+    // "--import-mesh in.obj out.v3dm"
+    int ImportObj(const std::string& objPath, const std::string& meshPath);
+}
@@ -0,0 +1,233 @@
+#include "VulkanMain/Meshlet/Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    constexpr uint32_t NO_SLOT = 0xFFFFFFFFu;
+
+    void FinishMeshlet(MeshletData& data, Meshlet& meshlet, std::vector<uint32_t>& slots) {
+        if (meshlet.triangleCount == 0) {
+            return;
+        }
+
+        for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+            slots[data.vertices[meshlet.vertexOffset + i]] = NO_SLOT;
+        }
+
+        data.meshlets.push_back(meshlet);
+
+        meshlet.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        meshlet.triangleOffset = static_cast<uint32_t>(data.triangles.size());
+        meshlet.vertexCount = 0;
+        meshlet.triangleCount = 0;
+    }
+}
+
+MeshletData VkMeshlet::Build(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    MeshletData data;
+    data.vertices.reserve(indices.size() / 2);
+    data.triangles.reserve(indices.size());
+
+    // Local index of every mesh vertex in the meshlet being filled.
+    std::vector<uint32_t> slots(vertices.size(), NO_SLOT);
+    Meshlet meshlet{};
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        const uint32_t* triangle = &indices[t];
+
+        uint32_t newVertices = 0;
+        for (int k = 0; k < 3; k++) {
+            bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+            if (slots[triangle[k]] == NO_SLOT && !repeated) {
+                newVertices++;
+            }
+        }
+
+        if (meshlet.vertexCount + newVertices > MAX_VERTICES || meshlet.triangleCount + 1 > MAX_TRIANGLES) {
+            FinishMeshlet(data, meshlet, slots);
+        }
+
+        for (int k = 0; k < 3; k++) {
+            uint32_t& slot = slots[triangle[k]];
+            if (slot == NO_SLOT) {
+                slot = meshlet.vertexCount++;
+                data.vertices.push_back(triangle[k]);
+            }
+            data.triangles.push_back(static_cast<uint8_t>(slot));
+        }
+        meshlet.triangleCount++;
+    }
+
+    FinishMeshlet(data, meshlet, slots);
+
+    data.bounds.reserve(data.meshlets.size());
+    for (const auto& m : data.meshlets) {
+        data.bounds.push_back(ComputeBounds(vertices, data, m));
+    }
+
+    return data;
+}
+
+MeshletBounds VkMeshlet::ComputeBounds(const std::vector<Vertex>& vertices, const MeshletData& data, const Meshlet& meshlet) {
+    MeshletBounds bounds{};
+
+    glm::vec3 boxMin(std::numeric_limits<float>::max());
+    glm::vec3 boxMax(-std::numeric_limits<float>::max());
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+        const glm::vec3& p = vertices[data.vertices[meshlet.vertexOffset + i]].pos;
+        boxMin = glm::min(boxMin, p);
+        boxMax = glm::max(boxMax, p);
+    }
+
+    bounds.center = (boxMin + boxMax) * 0.5f;
+    float radiusSq = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+        glm::vec3 d = vertices[data.vertices[meshlet.vertexOffset + i]].pos - bounds.center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+    bounds.radius = std::sqrt(radiusSq);
+
+    // Normal cone: the axis is the average face normal, the spread is the
+    // widest angle between it and any face.
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+
+    glm::vec3 axis(0.0f);
+    for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+        const uint8_t* local = &data.triangles[meshlet.triangleOffset + t * 3];
+        const glm::vec3& a = vertices[data.vertices[meshlet.vertexOffset + local[0]]].pos;
+        const glm::vec3& b = vertices[data.vertices[meshlet.vertexOffset + local[1]]].pos;
+        const glm::vec3& c = vertices[data.vertices[meshlet.vertexOffset + local[2]]].pos;
+
+        glm::vec3 n = glm::cross(b - a, c - a);
+        float length = glm::length(n);
+        if (length <= 0.0f) {
+            continue;
+        }
+
+        normals.push_back(n / length);
+        corners.push_back(a);
+        axis += n / length;
+    }
+
+    bounds.coneApex = bounds.center;
+    bounds.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    bounds.coneCutoff = 1.0f;
+
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength <= 0.0f) {
+        return bounds;
+    }
+    axis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const auto& n : normals) {
+        minDot = std::min(minDot, glm::dot(n, axis));
+    }
+
+    // Cones wider than ~84 degrees cull next to nothing.
+    if (minDot <= 0.1f) {
+        return bounds;
+    }
+
+    // Move the apex back along the axis until it lies behind every face,
+    // so the test holds for cameras close to the cluster as well.
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); i++) {
+        float dc = glm::dot(bounds.center - corners[i], normals[i]);
+        float dn = glm::dot(axis, normals[i]);
+        maxT = std::max(maxT, dc / dn);
+    }
+
+    bounds.coneAxis = axis;
+    bounds.coneApex = bounds.center - axis * maxT;
+    bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    return bounds;
+}
+
+std::vector<uint32_t> VkMeshlet::ExpandIndices(const MeshletData& data) {
+    std::vector<uint32_t> indices(data.triangles.size());
+    for (const auto& meshlet : data.meshlets) {
+        for (uint32_t i = 0; i < meshlet.triangleCount * 3; i++) {
+            uint32_t offset = meshlet.triangleOffset + i;
+            indices[offset] = data.vertices[meshlet.vertexOffset + data.triangles[offset]];
+        }
+    }
+    return indices;
+}
+
+bool VkMeshlet::IsBackfacing(const MeshletBounds& bounds, const glm::vec3& cameraPosition) {
+    if (bounds.coneCutoff >= 1.0f) {
+        return false;
+    }
+
+    glm::vec3 view = bounds.coneApex - cameraPosition;
+    float length = glm::length(view);
+    return length > 0.0f && glm::dot(view, bounds.coneAxis) > bounds.coneCutoff * length;
+}
+
+ClusterStats VkMeshlet::Cull
+(
+    const MeshletData& data,
+    const glm::mat4& world,
+    const Frustum& frustum,
+    const glm::vec3& cameraPosition,
+    std::vector<MeshletDrawRange>& draws
+)
+{
+    ClusterStats stats{};
+
+    // Facing is preserved by affine transforms, so the cone is tested
+    // against the camera moved into object space.
+    glm::vec3 localCamera = glm::vec3(glm::inverse(world) * glm::vec4(cameraPosition, 1.0f));
+    float scale = std::max({
+        glm::length(glm::vec3(world[0])),
+        glm::length(glm::vec3(world[1])),
+        glm::length(glm::vec3(world[2]))
+    });
+
+    bool extend = false;
+    for (size_t i = 0; i < data.meshlets.size(); i++) {
+        const Meshlet& meshlet = data.meshlets[i];
+        const MeshletBounds& bounds = data.bounds[i];
+        stats.tested++;
+
+        bool visible = false;
+        if (IsBackfacing(bounds, localCamera)) {
+            stats.backfacing++;
+        }
+        else {
+            glm::vec3 center = glm::vec3(world * glm::vec4(bounds.center, 1.0f));
+            float radius = bounds.radius * scale;
+            if (!VkCulling::IsVisible(frustum, center, glm::vec3(radius), radius)) {
+                stats.outside++;
+            }
+            else {
+                visible = true;
+            }
+        }
+
+        if (!visible) {
+            extend = false;
+            continue;
+        }
+
+        stats.visible++;
+        stats.triangles += meshlet.triangleCount;
+
+        uint32_t indexCount = meshlet.triangleCount * 3;
+        if (extend) {
+            draws.back().indexCount += indexCount;
+        }
+        else {
+            draws.push_back({ meshlet.triangleOffset, indexCount });
+            extend = true;
+        }
+    }
+
+    return stats;
+}
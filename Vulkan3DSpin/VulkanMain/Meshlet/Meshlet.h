@@ -0,0 +1,90 @@
+#pragma once
+#include "VulkanMain/Vertex/Vertex.h"
+#include "VulkanMain/Culling/Culling.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// A small cluster of triangles. Local vertex indices live in
+// MeshletData::triangles (three bytes per triangle, starting at
+// triangleOffset) and map to mesh vertices through
+// MeshletData::vertices[vertexOffset + local].
+struct Meshlet {
+    uint32_t vertexOffset;
+    uint32_t triangleOffset;
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+// Object-space culling data of one meshlet. The cluster is backfacing for a
+// camera at p when dot(normalize(coneApex - p), coneAxis) > coneCutoff; a
+// cutoff of 1 means the normals spread too far to ever cull.
+struct MeshletBounds {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneApex;
+    float coneCutoff;
+    glm::vec3 coneAxis;
+    float padding;
+};
+
+struct MeshletData {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+// A run of consecutive visible meshlets, drawn with one vkCmdDrawIndexed
+// against the index buffer returned by VkMeshlet::ExpandIndices.
+struct MeshletDrawRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+};
+
+struct ClusterStats {
+    uint32_t tested = 0;
+    uint32_t visible = 0;
+    uint32_t backfacing = 0;
+    uint32_t outside = 0;
+    uint64_t triangles = 0;
+
+    void Add(const ClusterStats& other) {
+        tested += other.tested;
+        visible += other.visible;
+        backfacing += other.backfacing;
+        outside += other.outside;
+        triangles += other.triangles;
+    }
+};
+
+namespace VkMeshlet {
+    constexpr uint32_t MAX_VERTICES = 64;
+    constexpr uint32_t MAX_TRIANGLES = 124;
+
+    // Greedily packs triangles, in index order, into meshlets of at most
+    // MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+    MeshletData Build(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    MeshletBounds ComputeBounds(const std::vector<Vertex>& vertices, const MeshletData& data, const Meshlet& meshlet);
+
+    // Index buffer with the triangles in meshlet order, so that meshlet m
+    // covers [triangleOffset, triangleOffset + triangleCount * 3).
+    std::vector<uint32_t> ExpandIndices(const MeshletData& data);
+
+    bool IsBackfacing(const MeshletBounds& bounds, const glm::vec3& cameraPosition);
+
+    // Tests every meshlet of one object (cone against the camera in object
+    // space, sphere against the frustum in world space) and appends the
+    // surviving runs to draws.
+    ClusterStats Cull
+    (
+        const MeshletData& data,
+        const glm::mat4& world,
+        const Frustum& frustum,
+        const glm::vec3& cameraPosition,
+        std::vector<MeshletDrawRange>& draws
+    );
+}
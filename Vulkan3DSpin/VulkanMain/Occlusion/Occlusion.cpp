@@ -0,0 +1,280 @@
+#include "VulkanMain/Occlusion/Occlusion.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    VkDescriptorSetLayoutBinding ComputeBinding(uint32_t binding, VkDescriptorType type) {
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding = binding;
+        layoutBinding.descriptorType = type;
+        layoutBinding.descriptorCount = 1;
+        layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        return layoutBinding;
+    }
+
+    uint32_t FloorPowerOfTwo(uint32_t value) {
+        uint32_t power = 1;
+        while (power <= value / 2) {
+            power *= 2;
+        }
+        return power;
+    }
+}
+
+VkExtent2D VkOcclusion::HiZExtent(VkExtent2D depthExtent) {
+    return { FloorPowerOfTwo(depthExtent.width), FloorPowerOfTwo(depthExtent.height) };
+}
+
+uint32_t VkOcclusion::HiZLevels(VkExtent2D extent) {
+    uint32_t levels = 1;
+    while ((std::max(extent.width, extent.height) >> levels) > 0) {
+        levels++;
+    }
+    return levels;
+}
+
+bool VkOcclusion::CanSampleDepth(VkPhysicalDevice physicalDevice, VkFormat format) {
+    if (format != VK_FORMAT_D32_SFLOAT && format != VK_FORMAT_D16_UNORM && format != VK_FORMAT_X8_D24_UNORM_PACK32) {
+        return false;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+GpuOcclusionConstants VkOcclusion::MakeConstants(const glm::mat4& viewProj, uint32_t objectCount, uint32_t indexCount, DrawPhase phase, VkExtent2D hizExtent, uint32_t hizLevels) {
+    GpuOcclusionConstants constants{};
+    constants.viewProj = viewProj;
+    constants.objectCount = objectCount;
+    constants.indexCount = indexCount;
+    constants.phase = phase == DrawPhase::Late ? 1 : 0;
+    constants.lateOffset = objectCount;
+    constants.hizSize = glm::vec2(hizExtent.width, hizExtent.height);
+    constants.hizLevels = hizLevels;
+    return constants;
+}
+
+// After CreateGpuCulling, whose buffers the occlusion sets share. The sets
+// themselves are written per frame, once the graph's depth image exists.
+void VkMain::CreateOcclusionCulling() {
+    assert(device != VK_NULL_HANDLE);
+    assert(drawCommandBuffers.size() == MAX_FRAMES_IN_FLIGHT);
+
+    // binding 0: objects, 1: draw commands, 2: draw counts, 3: visibility,
+    // 4: the Hi-Z pyramid.
+    std::vector<VkDescriptorSetLayoutBinding> bindings = VkCompute::StorageBufferBindings(4);
+    bindings.push_back(ComputeBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER));
+    occlusionPipeline = VkCompute::CreatePipeline(device, descriptorLayouts, shaderDirectory + "occlusion.spv", bindings, sizeof(GpuOcclusionConstants), VkOcclusion::WORKGROUP_SIZE);
+
+    // binding 0: the level before (the depth buffer for level 0), 1: the
+    // level written.
+    std::vector<VkDescriptorSetLayoutBinding> hizBindings = {
+        ComputeBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+        ComputeBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+    };
+    hizPipeline = VkCompute::CreatePipeline(device, descriptorLayouts, shaderDirectory + "hiz.spv", hizBindings, sizeof(GpuHiZConstants), VkOcclusion::HIZ_GROUP_SIZE);
+
+    // Both shaders only use texelFetch; the sampler is there because the
+    // descriptors are combined image samplers.
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &hizSampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create Hi-Z sampler!");
+    }
+
+    auto createView = [&](VkImage image, uint32_t baseLevel, uint32_t levelCount) {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = baseLevel;
+        viewInfo.subresourceRange.levelCount = levelCount;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        VkImageView view;
+        if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create Hi-Z image view!");
+        }
+        return view;
+    };
+
+    hizImages.resize(MAX_FRAMES_IN_FLIGHT);
+    hizImagesMemory.resize(MAX_FRAMES_IN_FLIGHT);
+    hizViews.resize(MAX_FRAMES_IN_FLIGHT);
+    hizLevelViews.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.extent = { hizExtent.width, hizExtent.height, 1 };
+        imageInfo.mipLevels = hizLevels;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &hizImages[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create Hi-Z image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, hizImages[i], &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = memRequirements.size;
+        allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (VkMemory::Allocate(device, allocInfo, MemoryCategory::RenderTarget, hizImagesMemory[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate Hi-Z image memory!");
+        }
+        vkBindImageMemory(device, hizImages[i], hizImagesMemory[i], 0);
+
+        hizViews[i] = createView(hizImages[i], 0, hizLevels);
+        for (uint32_t level = 0; level < hizLevels; level++) {
+            hizLevelViews[i].push_back(createView(hizImages[i], level, 1));
+        }
+    }
+
+    // Shared by every frame: each one reads what the one before it wrote.
+    CreateBuffer(
+        sizeof(uint32_t) * objectCount,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        MemoryCategory::Geometry,
+        visibilityBuffer,
+        visibilityBufferMemory
+    );
+    visibilityCleared = false;
+
+    // Filled by AllocateOcclusionSets each frame.
+    occlusionDescriptorSets.assign(MAX_FRAMES_IN_FLIGHT, VK_NULL_HANDLE);
+    hizDescriptorSets.assign(MAX_FRAMES_IN_FLIGHT, std::vector<VkDescriptorSet>(hizLevels, VK_NULL_HANDLE));
+}
+
+// hiz.comp writes through the level views; the sampled reads of the level
+// before it go through the view of the whole pyramid, which is in the
+// general layout while the pyramid is built.
+void VkMain::AllocateOcclusionSets(uint32_t frame) {
+    DescriptorAllocator& allocator = frameDescriptorAllocators[frame];
+    VkSampler noSampler = VK_NULL_HANDLE;
+
+    occlusionDescriptorSets[frame] = allocator.Allocate(occlusionPipeline.setLayout);
+
+    DescriptorInfo descriptors[5] = {
+        DescriptorInfo(objectBuffers[frame]),
+        DescriptorInfo(drawCommandBuffers[frame]),
+        DescriptorInfo(drawCountBuffers[frame]),
+        DescriptorInfo(visibilityBuffer),
+        DescriptorInfo(hizSampler, hizViews[frame], VK_IMAGE_LAYOUT_GENERAL)
+    };
+    VkCompute::WriteSet(device, occlusionPipeline, occlusionDescriptorSets[frame], descriptors);
+
+    for (uint32_t level = 0; level < hizLevels; level++) {
+        VkDescriptorSet set = allocator.Allocate(hizPipeline.setLayout);
+
+        DescriptorInfo hizDescriptors[2] = {
+            level == 0
+                ? DescriptorInfo(hizSampler, frameGraph.ImageView(depthResource), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+                : DescriptorInfo(hizSampler, hizViews[frame], VK_IMAGE_LAYOUT_GENERAL),
+            DescriptorInfo(noSampler, hizLevelViews[frame][level], VK_IMAGE_LAYOUT_GENERAL)
+        };
+        VkCompute::WriteSet(device, hizPipeline, set, hizDescriptors);
+        hizDescriptorSets[frame][level] = set;
+    }
+}
+
+// Between the early draws and the late cull. Each level reads the one
+// before it, so the dispatches are separated by barriers; the graph has
+// already moved the depth buffer to a sampled layout and the pyramid to
+// the general one.
+void VkMain::RecordHiZ(VkCommandBuffer commandBuffer) {
+    // Bottom of pipe: once the early draws are done.
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, currentFrame * TIMESTAMPS_PER_FRAME + 2);
+    }
+
+    VkExtent2D source = swapChainExtent;
+    for (uint32_t level = 0; level < hizLevels; level++) {
+        VkExtent2D destination = { std::max(hizExtent.width >> level, 1u), std::max(hizExtent.height >> level, 1u) };
+
+        GpuHiZConstants constants{};
+        constants.sourceSize = glm::ivec2(source.width, source.height);
+        constants.destinationSize = glm::ivec2(destination.width, destination.height);
+        constants.sourceLevel = level == 0 ? 0 : static_cast<int32_t>(level - 1);
+
+        if (level > 0) {
+            VkCompute::Barrier(commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+        }
+
+        uint32_t groupsX = (destination.width + VkOcclusion::HIZ_GROUP_SIZE - 1) / VkOcclusion::HIZ_GROUP_SIZE;
+        uint32_t groupsY = (destination.height + VkOcclusion::HIZ_GROUP_SIZE - 1) / VkOcclusion::HIZ_GROUP_SIZE;
+        VkCompute::DispatchGroups(commandBuffer, hizPipeline, hizDescriptorSets[currentFrame][level], &constants, groupsX, groupsY, 1);
+
+        source = destination;
+    }
+}
+
+// The count buffer is cleared by the pass before the early phase; the
+// graph orders both phases against the draws that read their lists.
+void VkMain::RecordOcclusionCulling(VkCommandBuffer commandBuffer, DrawPhase phase) {
+    GpuOcclusionConstants constants = VkOcclusion::MakeConstants(
+        frameViewProj,
+        objectCount,
+        meshLods[0].indexCount,
+        phase,
+        hizExtent,
+        hizLevels
+    );
+
+    VkCompute::Dispatch(commandBuffer, occlusionPipeline, occlusionDescriptorSets[currentFrame], &constants, objectCount);
+
+    if (phase == DrawPhase::Late && timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, currentFrame * TIMESTAMPS_PER_FRAME + 3);
+    }
+}
+
+void VkMain::DestroyOcclusionCulling() {
+    for (size_t i = 0; i < hizImages.size(); i++) {
+        for (VkImageView view : hizLevelViews[i]) {
+            vkDestroyImageView(device, view, nullptr);
+        }
+        vkDestroyImageView(device, hizViews[i], nullptr);
+        vkDestroyImage(device, hizImages[i], nullptr);
+        VkMemory::Free(device, hizImagesMemory[i]);
+    }
+    hizImages.clear();
+    hizImagesMemory.clear();
+    hizViews.clear();
+    hizLevelViews.clear();
+    hizDescriptorSets.clear();
+    occlusionDescriptorSets.clear();
+
+    vkDestroyBuffer(device, visibilityBuffer, nullptr);
+    VkMemory::Free(device, visibilityBufferMemory);
+    vkDestroySampler(device, hizSampler, nullptr);
+
+    // The sets go with frameDescriptorAllocators and the layouts with descriptorLayouts.
+    VkCompute::DestroyPipeline(device, hizPipeline);
+    VkCompute::DestroyPipeline(device, occlusionPipeline);
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "VulkanMain/GpuCulling/GpuCulling.h"
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Which GPU-driven draw list a pass records. Without occlusion culling
+// every draw is in the early list.
+enum class DrawPhase : uint32_t {
+    Early,
+    Late,
+    All,
+};
+
+// Push constants of occlusion.comp (96 bytes). The frustum planes come
+// from viewProj in the shader, which keeps this within the 128 bytes every
+// device offers.
+struct GpuOcclusionConstants {
+    glm::mat4 viewProj;
+    uint32_t objectCount;
+    uint32_t indexCount;
+    // 0: objects visible last frame, frustum test only. 1: every object,
+    // frustum and Hi-Z test.
+    uint32_t phase;
+    // First command of the late list in the draw command buffer.
+    uint32_t lateOffset;
+    glm::vec2 hizSize;
+    uint32_t hizLevels;
+    uint32_t padding;
+};
+
+// Push constants of hiz.comp (20 bytes).
+struct GpuHiZConstants {
+    glm::ivec2 sourceSize;
+    glm::ivec2 destinationSize;
+    int32_t sourceLevel;
+};
+
+namespace VkOcclusion {
+    // Must match local_size_x in occlusion.comp.
+    constexpr uint32_t WORKGROUP_SIZE = 64;
+    // Must match local_size_x and local_size_y in hiz.comp.
+    constexpr uint32_t HIZ_GROUP_SIZE = 8;
+
+    // Level 0 of the pyramid: the largest power of two not above the depth
+    // extent on each axis, so every level after it halves exactly.
+    VkExtent2D HiZExtent(VkExtent2D depthExtent);
+    // Down to 1x1.
+    uint32_t HiZLevels(VkExtent2D extent);
+
+    // Depth-only formats the device can sample. The render graph's views of
+    // a combined depth/stencil image cover both aspects, which a sampled
+    // image view may not.
+    bool CanSampleDepth(VkPhysicalDevice physicalDevice, VkFormat format);
+
+    GpuOcclusionConstants MakeConstants(const glm::mat4& viewProj, uint32_t objectCount, uint32_t indexCount, DrawPhase phase, VkExtent2D hizExtent, uint32_t hizLevels);
+}
@@ -0,0 +1,1120 @@
+#include "VulkanMain/RenderGraph/RenderGraph.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Depth/Depth.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    struct UsageInfo {
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        VkImageUsageFlags imageUsage;
+        VkBufferUsageFlags bufferUsage;
+        const char* name;
+    };
+
+    UsageInfo Describe(RgUsage usage) {
+        switch (usage) {
+        case RgUsage::ColorAttachment:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, "color attachment" };
+        case RgUsage::DepthAttachment:
+            return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                     VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, "depth attachment" };
+        case RgUsage::DepthRead:
+            return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                     VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, "depth read" };
+        case RgUsage::SampledFragment:
+            return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, "sampled (fragment)" };
+        case RgUsage::SampledCompute:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT, 0, "sampled (compute)" };
+        case RgUsage::StorageRead:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT,
+                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "storage read" };
+        case RgUsage::StorageWrite:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "storage write" };
+        case RgUsage::IndirectRead:
+            return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                     VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, "indirect read" };
+        case RgUsage::TransferSrc:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, "transfer src" };
+        case RgUsage::TransferDst:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT, "transfer dst" };
+        case RgUsage::Present:
+            return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0, 0, "present" };
+        case RgUsage::HostRead:
+            return { VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT, VK_IMAGE_LAYOUT_GENERAL, 0, 0, "host read" };
+        default:
+            return { 0, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, 0, "none" };
+        }
+    }
+
+    constexpr VkAccessFlags WRITE_ACCESS =
+        VK_ACCESS_SHADER_WRITE_BIT |
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_TRANSFER_WRITE_BIT |
+        VK_ACCESS_HOST_WRITE_BIT |
+        VK_ACCESS_MEMORY_WRITE_BIT;
+
+    bool IsAttachment(RgUsage usage) {
+        return usage == RgUsage::ColorAttachment || usage == RgUsage::DepthAttachment || usage == RgUsage::DepthRead;
+    }
+
+    VkImageAspectFlags AspectOf(VkFormat format) {
+        switch (format) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
+        }
+    }
+
+    VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    std::string StageNames(VkPipelineStageFlags stages) {
+        static const std::pair<VkPipelineStageFlags, const char*> names[] = {
+            { VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, "top" },
+            { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, "indirect" },
+            { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, "vertex" },
+            { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, "early-z" },
+            { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, "fragment" },
+            { VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, "late-z" },
+            { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, "color" },
+            { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, "compute" },
+            { VK_PIPELINE_STAGE_TRANSFER_BIT, "transfer" },
+            { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, "bottom" },
+            { VK_PIPELINE_STAGE_HOST_BIT, "host" },
+        };
+
+        std::string out;
+        for (const auto& name : names) {
+            if (stages & name.first) {
+                out += out.empty() ? "" : "|";
+                out += name.second;
+            }
+        }
+        return out;
+    }
+
+    const char* LayoutName(VkImageLayout layout) {
+        switch (layout) {
+        case VK_IMAGE_LAYOUT_UNDEFINED: return "undefined";
+        case VK_IMAGE_LAYOUT_GENERAL: return "general";
+        case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL: return "color";
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL: return "depth";
+        case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL: return "depth-read";
+        case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL: return "shader-read";
+        case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL: return "transfer-src";
+        case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL: return "transfer-dst";
+        case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR: return "present";
+        default: return "?";
+        }
+    }
+
+    const char* PassTypeName(RgPassType type) {
+        switch (type) {
+        case RgPassType::Graphics: return "graphics";
+        case RgPassType::Compute: return "compute";
+        default: return "transfer";
+        }
+    }
+
+    std::string Megabytes(VkDeviceSize bytes) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MiB";
+        return out.str();
+    }
+}
+
+void RenderGraph::Init(VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice) {
+    device = vkDevice;
+    physicalDevice = vkPhysicalDevice;
+}
+
+void RenderGraph::UseDynamicRendering(PFN_vkCmdBeginRenderingKHR begin, PFN_vkCmdEndRenderingKHR end) {
+    assert(begin != nullptr && end != nullptr);
+    cmdBeginRendering = begin;
+    cmdEndRendering = end;
+}
+
+void RenderGraph::Destroy() {
+    ReleaseCompiled();
+    resources.clear();
+    passes.clear();
+}
+
+RgHandle RenderGraph::AddResource(Resource resource) {
+    resources.push_back(std::move(resource));
+    return static_cast<RgHandle>(resources.size() - 1);
+}
+
+RgHandle RenderGraph::CreateImage(const std::string& name, VkFormat format, VkExtent2D extent) {
+    Resource resource;
+    resource.name = name;
+    resource.isImage = true;
+    resource.format = format;
+    resource.extent = extent;
+    return AddResource(std::move(resource));
+}
+
+RgHandle RenderGraph::CreateBuffer(const std::string& name, VkDeviceSize size) {
+    Resource resource;
+    resource.name = name;
+    resource.size = size;
+    return AddResource(std::move(resource));
+}
+
+RgHandle RenderGraph::ImportImage(const std::string& name, VkFormat format, VkExtent2D extent, RgUsage finalUsage, VkPipelineStageFlags waitStage) {
+    Resource resource;
+    resource.name = name;
+    resource.isImage = true;
+    resource.imported = true;
+    resource.format = format;
+    resource.extent = extent;
+    resource.finalUsage = finalUsage;
+    resource.waitStage = waitStage;
+    return AddResource(std::move(resource));
+}
+
+RgHandle RenderGraph::ImportBuffer(const std::string& name, VkDeviceSize size, RgUsage finalUsage) {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.size = size;
+    resource.finalUsage = finalUsage;
+    return AddResource(std::move(resource));
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, RgPassType type, ExecuteFn execute) {
+    Pass pass;
+    pass.name = name;
+    pass.type = type;
+    pass.execute = std::move(execute);
+    passes.push_back(std::move(pass));
+    return static_cast<uint32_t>(passes.size() - 1);
+}
+
+void RenderGraph::AddAccess(uint32_t pass, RgHandle resource, RgUsage usage, bool write) {
+    assert(pass < passes.size() && resource < resources.size());
+    UsageInfo info = Describe(usage);
+
+    for (Access& access : passes[pass].accesses) {
+        if (access.resource != resource) {
+            continue;
+        }
+        if (resources[resource].isImage && access.layout != info.layout) {
+            throw std::runtime_error("render graph pass uses an image in two layouts!");
+        }
+        access.stage |= info.stage;
+        access.access |= info.access;
+        access.write |= write;
+        return;
+    }
+
+    passes[pass].accesses.push_back({ resource, usage, info.stage, info.access, info.layout, write, false, {} });
+}
+
+void RenderGraph::Read(uint32_t pass, RgHandle resource, RgUsage usage) {
+    AddAccess(pass, resource, usage, false);
+}
+
+void RenderGraph::Write(uint32_t pass, RgHandle resource, RgUsage usage) {
+    AddAccess(pass, resource, usage, true);
+}
+
+void RenderGraph::Clear(uint32_t pass, RgHandle attachment, VkClearValue value) {
+    for (Access& access : passes[pass].accesses) {
+        if (access.resource == attachment && access.write && IsAttachment(access.usage)) {
+            access.clear = true;
+            access.clearValue = value;
+            return;
+        }
+    }
+    throw std::runtime_error("render graph clear needs an attachment the pass writes!");
+}
+
+void RenderGraph::KeepAlive(uint32_t pass) {
+    passes[pass].keepAlive = true;
+}
+
+void RenderGraph::SetImage(RgHandle resource, VkImage image, VkImageView view) {
+    assert(resources[resource].imported && resources[resource].isImage);
+    resources[resource].image = image;
+    resources[resource].view = view;
+}
+
+void RenderGraph::SetBuffer(RgHandle resource, VkBuffer buffer) {
+    assert(resources[resource].imported && !resources[resource].isImage);
+    resources[resource].buffer = buffer;
+}
+
+void RenderGraph::Compile() {
+    assert(device != VK_NULL_HANDLE);
+    ReleaseCompiled();
+
+    CullPasses();
+    ComputeLifetimes();
+    CreateTransients();
+    PlaceTransients();
+    PlanBarriers();
+    CreateAttachments();
+}
+
+void RenderGraph::ReleaseCompiled() {
+    for (Pass& pass : passes) {
+        for (auto& entry : pass.framebuffers) {
+            vkDestroyFramebuffer(device, entry.second, nullptr);
+        }
+        pass.framebuffers.clear();
+        if (pass.renderPass != VK_NULL_HANDLE) {
+            vkDestroyRenderPass(device, pass.renderPass, nullptr);
+        }
+        pass.renderPass = VK_NULL_HANDLE;
+        pass.attachments.clear();
+        pass.layouts.clear();
+        pass.clearValues.clear();
+        pass.loadOps.clear();
+        pass.storeOps.clear();
+        pass.colorFormats.clear();
+        pass.depthFormat = VK_FORMAT_UNDEFINED;
+        pass.barriers = BarrierBatch{};
+    }
+
+    for (Resource& resource : resources) {
+        resource.firstUse = UINT32_MAX;
+        resource.lastUse = 0;
+        resource.heap = UINT32_MAX;
+        if (resource.imported) {
+            continue;
+        }
+        if (resource.view != VK_NULL_HANDLE) {
+            vkDestroyImageView(device, resource.view, nullptr);
+        }
+        if (resource.image != VK_NULL_HANDLE) {
+            vkDestroyImage(device, resource.image, nullptr);
+        }
+        if (resource.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(device, resource.buffer, nullptr);
+        }
+        resource.view = VK_NULL_HANDLE;
+        resource.image = VK_NULL_HANDLE;
+        resource.buffer = VK_NULL_HANDLE;
+    }
+
+    for (Heap& heap : heaps) {
+        VkMemory::Free(device, heap.memory);
+    }
+    heaps.clear();
+    order.clear();
+    finalBarriers = BarrierBatch{};
+    stats = RgStats{};
+}
+
+// Walks the passes backwards keeping those that write something a later
+// live pass reads, an imported resource, or that are marked KeepAlive.
+void RenderGraph::CullPasses() {
+    std::vector<bool> needed(resources.size());
+    for (size_t i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].imported;
+    }
+
+    for (size_t i = passes.size(); i-- > 0;) {
+        Pass& pass = passes[i];
+        pass.live = pass.keepAlive;
+        for (const Access& access : pass.accesses) {
+            pass.live |= access.write && needed[access.resource];
+        }
+        if (!pass.live) {
+            continue;
+        }
+
+        // A cleared attachment does not depend on earlier writers; any
+        // other access, writes included, keeps what came before.
+        for (const Access& access : pass.accesses) {
+            needed[access.resource] = !access.clear;
+        }
+    }
+
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (passes[i].live) {
+            order.push_back(i);
+        }
+    }
+    stats.passes = static_cast<uint32_t>(order.size());
+    stats.culledPasses = static_cast<uint32_t>(passes.size() - order.size());
+}
+
+void RenderGraph::ComputeLifetimes() {
+    for (uint32_t position = 0; position < order.size(); position++) {
+        const Pass& pass = passes[order[position]];
+        for (const Access& access : pass.accesses) {
+            Resource& resource = resources[access.resource];
+            UsageInfo info = Describe(access.usage);
+
+            // Contents of a transient exist only once a pass has written them.
+            if (!resource.imported && resource.firstUse == UINT32_MAX && !access.write) {
+                throw std::runtime_error("render graph pass " + pass.name + " reads " + resource.name + " before it is written!");
+            }
+
+            resource.firstUse = std::min(resource.firstUse, position);
+            resource.lastUse = std::max(resource.lastUse, position);
+            resource.imageUsage |= info.imageUsage;
+            resource.bufferUsage |= info.bufferUsage;
+        }
+    }
+}
+
+void RenderGraph::CreateTransients() {
+    for (Resource& resource : resources) {
+        if (resource.imported || resource.firstUse == UINT32_MAX) {
+            continue;
+        }
+
+        VkMemoryRequirements memRequirements;
+        if (resource.isImage) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.format = resource.format;
+            imageInfo.extent = { resource.extent.width, resource.extent.height, 1 };
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.usage = resource.imageUsage;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+            if (vkCreateImage(device, &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create render graph image!");
+            }
+            vkGetImageMemoryRequirements(device, resource.image, &memRequirements);
+        }
+        else {
+            VkBufferCreateInfo bufferInfo{};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = resource.size;
+            bufferInfo.usage = resource.bufferUsage;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateBuffer(device, &bufferInfo, nullptr, &resource.buffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create render graph buffer!");
+            }
+            vkGetBufferMemoryRequirements(device, resource.buffer, &memRequirements);
+        }
+
+        resource.memorySize = memRequirements.size;
+        resource.alignment = memRequirements.alignment;
+        resource.memoryTypeBits = memRequirements.memoryTypeBits;
+    }
+}
+
+// Largest first, each transient goes to the lowest offset of its heap that
+// no resource alive at the same time occupies. Images and buffers use
+// separate heaps so bufferImageGranularity never applies.
+void RenderGraph::PlaceTransients() {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    auto chooseType = [&](uint32_t typeBits) {
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if ((typeBits & (1u << i)) && (memProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+                return i;
+            }
+        }
+        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+            if (typeBits & (1u << i)) {
+                return i;
+            }
+        }
+        throw std::runtime_error("failed to find suitable memory type!");
+    };
+
+    std::vector<RgHandle> transients;
+    for (RgHandle i = 0; i < resources.size(); i++) {
+        if (!resources[i].imported && resources[i].firstUse != UINT32_MAX) {
+            transients.push_back(i);
+        }
+    }
+    std::stable_sort(transients.begin(), transients.end(), [&](RgHandle a, RgHandle b) {
+        return resources[a].memorySize > resources[b].memorySize;
+    });
+
+    auto livesOverlap = [&](const Resource& a, const Resource& b) {
+        return a.firstUse <= b.lastUse && b.firstUse <= a.lastUse;
+    };
+
+    std::vector<std::vector<RgHandle>> placed;
+    for (RgHandle handle : transients) {
+        Resource& resource = resources[handle];
+        uint32_t memoryType = chooseType(resource.memoryTypeBits);
+
+        uint32_t heapIndex = 0;
+        while (heapIndex < heaps.size() && (heaps[heapIndex].memoryType != memoryType || heaps[heapIndex].images != resource.isImage)) {
+            heapIndex++;
+        }
+        if (heapIndex == heaps.size()) {
+            heaps.push_back({ memoryType, resource.isImage });
+            placed.emplace_back();
+        }
+
+        VkDeviceSize offset = 0;
+        for (bool moved = true; moved;) {
+            moved = false;
+            for (RgHandle other : placed[heapIndex]) {
+                const Resource& o = resources[other];
+                if (livesOverlap(resource, o) && offset < o.offset + o.memorySize && o.offset < offset + resource.memorySize) {
+                    offset = AlignUp(o.offset + o.memorySize, resource.alignment);
+                    moved = true;
+                }
+            }
+        }
+
+        resource.heap = heapIndex;
+        resource.offset = offset;
+        heaps[heapIndex].size = std::max(heaps[heapIndex].size, offset + resource.memorySize);
+        placed[heapIndex].push_back(handle);
+        stats.transientBytes += resource.memorySize;
+    }
+
+    for (Heap& heap : heaps) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = heap.size;
+        allocInfo.memoryTypeIndex = heap.memoryType;
+
+        if (VkMemory::Allocate(device, allocInfo, MemoryCategory::RenderTarget, heap.memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate render graph memory!");
+        }
+        stats.allocatedBytes += heap.size;
+    }
+
+    for (RgHandle handle : transients) {
+        Resource& resource = resources[handle];
+        VkDeviceMemory memory = heaps[resource.heap].memory;
+
+        if (!resource.isImage) {
+            vkBindBufferMemory(device, resource.buffer, memory, resource.offset);
+            continue;
+        }
+
+        vkBindImageMemory(device, resource.image, memory, resource.offset);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = resource.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = resource.format;
+        viewInfo.subresourceRange.aspectMask = AspectOf(resource.format);
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device, &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph image view!");
+        }
+    }
+}
+
+void RenderGraph::PlanBarriers() {
+    // The last access of each resource in a frame. Whatever uses the same
+    // memory next, later in this frame or early in the next, waits for it.
+    std::vector<VkPipelineStageFlags> lastStage(resources.size(), 0);
+    std::vector<VkAccessFlags> lastWrite(resources.size(), 0);
+    for (uint32_t p : order) {
+        for (const Access& access : passes[p].accesses) {
+            lastStage[access.resource] = access.stage;
+            lastWrite[access.resource] = access.write ? (access.access & WRITE_ACCESS) : 0;
+        }
+    }
+
+    std::vector<SyncState> states(resources.size());
+    for (RgHandle i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (resource.imported) {
+            states[i].writeStage = resource.waitStage;
+            continue;
+        }
+        if (resource.heap == UINT32_MAX) {
+            continue;
+        }
+
+        for (RgHandle j = 0; j < resources.size(); j++) {
+            const Resource& other = resources[j];
+            if (other.heap == resource.heap && other.offset < resource.offset + resource.memorySize && resource.offset < other.offset + other.memorySize) {
+                states[i].writeStage |= lastStage[j];
+                states[i].writeAccess |= lastWrite[j];
+            }
+        }
+    }
+
+    for (uint32_t p : order) {
+        Pass& pass = passes[p];
+        for (const Access& access : pass.accesses) {
+            Transition(states[access.resource], access.resource, access.stage, access.access, access.layout, access.write, pass.barriers);
+        }
+    }
+
+    for (RgHandle i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (resource.imported && resource.finalUsage != RgUsage::None && resource.firstUse != UINT32_MAX) {
+            UsageInfo info = Describe(resource.finalUsage);
+            Transition(states[i], i, info.stage, info.access, info.layout, false, finalBarriers);
+        }
+    }
+
+    auto count = [&](const BarrierBatch& batch) {
+        if (batch.Empty()) {
+            return;
+        }
+        stats.barrierBatches++;
+        stats.imageBarriers += static_cast<uint32_t>(batch.images.size());
+        stats.memoryBarriers += (batch.srcAccess | batch.dstAccess) != 0 ? 1 : 0;
+    };
+    for (uint32_t p : order) {
+        count(passes[p].barriers);
+    }
+    count(finalBarriers);
+}
+
+void RenderGraph::Transition
+(
+    SyncState& state,
+    RgHandle resource,
+    VkPipelineStageFlags stage,
+    VkAccessFlags access,
+    VkImageLayout layout,
+    bool write,
+    BarrierBatch& batch
+) const
+{
+    bool layoutChange = resources[resource].isImage && layout != state.layout;
+    VkPipelineStageFlags srcStage = 0;
+    VkAccessFlags srcAccess = 0;
+
+    // Read or write after write, unless an earlier barrier already made the
+    // write visible to this stage and access.
+    if (state.writeStage != 0 && (write || (stage & ~state.visibleStages) || (access & ~state.visibleAccess))) {
+        srcStage |= state.writeStage;
+        srcAccess |= state.writeAccess;
+    }
+    // Write after read only has to wait for the reads to execute.
+    if (write) {
+        srcStage |= state.readStages;
+    }
+
+    bool barrier = srcStage != 0 || layoutChange;
+    if (barrier) {
+        // Nothing to wait for but a layout change still needs a source stage.
+        batch.srcStage |= srcStage != 0 ? srcStage : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+        batch.dstStage |= stage;
+        if (layoutChange) {
+            batch.images.push_back({ resource, srcAccess, access, state.layout, layout });
+        }
+        else if (srcAccess != 0) {
+            batch.srcAccess |= srcAccess;
+            batch.dstAccess |= access;
+        }
+    }
+
+    // A layout transition counts as a write every later access has to wait for.
+    if (write || layoutChange) {
+        state.layout = resources[resource].isImage ? layout : state.layout;
+        state.writeStage = stage;
+        state.writeAccess = write ? (access & WRITE_ACCESS) : 0;
+        state.visibleStages = write ? 0 : stage;
+        state.visibleAccess = write ? 0 : access;
+        state.readStages = write ? 0 : stage;
+        return;
+    }
+
+    if (barrier) {
+        state.visibleStages |= stage;
+        state.visibleAccess |= access;
+    }
+    state.readStages |= stage;
+}
+
+// Works out each graphics pass's attachments and their load/store ops; the
+// render pass path also bakes them into a VkRenderPass.
+void RenderGraph::CreateAttachments() {
+    for (uint32_t position = 0; position < order.size(); position++) {
+        Pass& pass = passes[order[position]];
+        if (pass.type != RgPassType::Graphics) {
+            continue;
+        }
+
+        // Color attachments first, then at most one depth attachment.
+        std::vector<const Access*> attachments;
+        const Access* depth = nullptr;
+        for (const Access& access : pass.accesses) {
+            if (access.usage == RgUsage::ColorAttachment) {
+                attachments.push_back(&access);
+            }
+            else if (access.usage == RgUsage::DepthAttachment || access.usage == RgUsage::DepthRead) {
+                depth = &access;
+            }
+        }
+        uint32_t colorCount = static_cast<uint32_t>(attachments.size());
+        if (depth != nullptr) {
+            attachments.push_back(depth);
+        }
+        if (attachments.empty()) {
+            continue;
+        }
+
+        std::vector<VkAttachmentDescription> descriptions;
+        std::vector<VkAttachmentReference> references;
+        for (uint32_t i = 0; i < attachments.size(); i++) {
+            const Access& access = *attachments[i];
+            const Resource& resource = resources[access.resource];
+
+            // Load only what an earlier pass left behind, store only what a
+            // later pass or the outside world will look at.
+            VkAttachmentLoadOp loadOp = access.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR
+                : resource.firstUse < position ? VK_ATTACHMENT_LOAD_OP_LOAD
+                : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            VkAttachmentStoreOp storeOp = resource.imported || resource.lastUse > position
+                ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+            VkAttachmentDescription description{};
+            description.format = resource.format;
+            description.samples = VK_SAMPLE_COUNT_1_BIT;
+            description.loadOp = loadOp;
+            description.storeOp = storeOp;
+            description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            // The graph's barriers have the image in this layout already.
+            description.initialLayout = access.layout;
+            description.finalLayout = access.layout;
+            descriptions.push_back(description);
+            references.push_back({ i, access.layout });
+
+            pass.attachments.push_back(access.resource);
+            pass.layouts.push_back(access.layout);
+            pass.clearValues.push_back(access.clearValue);
+            pass.loadOps.push_back(loadOp);
+            pass.storeOps.push_back(storeOp);
+            if (i < colorCount) {
+                pass.colorFormats.push_back(resource.format);
+            }
+            else {
+                pass.depthFormat = resource.format;
+            }
+        }
+
+        if (DynamicRendering()) {
+            continue;
+        }
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = colorCount;
+        subpass.pColorAttachments = references.data();
+        subpass.pDepthStencilAttachment = depth != nullptr ? &references[colorCount] : nullptr;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = static_cast<uint32_t>(descriptions.size());
+        renderPassInfo.pAttachments = descriptions.data();
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+
+        if (vkCreateRenderPass(device, &renderPassInfo, nullptr, &pass.renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render pass!");
+        }
+    }
+}
+
+VkFramebuffer RenderGraph::GetFramebuffer(Pass& pass) {
+    std::vector<VkImageView> views;
+    for (RgHandle attachment : pass.attachments) {
+        views.push_back(resources[attachment].view);
+    }
+
+    auto found = pass.framebuffers.find(views);
+    if (found != pass.framebuffers.end()) {
+        return found->second;
+    }
+
+    const Resource& first = resources[pass.attachments[0]];
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = pass.renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments = views.data();
+    framebufferInfo.width = first.extent.width;
+    framebufferInfo.height = first.extent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create framebuffer!");
+    }
+    pass.framebuffers.emplace(std::move(views), framebuffer);
+    return framebuffer;
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer) {
+    for (uint32_t p : order) {
+        Pass& pass = passes[p];
+        RecordBarriers(commandBuffer, pass.barriers);
+
+        if (pass.attachments.empty()) {
+            pass.execute(commandBuffer);
+        }
+        else if (DynamicRendering()) {
+            BeginRendering(commandBuffer, pass);
+            pass.execute(commandBuffer);
+            cmdEndRendering(commandBuffer);
+        }
+        else {
+            BeginRenderPass(commandBuffer, pass);
+            pass.execute(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    }
+
+    RecordBarriers(commandBuffer, finalBarriers);
+}
+
+void RenderGraph::BeginRenderPass(VkCommandBuffer commandBuffer, Pass& pass) {
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = pass.renderPass;
+    renderPassInfo.framebuffer = GetFramebuffer(pass);
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = resources[pass.attachments[0]].extent;
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+    renderPassInfo.pClearValues = pass.clearValues.data();
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+// Same attachments, ops and layouts the render pass path bakes in, taken
+// from this frame's views so nothing has to be cached per swapchain image.
+void RenderGraph::BeginRendering(VkCommandBuffer commandBuffer, const Pass& pass) {
+    renderingAttachmentScratch.clear();
+    for (size_t i = 0; i < pass.attachments.size(); i++) {
+        VkRenderingAttachmentInfoKHR attachment{};
+        attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        attachment.imageView = resources[pass.attachments[i]].view;
+        attachment.imageLayout = pass.layouts[i];
+        attachment.loadOp = pass.loadOps[i];
+        attachment.storeOp = pass.storeOps[i];
+        attachment.clearValue = pass.clearValues[i];
+        renderingAttachmentScratch.push_back(attachment);
+    }
+
+    uint32_t colorCount = static_cast<uint32_t>(pass.colorFormats.size());
+    bool hasDepth = pass.depthFormat != VK_FORMAT_UNDEFINED;
+
+    VkRenderingInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = resources[pass.attachments[0]].extent;
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = colorCount;
+    renderingInfo.pColorAttachments = renderingAttachmentScratch.data();
+    renderingInfo.pDepthAttachment = hasDepth ? &renderingAttachmentScratch[colorCount] : nullptr;
+
+    cmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch) {
+    if (batch.Empty()) {
+        return;
+    }
+
+    imageBarrierScratch.clear();
+    for (const ImageBarrier& image : batch.images) {
+        const Resource& resource = resources[image.resource];
+        assert(resource.image != VK_NULL_HANDLE);
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = image.srcAccess;
+        barrier.dstAccessMask = image.dstAccess;
+        barrier.oldLayout = image.oldLayout;
+        barrier.newLayout = image.newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = resource.image;
+        barrier.subresourceRange.aspectMask = AspectOf(resource.format);
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        imageBarrierScratch.push_back(barrier);
+    }
+
+    VkMemoryBarrier memoryBarrier{};
+    memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarrier.srcAccessMask = batch.srcAccess;
+    memoryBarrier.dstAccessMask = batch.dstAccess;
+    bool global = (batch.srcAccess | batch.dstAccess) != 0;
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        batch.srcStage,
+        batch.dstStage,
+        0,
+        global ? 1 : 0, global ? &memoryBarrier : nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(imageBarrierScratch.size()), imageBarrierScratch.data()
+    );
+}
+
+std::string RenderGraph::Dump() const {
+    std::ostringstream out;
+
+    auto dumpBarriers = [&](const BarrierBatch& batch) {
+        if (batch.Empty()) {
+            return;
+        }
+        out << "      barrier " << StageNames(batch.srcStage) << " -> " << StageNames(batch.dstStage);
+        if ((batch.srcAccess | batch.dstAccess) != 0) {
+            out << ", memory";
+        }
+        for (const ImageBarrier& image : batch.images) {
+            out << ", " << resources[image.resource].name << " " << LayoutName(image.oldLayout) << " -> " << LayoutName(image.newLayout);
+        }
+        out << "\n";
+    };
+
+    out << "render graph: " << order.size() << " of " << passes.size() << " passes live, "
+        << (DynamicRendering() ? "dynamic rendering" : "render passes") << "\n";
+    for (uint32_t position = 0; position < order.size(); position++) {
+        const Pass& pass = passes[order[position]];
+        out << "  [" << position << "] " << pass.name << " (" << PassTypeName(pass.type) << ")\n";
+        dumpBarriers(pass.barriers);
+
+        for (const Access& access : pass.accesses) {
+            out << "      " << (access.write ? "writes " : "reads  ") << resources[access.resource].name
+                << " as " << Describe(access.usage).name;
+            for (size_t i = 0; i < pass.attachments.size(); i++) {
+                if (pass.attachments[i] == access.resource) {
+                    out << (pass.loadOps[i] == VK_ATTACHMENT_LOAD_OP_CLEAR ? ", clear" : pass.loadOps[i] == VK_ATTACHMENT_LOAD_OP_LOAD ? ", load" : ", don't care")
+                        << (pass.storeOps[i] == VK_ATTACHMENT_STORE_OP_STORE ? "/store" : "/discard");
+                }
+            }
+            out << "\n";
+        }
+    }
+    if (!finalBarriers.Empty()) {
+        out << "  end of frame\n";
+        dumpBarriers(finalBarriers);
+    }
+    for (const Pass& pass : passes) {
+        if (!pass.live) {
+            out << "  culled " << pass.name << "\n";
+        }
+    }
+
+    out << "resources:\n";
+    for (const Resource& resource : resources) {
+        out << "  " << std::left << std::setw(20) << resource.name << std::right
+            << (resource.imported ? " imported " : " transient") << (resource.isImage ? " image " : " buffer");
+        if (resource.firstUse == UINT32_MAX) {
+            out << " unused\n";
+            continue;
+        }
+        out << " passes " << resource.firstUse << ".." << resource.lastUse;
+        if (resource.heap != UINT32_MAX) {
+            out << ", " << Megabytes(resource.memorySize) << " at heap " << resource.heap << " + " << resource.offset;
+        }
+        out << "\n";
+    }
+
+    out << "barriers: " << stats.barrierBatches << " batches, " << stats.imageBarriers << " image, " << stats.memoryBarriers << " memory\n";
+    out << "transient memory: " << Megabytes(stats.transientBytes) << " in " << Megabytes(stats.allocatedBytes)
+        << " (" << Megabytes(stats.transientBytes - stats.allocatedBytes) << " saved by aliasing)\n";
+    return out.str();
+}
+
+void VkMain::CreateRenderGraph() {
+    frameGraph.Init(device, physicalDevice);
+    if (dynamicRendering) {
+        frameGraph.UseDynamicRendering(cmdBeginRendering, cmdEndRendering);
+    }
+
+    // The swapchain image is acquired with a semaphore waited on at the
+    // color output stage and handed back to the presentation engine. The
+    // benchmark's offscreen targets are left ready to be copied out.
+    if (benchmarking) {
+        backbufferResource = frameGraph.ImportImage("backbuffer", swapChainImageFormat, swapChainExtent, RgUsage::TransferSrc);
+    }
+    else {
+        backbufferResource = frameGraph.ImportImage("backbuffer", swapChainImageFormat, swapChainExtent, RgUsage::Present, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+
+    depthFormat = VkDepth::FindDepthFormat(physicalDevice);
+    if (occlusionCulling && !VkOcclusion::CanSampleDepth(physicalDevice, depthFormat)) {
+        std::cout << "The depth buffer cannot be sampled for occlusion culling, disabling it" << std::endl;
+        occlusionCulling = false;
+    }
+
+    if (gpuDrivenCulling) {
+        uint32_t drawLists = occlusionCulling ? 2 : 1;
+        drawCommandsResource = frameGraph.ImportBuffer("draw-commands", sizeof(VkDrawIndexedIndirectCommand) * objectCount * drawLists);
+        // ReadGpuCullingStats reads the counts once the frame's fence signals.
+        drawCountResource = frameGraph.ImportBuffer("draw-count", sizeof(GpuDrawCounts), RgUsage::HostRead);
+    }
+
+    // The pyramid is rebuilt every frame. Visibility outlives the frame:
+    // ending as a storage read orders the late phase's writes before the
+    // early phase of the next frame.
+    if (occlusionCulling) {
+        hizExtent = VkOcclusion::HiZExtent(swapChainExtent);
+        hizLevels = VkOcclusion::HiZLevels(hizExtent);
+        hizResource = frameGraph.ImportImage("hiz", VK_FORMAT_R32_SFLOAT, hizExtent, RgUsage::StorageRead);
+        visibilityResource = frameGraph.ImportBuffer("visibility", sizeof(uint32_t) * objectCount, RgUsage::StorageRead);
+    }
+
+    // With async compute the buffers arrive filled, ordered by the submit's
+    // semaphore wait, and the graph only sees the draws read them.
+    if (gpuDrivenCulling && !asyncComputeEnabled) {
+        uint32_t clearPass = frameGraph.AddPass("clear-draw-count", RgPassType::Transfer, [this](VkCommandBuffer commandBuffer) {
+            vkCmdFillBuffer(commandBuffer, drawCountBuffers[currentFrame], 0, sizeof(GpuDrawCounts), 0);
+            // Nothing was visible before the first frame.
+            if (occlusionCulling && !visibilityCleared) {
+                vkCmdFillBuffer(commandBuffer, visibilityBuffer, 0, VK_WHOLE_SIZE, 0);
+                visibilityCleared = true;
+            }
+        });
+        frameGraph.Write(clearPass, drawCountResource, RgUsage::TransferDst);
+        if (occlusionCulling) {
+            frameGraph.Write(clearPass, visibilityResource, RgUsage::TransferDst);
+        }
+
+        // With occlusion culling this is the early phase; the late one
+        // follows the early draws.
+        uint32_t cullPass = frameGraph.AddPass(occlusionCulling ? "occlusion-cull-early" : "gpu-cull", RgPassType::Compute, [this](VkCommandBuffer commandBuffer) {
+            if (occlusionCulling) {
+                RecordOcclusionCulling(commandBuffer, DrawPhase::Early);
+            }
+            else {
+                RecordGpuCulling(commandBuffer, frameViewProj);
+            }
+        });
+        if (occlusionCulling) {
+            frameGraph.Read(cullPass, visibilityResource, RgUsage::StorageRead);
+        }
+        frameGraph.Write(cullPass, drawCommandsResource, RgUsage::StorageWrite);
+        frameGraph.Write(cullPass, drawCountResource, RgUsage::StorageWrite);
+    }
+
+    // Transient: cleared by whichever pass writes it first, never stored
+    // past the forward pass.
+    depthResource = frameGraph.CreateImage("depth", depthFormat, swapChainExtent);
+    VkClearValue clearDepth{};
+    clearDepth.depthStencil = { 1.0f, 0 };
+
+    // The second half of occlusion culling: the pyramid of the depth the
+    // early draws left, the late cull against it, and a pass drawing the
+    // late list on top of the early one (depth only when there is a
+    // pre-pass, since the forward pass then draws both lists).
+    auto addLatePasses = [&]() {
+        uint32_t hizPass = frameGraph.AddPass("hiz-build", RgPassType::Compute, [this](VkCommandBuffer commandBuffer) {
+            RecordHiZ(commandBuffer);
+        });
+        frameGraph.Read(hizPass, depthResource, RgUsage::SampledCompute);
+        frameGraph.Write(hizPass, hizResource, RgUsage::StorageWrite);
+
+        uint32_t latePass = frameGraph.AddPass("occlusion-cull-late", RgPassType::Compute, [this](VkCommandBuffer commandBuffer) {
+            RecordOcclusionCulling(commandBuffer, DrawPhase::Late);
+        });
+        frameGraph.Read(latePass, hizResource, RgUsage::StorageRead);
+        frameGraph.Write(latePass, visibilityResource, RgUsage::StorageWrite);
+        frameGraph.Write(latePass, drawCommandsResource, RgUsage::StorageWrite);
+        frameGraph.Write(latePass, drawCountResource, RgUsage::StorageWrite);
+
+        uint32_t drawPass;
+        if (depthPrepass) {
+            drawPass = frameGraph.AddPass("depth-prepass-late", RgPassType::Graphics, [this](VkCommandBuffer commandBuffer) {
+                RecordDepthPrepass(commandBuffer, DrawPhase::Late);
+            });
+        }
+        else {
+            drawPass = frameGraph.AddPass("forward-late", RgPassType::Graphics, [this](VkCommandBuffer commandBuffer) {
+                RecordForwardPass(commandBuffer, DrawPhase::Late);
+            });
+            frameGraph.Write(drawPass, backbufferResource, RgUsage::ColorAttachment);
+        }
+        frameGraph.Write(drawPass, depthResource, RgUsage::DepthAttachment);
+        frameGraph.Read(drawPass, drawCommandsResource, RgUsage::IndirectRead);
+        frameGraph.Read(drawPass, drawCountResource, RgUsage::IndirectRead);
+    };
+
+    if (depthPrepass) {
+        depthPrepassPass = frameGraph.AddPass("depth-prepass", RgPassType::Graphics, [this](VkCommandBuffer commandBuffer) {
+            RecordDepthPrepass(commandBuffer, DrawPhase::Early);
+        });
+        frameGraph.Write(depthPrepassPass, depthResource, RgUsage::DepthAttachment);
+        frameGraph.Clear(depthPrepassPass, depthResource, clearDepth);
+        if (gpuDrivenCulling) {
+            frameGraph.Read(depthPrepassPass, drawCommandsResource, RgUsage::IndirectRead);
+            frameGraph.Read(depthPrepassPass, drawCountResource, RgUsage::IndirectRead);
+        }
+        if (occlusionCulling) {
+            addLatePasses();
+        }
+    }
+
+    forwardPass = frameGraph.AddPass("forward", RgPassType::Graphics, [this](VkCommandBuffer commandBuffer) {
+        RecordForwardPass(commandBuffer, occlusionCulling && depthPrepass ? DrawPhase::All : DrawPhase::Early);
+    });
+    VkClearValue clearColor = { {{0.1f, 0.1f, 0.4f, 1.0f}} };
+    frameGraph.Write(forwardPass, backbufferResource, RgUsage::ColorAttachment);
+    frameGraph.Clear(forwardPass, backbufferResource, clearColor);
+    if (depthPrepass) {
+        frameGraph.Read(forwardPass, depthResource, RgUsage::DepthRead);
+    }
+    else {
+        frameGraph.Write(forwardPass, depthResource, RgUsage::DepthAttachment);
+        frameGraph.Clear(forwardPass, depthResource, clearDepth);
+    }
+    if (gpuDrivenCulling) {
+        frameGraph.Read(forwardPass, drawCommandsResource, RgUsage::IndirectRead);
+        frameGraph.Read(forwardPass, drawCountResource, RgUsage::IndirectRead);
+    }
+    if (occlusionCulling && !depthPrepass) {
+        addLatePasses();
+    }
+
+    // Runs every frame for a fixed set of barriers; the copy itself is only
+    // recorded for captured frames.
+    if (frameCapture.Active()) {
+        captureResource = frameGraph.ImportBuffer("capture-readback", static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4, RgUsage::HostRead);
+        uint32_t capturePass = frameGraph.AddPass("capture", RgPassType::Transfer, [this](VkCommandBuffer commandBuffer) {
+            RecordCapture(commandBuffer);
+        });
+        frameGraph.Read(capturePass, backbufferResource, RgUsage::TransferSrc);
+        frameGraph.Write(capturePass, captureResource, RgUsage::TransferDst);
+    }
+
+    // Pipelines are built against the compiled passes.
+    frameGraph.Compile();
+
+    if (VkUtils::GetEnvFlag("VK3D_DUMP_GRAPH")) {
+        std::cout << frameGraph.Dump();
+    }
+}
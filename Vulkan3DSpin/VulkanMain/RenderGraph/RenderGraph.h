@@ -0,0 +1,240 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Index of a resource declared on a RenderGraph.
+using RgHandle = uint32_t;
+constexpr RgHandle RG_INVALID = UINT32_MAX;
+
+// How a pass touches a resource. Each usage maps to the pipeline stage,
+// access mask and image layout the graph synchronizes on.
+enum class RgUsage : uint32_t {
+    None,
+    ColorAttachment,
+    DepthAttachment,
+    DepthRead,
+    SampledFragment,
+    SampledCompute,
+    StorageRead,
+    StorageWrite,
+    IndirectRead,
+    TransferSrc,
+    TransferDst,
+    Present,
+    HostRead,
+};
+
+enum class RgPassType : uint32_t {
+    Graphics,
+    Compute,
+    Transfer,
+};
+
+struct RgStats {
+    uint32_t passes = 0;
+    uint32_t culledPasses = 0;
+    uint32_t barrierBatches = 0;
+    uint32_t imageBarriers = 0;
+    uint32_t memoryBarriers = 0;
+    // Transient memory if every resource had its own allocation, and what
+    // the aliased heaps actually take.
+    VkDeviceSize transientBytes = 0;
+    VkDeviceSize allocatedBytes = 0;
+};
+
+// A frame described as passes that declare what they read and write.
+// Compile() drops passes whose results nobody consumes, works out the
+// barriers between the rest (one vkCmdPipelineBarrier per pass at most),
+// creates a VkRenderPass for each graphics pass, and places transient
+// resources whose lifetimes do not overlap in the same memory. Execute()
+// then replays the compiled frame; only imported handles change per frame.
+//
+// Passes run in declaration order, so a pass may only read what an earlier
+// pass wrote. Imported resources start each frame with undefined contents
+// and are moved to their final usage after the last pass.
+//
+// With UseDynamicRendering() graphics passes are recorded with
+// vkCmdBeginRenderingKHR from the attachments' views at record time, and no
+// render pass or framebuffer objects exist at all.
+class RenderGraph {
+public:
+    using ExecuteFn = std::function<void(VkCommandBuffer)>;
+
+    void Init(VkDevice device, VkPhysicalDevice physicalDevice);
+    // Call before Compile(); both entry points come from VK_KHR_dynamic_rendering.
+    void UseDynamicRendering(PFN_vkCmdBeginRenderingKHR begin, PFN_vkCmdEndRenderingKHR end);
+    // Releases compiled objects and forgets every pass and resource.
+    void Destroy();
+
+    RgHandle CreateImage(const std::string& name, VkFormat format, VkExtent2D extent);
+    RgHandle CreateBuffer(const std::string& name, VkDeviceSize size);
+    // waitStage is the stage a submit waits on the image's semaphore at
+    // (swapchain acquire); the first use of the image is ordered after it.
+    RgHandle ImportImage(const std::string& name, VkFormat format, VkExtent2D extent, RgUsage finalUsage, VkPipelineStageFlags waitStage = 0);
+    RgHandle ImportBuffer(const std::string& name, VkDeviceSize size, RgUsage finalUsage = RgUsage::None);
+
+    uint32_t AddPass(const std::string& name, RgPassType type, ExecuteFn execute);
+    void Read(uint32_t pass, RgHandle resource, RgUsage usage);
+    void Write(uint32_t pass, RgHandle resource, RgUsage usage);
+    // Clears an attachment written by pass when its render pass begins.
+    void Clear(uint32_t pass, RgHandle attachment, VkClearValue value);
+    // Keeps pass even if nothing reads what it writes.
+    void KeepAlive(uint32_t pass);
+
+    void Compile();
+
+    // Per frame, before Execute().
+    void SetImage(RgHandle resource, VkImage image, VkImageView view);
+    void SetBuffer(RgHandle resource, VkBuffer buffer);
+    void Execute(VkCommandBuffer commandBuffer);
+
+    bool DynamicRendering() const { return cmdBeginRendering != nullptr; }
+    // VK_NULL_HANDLE with dynamic rendering.
+    VkRenderPass RenderPass(uint32_t pass) const { return passes[pass].renderPass; }
+    // Attachment formats of a compiled graphics pass, as pipelines built for
+    // dynamic rendering name them.
+    const std::vector<VkFormat>& ColorFormats(uint32_t pass) const { return passes[pass].colorFormats; }
+    VkFormat DepthFormat(uint32_t pass) const { return passes[pass].depthFormat; }
+    VkImage Image(RgHandle resource) const { return resources[resource].image; }
+    VkImageView ImageView(RgHandle resource) const { return resources[resource].view; }
+    VkBuffer Buffer(RgHandle resource) const { return resources[resource].buffer; }
+
+    const RgStats& Stats() const { return stats; }
+    // Passes in execution order with their barriers, then resource
+    // lifetimes and memory placement.
+    std::string Dump() const;
+
+private:
+    struct Resource {
+        std::string name;
+        bool isImage = false;
+        bool imported = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        VkDeviceSize size = 0;
+        RgUsage finalUsage = RgUsage::None;
+        VkPipelineStageFlags waitStage = 0;
+
+        // Filled by Compile(); lifetime is in execution order positions.
+        VkImageUsageFlags imageUsage = 0;
+        VkBufferUsageFlags bufferUsage = 0;
+        uint32_t firstUse = UINT32_MAX;
+        uint32_t lastUse = 0;
+        uint32_t heap = UINT32_MAX;
+        VkDeviceSize offset = 0;
+        VkDeviceSize memorySize = 0;
+        VkDeviceSize alignment = 1;
+        uint32_t memoryTypeBits = 0;
+
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+    };
+
+    // Every use of one resource by one pass, merged.
+    struct Access {
+        RgHandle resource;
+        RgUsage usage;
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+        bool write;
+        bool clear;
+        VkClearValue clearValue;
+    };
+
+    struct ImageBarrier {
+        RgHandle resource;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+    };
+
+    // Everything one vkCmdPipelineBarrier records. Buffers share the single
+    // global memory barrier; images get their own for the layout change.
+    struct BarrierBatch {
+        VkPipelineStageFlags srcStage = 0;
+        VkPipelineStageFlags dstStage = 0;
+        VkAccessFlags srcAccess = 0;
+        VkAccessFlags dstAccess = 0;
+        std::vector<ImageBarrier> images;
+
+        bool Empty() const { return dstStage == 0; }
+    };
+
+    struct Pass {
+        std::string name;
+        RgPassType type;
+        ExecuteFn execute;
+        std::vector<Access> accesses;
+        bool keepAlive = false;
+        bool live = false;
+
+        BarrierBatch barriers;
+        // Color attachments first, then the depth attachment if any.
+        std::vector<RgHandle> attachments;
+        std::vector<VkImageLayout> layouts;
+        std::vector<VkClearValue> clearValues;
+        std::vector<VkAttachmentLoadOp> loadOps;
+        std::vector<VkAttachmentStoreOp> storeOps;
+        std::vector<VkFormat> colorFormats;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+        // Render pass path only.
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        std::map<std::vector<VkImageView>, VkFramebuffer> framebuffers;
+    };
+
+    // Stage and access state of one resource while barriers are planned.
+    struct SyncState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStage = 0;
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags visibleStages = 0;
+        VkAccessFlags visibleAccess = 0;
+        VkPipelineStageFlags readStages = 0;
+    };
+
+    struct Heap {
+        uint32_t memoryType;
+        bool images;
+        VkDeviceSize size = 0;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+    };
+
+    RgHandle AddResource(Resource resource);
+    void AddAccess(uint32_t pass, RgHandle resource, RgUsage usage, bool write);
+    void ReleaseCompiled();
+    void CullPasses();
+    void ComputeLifetimes();
+    void CreateTransients();
+    void PlaceTransients();
+    void PlanBarriers();
+    void CreateAttachments();
+    void Transition(SyncState& state, RgHandle resource, VkPipelineStageFlags stage, VkAccessFlags access, VkImageLayout layout, bool write, BarrierBatch& batch) const;
+    void RecordBarriers(VkCommandBuffer commandBuffer, const BarrierBatch& batch);
+    VkFramebuffer GetFramebuffer(Pass& pass);
+    void BeginRenderPass(VkCommandBuffer commandBuffer, Pass& pass);
+    void BeginRendering(VkCommandBuffer commandBuffer, const Pass& pass);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+
+    std::vector<uint32_t> order;
+    BarrierBatch finalBarriers;
+    std::vector<Heap> heaps;
+    std::vector<VkImageMemoryBarrier> imageBarrierScratch;
+    std::vector<VkRenderingAttachmentInfoKHR> renderingAttachmentScratch;
+    RgStats stats;
+};
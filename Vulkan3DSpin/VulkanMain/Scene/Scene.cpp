@@ -0,0 +1,140 @@
+#include "VulkanMain/Scene/Scene.h"
+
+#include <algorithm>
+#include <cassert>
+
+uint32_t SceneGraph::AddNode(uint32_t parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    uint32_t index = static_cast<uint32_t>(Size());
+    assert(parent == NO_PARENT || parent < index);
+
+    parents.push_back(parent);
+    subtreeEnd.push_back(index);
+    locals.Add(position, rotation, scale);
+    world.push_back(glm::mat4(1.0f));
+    dirty.push_back(0);
+    changedStamp.push_back(0);
+
+    for (uint32_t p = parent; p != NO_PARENT; p = parents[p]) {
+        subtreeEnd[p] = index;
+    }
+
+    MarkDirty(index);
+    return index;
+}
+
+void SceneGraph::Clear() {
+    parents.clear();
+    subtreeEnd.clear();
+    locals.Clear();
+    world.clear();
+    dirty.clear();
+    dirtyNodes.clear();
+    changedStamp.clear();
+    changed.clear();
+}
+
+void SceneGraph::SetPosition(uint32_t index, const glm::vec3& position) {
+    locals.SetPosition(index, position);
+    MarkDirty(index);
+}
+
+void SceneGraph::SetRotation(uint32_t index, const glm::quat& rotation) {
+    locals.SetRotation(index, rotation);
+    MarkDirty(index);
+}
+
+void SceneGraph::SetScale(uint32_t index, const glm::vec3& scale) {
+    locals.SetScale(index, scale);
+    MarkDirty(index);
+}
+
+void SceneGraph::MarkDirty(uint32_t index) {
+    if (!dirty[index]) {
+        dirty[index] = 1;
+        dirtyNodes.push_back(index);
+    }
+}
+
+size_t SceneGraph::Update() {
+    changed.clear();
+    if (dirtyNodes.empty()) {
+        return 0;
+    }
+
+    updateStamp++;
+    std::sort(dirtyNodes.begin(), dirtyNodes.end());
+
+    // Walk the subtree range of every dirty node once. A node is rebuilt if
+    // it was touched itself or its parent changed earlier in this pass; the
+    // range can also hold unrelated nodes, which are skipped.
+    size_t next = 0;
+    for (uint32_t root : dirtyNodes) {
+        size_t begin = std::max<size_t>(root, next);
+        size_t end = static_cast<size_t>(subtreeEnd[root]) + 1;
+
+        for (size_t i = begin; i < end; i++) {
+            uint32_t parent = parents[i];
+            bool parentChanged = parent != NO_PARENT && changedStamp[parent] == updateStamp;
+            if (!dirty[i] && !parentChanged) {
+                continue;
+            }
+
+            dirty[i] = 0;
+            changedStamp[i] = updateStamp;
+            changed.push_back(static_cast<uint32_t>(i));
+        }
+
+        next = std::max(next, end);
+    }
+
+    // changed is ascending, so each run of consecutive nodes goes through
+    // the SIMD kernel in one call, written straight into world. Parents come
+    // first, so applying them front to back sees every parent final.
+    for (size_t k = 0; k < changed.size();) {
+        size_t run = k + 1;
+        while (run < changed.size() && changed[run] == changed[run - 1] + 1) {
+            run++;
+        }
+        locals.ComputeLocalRange(changed[k], static_cast<size_t>(changed[run - 1]) + 1, world.data());
+        k = run;
+    }
+
+    for (uint32_t i : changed) {
+        uint32_t parent = parents[i];
+        if (parent != NO_PARENT) {
+            world[i] = world[parent] * world[i];
+        }
+    }
+
+    dirtyNodes.clear();
+    return changed.size();
+}
+
+void ChangeList::Resize(size_t count) {
+    queued.assign(count, 0);
+    indices.clear();
+}
+
+void ChangeList::Add(const std::vector<uint32_t>& nodes) {
+    for (uint32_t node : nodes) {
+        if (!queued[node]) {
+            queued[node] = 1;
+            indices.push_back(node);
+        }
+    }
+}
+
+void ChangeList::AddAll() {
+    indices.clear();
+    for (size_t i = 0; i < queued.size(); i++) {
+        queued[i] = 1;
+        indices.push_back(static_cast<uint32_t>(i));
+    }
+}
+
+void ChangeList::Clear() {
+    for (uint32_t node : indices) {
+        queued[node] = 0;
+    }
+    indices.clear();
+}
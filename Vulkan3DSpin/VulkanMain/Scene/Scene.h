@@ -0,0 +1,84 @@
+#pragma once
+#include "VulkanMain/Transform/Transform.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Transform hierarchy stored as flat arrays. A node is always added after
+// its parent, so one forward pass sees every parent before its children.
+// Setters only mark the node dirty; Update() rebuilds the world matrices of
+// dirty nodes and their descendants and lists them in Changed(). Local
+// transforms live in a TransformSystem, so each rebuilt range goes through
+// its SIMD kernel before the parent matrices are applied.
+class SceneGraph {
+public:
+    static constexpr uint32_t NO_PARENT = 0xFFFFFFFFu;
+
+    uint32_t AddNode(uint32_t parent, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void Clear();
+    size_t Size() const { return parents.size(); }
+
+    uint32_t Parent(uint32_t index) const { return parents[index]; }
+
+    void SetPosition(uint32_t index, const glm::vec3& position);
+    void SetRotation(uint32_t index, const glm::quat& rotation);
+    void SetScale(uint32_t index, const glm::vec3& scale);
+
+    glm::vec3 GetPosition(uint32_t index) const { return locals.GetPosition(index); }
+    glm::quat GetRotation(uint32_t index) const { return locals.GetRotation(index); }
+    glm::vec3 GetScale(uint32_t index) const { return locals.GetScale(index); }
+
+    // Returns the number of world matrices rebuilt. Costs nothing when no
+    // node was touched since the last call.
+    size_t Update();
+
+    const std::vector<glm::mat4>& World() const { return world; }
+
+    // Nodes whose world matrix changed in the last Update(), ascending.
+    const std::vector<uint32_t>& Changed() const { return changed; }
+
+private:
+    void MarkDirty(uint32_t index);
+
+    std::vector<uint32_t> parents;
+    // Highest index among the node and its descendants; with parents first,
+    // every descendant of i lies in (i, subtreeEnd[i]].
+    std::vector<uint32_t> subtreeEnd;
+
+    TransformSystem locals;
+    std::vector<glm::mat4> world;
+
+    std::vector<uint8_t> dirty;
+    std::vector<uint32_t> dirtyNodes;
+    // Update() stamp of the last time each world matrix changed.
+    std::vector<uint32_t> changedStamp;
+    uint32_t updateStamp = 0;
+    std::vector<uint32_t> changed;
+};
+
+// Node indices collected for one consumer, e.g. one frame in flight's copy
+// of a GPU buffer, until it has caught up. Each index is queued once.
+class ChangeList {
+public:
+    void Resize(size_t count);
+    void Add(const std::vector<uint32_t>& nodes);
+    void AddAll();
+    void Clear();
+
+    const std::vector<uint32_t>& Indices() const { return indices; }
+
+private:
+    std::vector<uint32_t> indices;
+    std::vector<uint8_t> queued;
+};
+
+struct SceneStats {
+    uint32_t nodes = 0;
+    uint32_t updated = 0;
+    uint32_t uploaded = 0;
+    double cpuMs = 0.0;
+};
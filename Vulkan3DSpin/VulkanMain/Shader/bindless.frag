@@ -0,0 +1,21 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Input from Vertex Shader
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTexture;
+
+// Final Color Output
+layout(location = 0) out vec4 outColor;
+
+// Every sampled image of the renderer, indexed by bindless slot
+layout(set = 0, binding = 1) uniform sampler2D textures[];
+
+void main() {
+    vec3 color = fragColor;
+    if (fragTexture != 0xFFFFFFFFu) {
+        color *= texture(textures[nonuniformEXT(fragTexture)], fragTexCoord).rgb;
+    }
+    outColor = vec4(color, 1.0);
+}
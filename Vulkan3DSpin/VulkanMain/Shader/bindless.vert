@@ -0,0 +1,43 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Vertex Attributes
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Output to Fragment Shader
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTexture;
+
+// Shared with the depth pre-pass, whose depth the color pass tests EQUAL.
+invariant gl_Position;
+
+struct ObjectData {
+    mat4 model;
+    vec4 boundsCenterRadius;
+    vec3 boundsExtents;
+    uint textureIndex;
+};
+
+// Every storage buffer of the renderer, indexed by bindless slot
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+} buffers[];
+
+layout(push_constant) uniform DrawConstants {
+    mat4 viewProj;
+    uint objectBuffer;
+} pc;
+
+void main() {
+    // firstInstance is the object index, both for direct draws and for the
+    // commands written by cull.comp.
+    ObjectData object = buffers[pc.objectBuffer].objects[gl_InstanceIndex];
+
+    gl_Position = pc.viewProj * object.model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+    // The mesh has no UVs yet; project the texture along z.
+    fragTexCoord = inPosition.xy + 0.5;
+    fragTexture = object.textureIndex;
+}
@@ -0,0 +1,20 @@
+@echo off
+rem Builds every .spv the renderer loads from the GLSL source next to it and
+rem validates the result. Needs glslc and spirv-val from the Vulkan SDK.
+setlocal
+cd /d "%~dp0"
+
+call :compile shader.vert vert.spv || exit /b 1
+call :compile shader.frag frag.spv || exit /b 1
+call :compile cull.comp cull.spv || exit /b 1
+call :compile indirect.vert indirect.spv || exit /b 1
+call :compile bindless.vert bindless_vert.spv || exit /b 1
+call :compile bindless.frag bindless_frag.spv || exit /b 1
+call :compile hiz.comp hiz.spv || exit /b 1
+call :compile occlusion.comp occlusion.spv || exit /b 1
+exit /b 0
+
+:compile
+glslc --target-env=vulkan1.2 -O %1 -o %2 || exit /b 1
+spirv-val --target-env vulkan1.2 %2 || exit /b 1
+exit /b 0
@@ -0,0 +1,19 @@
+#!/bin/sh
+# Builds every .spv the renderer loads from the GLSL source next to it and
+# validates the result. Needs glslc and spirv-val from the Vulkan SDK.
+set -e
+cd "$(dirname "$0")"
+
+compile() {
+    glslc --target-env=vulkan1.2 -O "$1" -o "$2"
+    spirv-val --target-env vulkan1.2 "$2"
+}
+
+compile shader.vert vert.spv
+compile shader.frag frag.spv
+compile cull.comp cull.spv
+compile indirect.vert indirect.spv
+compile bindless.vert bindless_vert.spv
+compile bindless.frag bindless_frag.spv
+compile hiz.comp hiz.spv
+compile occlusion.comp occlusion.spv
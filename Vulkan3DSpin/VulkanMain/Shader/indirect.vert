@@ -0,0 +1,32 @@
+#version 450
+
+// Vertex Attributes
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+
+// Output to Fragment Shader
+layout(location = 0) out vec3 fragColor;
+
+// Bit-identical in the depth pre-pass and the EQUAL-tested color pass.
+invariant gl_Position;
+
+struct ObjectData {
+    mat4 model;
+    vec4 boundsCenterRadius;
+    vec3 boundsExtents;
+    uint textureIndex;
+};
+
+// Written by the host, indexed by the draw's firstInstance (see cull.comp)
+layout(std430, set = 0, binding = 0) readonly buffer Objects {
+    ObjectData objects[];
+};
+
+layout(push_constant) uniform DrawConstants {
+    mat4 viewProj;
+} pc;
+
+void main() {
+    gl_Position = pc.viewProj * objects[gl_InstanceIndex].model * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
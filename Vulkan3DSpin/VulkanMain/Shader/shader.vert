@@ -7,6 +7,10 @@ layout(location = 1) in vec3 inColor;
 // Output to Fragment Shader
 layout(location = 0) out vec3 fragColor;
 
+// The depth pre-pass draws with this shader too; the color pass tests
+// EQUAL against its depth, so both pipelines must compute the same value.
+invariant gl_Position;
+
 // Dynamic UBO (Binding 0)
 // API VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC 
 layout(set = 0, binding = 0) uniform UniformBufferObject {
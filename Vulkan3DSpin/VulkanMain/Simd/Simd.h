@@ -0,0 +1,125 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VK3D_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define VK3D_SIMD_SSE
+#endif
+
+#if defined(VK3D_SIMD_AVX2) || defined(VK3D_SIMD_SSE)
+#define VK3D_SIMD
+#endif
+
+// Thin wrapper over the widest float vector the build targets, so batch
+// kernels are written once for AVX2 (8 lanes) and SSE2 (4 lanes).
+namespace VkSimd {
+#if defined(VK3D_SIMD_AVX2)
+    struct Lanes {
+        static constexpr size_t WIDTH = 8;
+        using Reg = __m256;
+
+        static Reg Load(const float* p) { return _mm256_loadu_ps(p); }
+        static void Store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+        static Reg Set(float v) { return _mm256_set1_ps(v); }
+        static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+        static Reg Sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+        static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+        static Reg Min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+        static Reg Max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+        static Reg Abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+        static Reg Sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+        static Reg And(Reg a, Reg b) { return _mm256_and_ps(a, b); }
+        static Reg Or(Reg a, Reg b) { return _mm256_or_ps(a, b); }
+        static Reg GreaterEqual(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static Reg Less(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static Reg AllTrue() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+        static uint32_t Mask(Reg a) { return static_cast<uint32_t>(_mm256_movemask_ps(a)); }
+
+        // r0..r3 hold rows 0..3 of one matrix column for 8 objects; transposes
+        // them into that column of out[0..7].
+        static void StoreColumn(glm::mat4* out, int column, Reg r0, Reg r1, Reg r2, Reg r3) {
+            __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+            __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+            __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+            __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+
+            __m256 c0 = _mm256_shuffle_ps(t0, t2, 0x44); // objects 0 and 4
+            __m256 c1 = _mm256_shuffle_ps(t0, t2, 0xEE); // objects 1 and 5
+            __m256 c2 = _mm256_shuffle_ps(t1, t3, 0x44); // objects 2 and 6
+            __m256 c3 = _mm256_shuffle_ps(t1, t3, 0xEE); // objects 3 and 7
+
+            _mm_storeu_ps(&out[0][column][0], _mm256_castps256_ps128(c0));
+            _mm_storeu_ps(&out[1][column][0], _mm256_castps256_ps128(c1));
+            _mm_storeu_ps(&out[2][column][0], _mm256_castps256_ps128(c2));
+            _mm_storeu_ps(&out[3][column][0], _mm256_castps256_ps128(c3));
+            _mm_storeu_ps(&out[4][column][0], _mm256_extractf128_ps(c0, 1));
+            _mm_storeu_ps(&out[5][column][0], _mm256_extractf128_ps(c1, 1));
+            _mm_storeu_ps(&out[6][column][0], _mm256_extractf128_ps(c2, 1));
+            _mm_storeu_ps(&out[7][column][0], _mm256_extractf128_ps(c3, 1));
+        }
+
+        // Inverse of StoreColumn for in[indices[0..7]]: r0..r3 receive rows
+        // 0..3 of that column, one object per lane.
+        static void LoadColumn(const glm::mat4* in, const uint32_t* indices, int column, Reg& r0, Reg& r1, Reg& r2, Reg& r3) {
+            __m256 c0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[indices[0]][column][0])), _mm_loadu_ps(&in[indices[4]][column][0]), 1);
+            __m256 c1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[indices[1]][column][0])), _mm_loadu_ps(&in[indices[5]][column][0]), 1);
+            __m256 c2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[indices[2]][column][0])), _mm_loadu_ps(&in[indices[6]][column][0]), 1);
+            __m256 c3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&in[indices[3]][column][0])), _mm_loadu_ps(&in[indices[7]][column][0]), 1);
+
+            __m256 t0 = _mm256_unpacklo_ps(c0, c1);
+            __m256 t1 = _mm256_unpackhi_ps(c0, c1);
+            __m256 t2 = _mm256_unpacklo_ps(c2, c3);
+            __m256 t3 = _mm256_unpackhi_ps(c2, c3);
+
+            r0 = _mm256_shuffle_ps(t0, t2, 0x44);
+            r1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+            r2 = _mm256_shuffle_ps(t1, t3, 0x44);
+            r3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+        }
+    };
+#elif defined(VK3D_SIMD_SSE)
+    struct Lanes {
+        static constexpr size_t WIDTH = 4;
+        using Reg = __m128;
+
+        static Reg Load(const float* p) { return _mm_loadu_ps(p); }
+        static void Store(float* p, Reg v) { _mm_storeu_ps(p, v); }
+        static Reg Set(float v) { return _mm_set1_ps(v); }
+        static Reg Add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+        static Reg Sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+        static Reg Mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+        static Reg Min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+        static Reg Max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+        static Reg Abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+        static Reg Sqrt(Reg a) { return _mm_sqrt_ps(a); }
+        static Reg And(Reg a, Reg b) { return _mm_and_ps(a, b); }
+        static Reg Or(Reg a, Reg b) { return _mm_or_ps(a, b); }
+        static Reg GreaterEqual(Reg a, Reg b) { return _mm_cmpge_ps(a, b); }
+        static Reg Less(Reg a, Reg b) { return _mm_cmplt_ps(a, b); }
+        static Reg AllTrue() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+        static uint32_t Mask(Reg a) { return static_cast<uint32_t>(_mm_movemask_ps(a)); }
+
+        static void StoreColumn(glm::mat4* out, int column, Reg r0, Reg r1, Reg r2, Reg r3) {
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&out[0][column][0], r0);
+            _mm_storeu_ps(&out[1][column][0], r1);
+            _mm_storeu_ps(&out[2][column][0], r2);
+            _mm_storeu_ps(&out[3][column][0], r3);
+        }
+
+        static void LoadColumn(const glm::mat4* in, const uint32_t* indices, int column, Reg& r0, Reg& r1, Reg& r2, Reg& r3) {
+            r0 = _mm_loadu_ps(&in[indices[0]][column][0]);
+            r1 = _mm_loadu_ps(&in[indices[1]][column][0]);
+            r2 = _mm_loadu_ps(&in[indices[2]][column][0]);
+            r3 = _mm_loadu_ps(&in[indices[3]][column][0]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        }
+    };
+#endif
+}
@@ -0,0 +1,179 @@
+#include "VulkanMain/Startup/Startup.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+    std::mutex shaderMutex;
+    std::unordered_map<std::string, std::vector<char>> shaders;
+
+    double Milliseconds(std::chrono::steady_clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+}
+
+StartupGraph::Step StartupGraph::Add(const std::string& name, std::vector<Step> after, std::function<void()> run, bool worker) {
+    for (Step step : after) {
+        if (step >= nodes.size()) {
+            throw std::runtime_error("startup step " + name + " depends on a later step!");
+        }
+    }
+    nodes.push_back({ name, std::move(after), std::move(run), worker });
+    return nodes.size() - 1;
+}
+
+StartupGraph::Step StartupGraph::Main(const std::string& name, std::vector<Step> after, std::function<void()> run) {
+    return Add(name, std::move(after), std::move(run), false);
+}
+
+StartupGraph::Step StartupGraph::Worker(const std::string& name, std::vector<Step> after, std::function<void()> run) {
+    return Add(name, std::move(after), std::move(run), true);
+}
+
+void StartupGraph::Run(bool parallel, std::chrono::steady_clock::time_point origin, std::vector<StartupPhase>& phases) {
+    std::mutex phaseMutex;
+    auto runStep = [&](Step step, uint32_t thread) {
+        auto start = std::chrono::steady_clock::now();
+        nodes[step].run();
+        auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(phaseMutex);
+        phases.push_back({ nodes[step].name, thread, Milliseconds(start - origin), Milliseconds(end - start) });
+    };
+    auto sortPhases = [&]() {
+        std::sort(phases.begin(), phases.end(), [](const StartupPhase& a, const StartupPhase& b) { return a.startMs < b.startMs; });
+    };
+
+    if (!parallel) {
+        for (Step step = 0; step < nodes.size(); step++) {
+            runStep(step, 0);
+        }
+        sortPhases();
+        return;
+    }
+
+    std::vector<std::promise<void>> done(nodes.size());
+    std::vector<std::shared_future<void>> finished;
+    finished.reserve(nodes.size());
+    for (auto& promise : done) {
+        finished.push_back(promise.get_future().share());
+    }
+    // Rethrows when a step it depends on failed.
+    auto waitFor = [&](Step step) {
+        for (Step dependency : nodes[step].after) {
+            finished[dependency].get();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (Step step = 0; step < nodes.size(); step++) {
+        if (!nodes[step].worker) {
+            continue;
+        }
+        uint32_t thread = static_cast<uint32_t>(workers.size()) + 1;
+        workers.emplace_back([&, step, thread]() {
+            try {
+                waitFor(step);
+                runStep(step, thread);
+                done[step].set_value();
+            }
+            catch (...) {
+                done[step].set_exception(std::current_exception());
+            }
+        });
+    }
+
+    std::exception_ptr failure;
+    for (Step step = 0; step < nodes.size(); step++) {
+        if (nodes[step].worker) {
+            continue;
+        }
+        // Once a main step fails the rest are skipped, and workers waiting
+        // on them give up.
+        if (failure) {
+            done[step].set_exception(failure);
+            continue;
+        }
+        try {
+            waitFor(step);
+            runStep(step, 0);
+            done[step].set_value();
+        }
+        catch (...) {
+            failure = std::current_exception();
+            done[step].set_exception(failure);
+        }
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (Step step = 0; step < nodes.size() && !failure; step++) {
+        try {
+            finished[step].get();
+        }
+        catch (...) {
+            failure = std::current_exception();
+        }
+    }
+
+    sortPhases();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void VkStartup::PrefetchShaders(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) {
+        std::vector<char> code;
+        try {
+            code = VkUtils::ReadFile(path);
+        }
+        catch (const std::exception&) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(shaderMutex);
+        shaders[path] = std::move(code);
+    }
+}
+
+std::vector<char> VkStartup::ReadShader(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(shaderMutex);
+        auto it = shaders.find(path);
+        if (it != shaders.end()) {
+            return it->second;
+        }
+    }
+    return VkUtils::ReadFile(path);
+}
+
+void VkStartup::ClearShaders() {
+    std::lock_guard<std::mutex> lock(shaderMutex);
+    shaders.clear();
+}
+
+std::string VkStartup::Format(const StartupStats& stats, bool phases) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1)
+        << "startup: first frame after " << stats.firstFrameMs << " ms"
+        << " (init " << stats.initMs << " ms, " << (stats.parallel ? "parallel" : "serial") << ")";
+    if (phases) {
+        for (const auto& phase : stats.phases) {
+            out << "\n  " << std::left << std::setw(28) << phase.name
+                << std::right << " thread " << phase.thread
+                << " at " << std::setw(8) << phase.startMs << " ms"
+                << std::setw(9) << phase.ms << " ms";
+        }
+    }
+    return out.str();
+}
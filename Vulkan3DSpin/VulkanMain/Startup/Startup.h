@@ -0,0 +1,71 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// One initialization step as it ran, in milliseconds since startup began.
+// thread 0 is the main thread, workers count up from 1.
+struct StartupPhase {
+    std::string name;
+    uint32_t thread = 0;
+    double startMs = 0.0;
+    double ms = 0.0;
+};
+
+struct StartupStats {
+    // Worker steps overlapped the main thread; off with VK3D_SERIAL_INIT.
+    bool parallel = true;
+    // Sorted by start.
+    std::vector<StartupPhase> phases;
+    double initMs = 0.0;
+    // Until the first DrawFrame returned; includes the window with GLFW.
+    double firstFrameMs = 0.0;
+};
+
+// Engine initialization as a dependency graph. Main steps run on the
+// calling thread in the order they were added; worker steps each get a
+// thread and start once everything they name is done. A step can only name
+// steps added before it, so the order added is always a valid serial
+// order, and a worker that names a main step also waits for every main
+// step before that one.
+class StartupGraph {
+public:
+    using Step = size_t;
+
+    Step Main(const std::string& name, std::vector<Step> after, std::function<void()> run);
+    Step Worker(const std::string& name, std::vector<Step> after, std::function<void()> run);
+
+    // Returns once every step has finished, or rethrows the first failure
+    // after the workers that could still run have; steps that depend on a
+    // failed one are skipped. Serially, workers run inline where they
+    // were added.
+    void Run(bool parallel, std::chrono::steady_clock::time_point origin, std::vector<StartupPhase>& phases);
+
+private:
+    struct Node {
+        std::string name;
+        std::vector<Step> after;
+        std::function<void()> run;
+        bool worker = false;
+    };
+
+    Step Add(const std::string& name, std::vector<Step> after, std::function<void()> run, bool worker);
+
+    std::vector<Node> nodes;
+};
+
+namespace VkStartup {
+    // Reads the files into a cache that ReadShader serves from, so a
+    // worker can do the file I/O before the device even exists. Files that
+    // cannot be read are left for ReadShader to report.
+    void PrefetchShaders(const std::vector<std::string>& paths);
+    // From the cache when prefetched, else VkUtils::ReadFile.
+    std::vector<char> ReadShader(const std::string& path);
+    void ClearShaders();
+
+    // One line, or with phases one more per step.
+    std::string Format(const StartupStats& stats, bool phases);
+}
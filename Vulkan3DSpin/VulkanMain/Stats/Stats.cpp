@@ -0,0 +1,92 @@
+#include "VulkanMain/Stats/Stats.h"
+
+#include <iomanip>
+#include <sstream>
+
+std::string VkStats::Format(const FrameStats& stats) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3)
+        << "frame " << stats.frame
+        << " | cpu " << stats.cpuFrameMs << " ms (record " << stats.recordMs << " ms)";
+    if (stats.gpuFrameMs >= 0.0) {
+        out << " | gpu " << stats.gpuFrameMs << " ms";
+    }
+    out
+        << " | scene " << stats.scene.updated << "/" << stats.scene.nodes << " updated, "
+        << stats.scene.uploaded << " uploaded (" << stats.scene.cpuMs << " ms)"
+        << " | cull " << stats.culling.visible << "/" << stats.culling.tested << " visible"
+        << " (" << stats.culling.culled << " culled, " << stats.culling.cpuMs << " ms)";
+    if (stats.culling.occlusion) {
+        out << " | occlusion " << stats.culling.occluded << " hidden (" << stats.culling.occludedTriangles << " tris skipped), "
+            << stats.culling.lateDraws << " late";
+        if (stats.culling.occlusionGpuMs >= 0.0) {
+            out << ", " << stats.culling.occlusionGpuMs << " ms gpu";
+        }
+    }
+
+    if (stats.clusters.tested > 0) {
+        out << " | clusters " << stats.clusters.visible << "/" << stats.clusters.tested
+            << " (" << stats.clusters.backfacing << " backfacing, " << stats.clusters.outside << " outside, "
+            << stats.clusters.triangles << " tris)";
+    }
+
+    out << " | tris " << stats.lods.triangles << " lods";
+    for (uint32_t count : stats.lods.objects) {
+        out << " " << count;
+    }
+
+    // issued/requested per bind kind
+    const StateChangeStats& state = stats.state;
+    out << " | draws " << state.draws
+        << " binds " << state.issued.Total() << "/" << state.requested.Total()
+        << " (pipeline " << state.issued.pipelines << "/" << state.requested.pipelines
+        << ", sets " << state.issued.descriptorSets << "/" << state.requested.descriptorSets
+        << ", vb " << state.issued.vertexBuffers << "/" << state.requested.vertexBuffers
+        << ", ib " << state.issued.indexBuffers << "/" << state.requested.indexBuffers
+        << ") push " << state.pushConstants;
+
+    if (stats.depth.pixels > 0) {
+        out << " | " << (stats.depth.prepass ? "depth prepass" : "depth") << ", fragments " << stats.depth.fragments
+            << " (" << static_cast<double>(stats.depth.fragments) / static_cast<double>(stats.depth.pixels) << " per pixel)";
+    }
+
+    if (stats.textures.textures > 0) {
+        const TextureStats& textures = stats.textures;
+        out << " | textures " << textures.textures << ", "
+            << static_cast<double>(textures.residentBytes) / (1 << 20) << "/"
+            << static_cast<double>(textures.fullBytes) / (1 << 20) << " MiB resident, streamed "
+            << textures.streamedBytes / 1024 << " KiB, load " << textures.loadMs << " ms, "
+            << textures.samplers << " samplers, " << textures.views << " views";
+        if (textures.evictions > 0) {
+            out << ", " << textures.evictions << " evicted";
+        }
+        const MemoryPoolStats& pool = textures.pool;
+        out << ", pool " << pool.blocks << " blocks " << static_cast<double>(pool.usedBytes) / (1 << 20) << "/"
+            << static_cast<double>(pool.blockBytes) / (1 << 20) << " MiB";
+        if (textures.defragMoves > 0) {
+            out << ", defrag " << textures.defragMoves << " moves (" << textures.defragBytes / 1024 << " KiB, "
+                << textures.defragMs << " ms GPU), released " << static_cast<double>(pool.releasedBytes) / (1 << 20) << " MiB";
+        }
+    }
+
+    // usage/budget of the device-local heaps
+    bool firstHeap = true;
+    for (const MemoryHeapStats& heap : stats.memory.heaps) {
+        if (!heap.deviceLocal) {
+            continue;
+        }
+        out << (firstHeap ? " | vram " : ", ")
+            << static_cast<double>(heap.usage) / (1 << 20) << "/" << static_cast<double>(heap.budget) / (1 << 20) << " MiB";
+        firstHeap = false;
+    }
+    if (!firstHeap && !stats.memory.budgetExtension) {
+        out << " (estimated)";
+    }
+
+    if (stats.capture.saved > 0 || stats.capture.dropped > 0) {
+        out << " | capture " << stats.capture.saved << " saved, " << stats.capture.dropped << " dropped, encode "
+            << stats.capture.encodeMs << " ms";
+    }
+
+    return out.str();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "VulkanMain/Culling/Culling.h"
+#include "VulkanMain/Meshlet/Meshlet.h"
+#include "VulkanMain/Lod/Lod.h"
+#include "VulkanMain/Scene/Scene.h"
+#include "VulkanMain/DrawList/DrawList.h"
+#include "VulkanMain/Depth/Depth.h"
+#include "VulkanMain/Texture/Texture.h"
+#include "VulkanMain/Capture/Capture.h"
+#include "VulkanMain/Memory/Memory.h"
+
+#include <cstdint>
+#include <string>
+
+// Numbers gathered while building one frame.
+struct FrameStats {
+    uint64_t frame = 0;
+    double cpuFrameMs = 0.0;
+    // The part of cpuFrameMs spent in RecordCommandBuffer.
+    double recordMs = 0.0;
+    // Negative until a timestamp result is in, or without timestamps.
+    double gpuFrameMs = -1.0;
+    SceneStats scene;
+    CullStats culling;
+    ClusterStats clusters;
+    LodStats lods;
+    StateChangeStats state;
+    DepthStats depth;
+    TextureStats textures;
+    CaptureStats capture;
+    MemoryStats memory;
+};
+
+namespace VkStats {
+    std::string Format(const FrameStats& stats);
+}
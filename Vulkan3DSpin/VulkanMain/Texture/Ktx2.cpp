@@ -0,0 +1,199 @@
+#include "VulkanMain/Texture/Ktx2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+    // Header and index that follow the identifier, as stored (little endian).
+    struct Ktx2Header {
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        // 64-bit fields at offset 52; split so the struct has no padding.
+        uint32_t sgdByteOffset[2];
+        uint32_t sgdByteLength[2];
+    };
+    static_assert(sizeof(Ktx2Header) == 68, "KTX2 header must match the file layout");
+
+    struct Ktx2LevelIndex {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    // Texel block of a format: 1x1 for plain color formats, 4x4 for BCn
+    // and ETC2/EAC, the named footprint for ASTC.
+    struct FormatBlock {
+        uint32_t width;
+        uint32_t height;
+        uint32_t bytes;
+    };
+
+    bool InRange(VkFormat format, VkFormat first, VkFormat last) {
+        return format >= first && format <= last;
+    }
+
+    // False for formats a sampled 2D texture file has no business holding
+    // (depth/stencil, 64-bit channels, multi-planar).
+    bool GetFormatBlock(VkFormat format, FormatBlock& block) {
+        static const FormatBlock ASTC_BLOCKS[14] = {
+            { 4, 4, 16 }, { 5, 4, 16 }, { 5, 5, 16 }, { 6, 5, 16 }, { 6, 6, 16 }, { 8, 5, 16 }, { 8, 6, 16 },
+            { 8, 8, 16 }, { 10, 5, 16 }, { 10, 6, 16 }, { 10, 8, 16 }, { 10, 10, 16 }, { 12, 10, 16 }, { 12, 12, 16 }
+        };
+
+        if (format == VK_FORMAT_R4G4_UNORM_PACK8 || InRange(format, VK_FORMAT_R8_UNORM, VK_FORMAT_R8_SRGB)) {
+            block = { 1, 1, 1 };
+        }
+        else if (InRange(format, VK_FORMAT_R4G4B4A4_UNORM_PACK16, VK_FORMAT_A1R5G5B5_UNORM_PACK16) ||
+                 InRange(format, VK_FORMAT_R8G8_UNORM, VK_FORMAT_R8G8_SRGB) ||
+                 InRange(format, VK_FORMAT_R16_UNORM, VK_FORMAT_R16_SFLOAT)) {
+            block = { 1, 1, 2 };
+        }
+        else if (InRange(format, VK_FORMAT_R8G8B8_UNORM, VK_FORMAT_B8G8R8_SRGB)) {
+            block = { 1, 1, 3 };
+        }
+        else if (InRange(format, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_A2B10G10R10_SINT_PACK32) ||
+                 InRange(format, VK_FORMAT_R16G16_UNORM, VK_FORMAT_R16G16_SFLOAT) ||
+                 InRange(format, VK_FORMAT_R32_UINT, VK_FORMAT_R32_SFLOAT) ||
+                 InRange(format, VK_FORMAT_B10G11R11_UFLOAT_PACK32, VK_FORMAT_E5B9G9R9_UFLOAT_PACK32)) {
+            block = { 1, 1, 4 };
+        }
+        else if (InRange(format, VK_FORMAT_R16G16B16_UNORM, VK_FORMAT_R16G16B16_SFLOAT)) {
+            block = { 1, 1, 6 };
+        }
+        else if (InRange(format, VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT) ||
+                 InRange(format, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32_SFLOAT)) {
+            block = { 1, 1, 8 };
+        }
+        else if (InRange(format, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32_SFLOAT)) {
+            block = { 1, 1, 12 };
+        }
+        else if (InRange(format, VK_FORMAT_R32G32B32A32_UINT, VK_FORMAT_R32G32B32A32_SFLOAT)) {
+            block = { 1, 1, 16 };
+        }
+        else if (InRange(format, VK_FORMAT_BC1_RGB_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_SRGB_BLOCK) ||
+                 InRange(format, VK_FORMAT_BC4_UNORM_BLOCK, VK_FORMAT_BC4_SNORM_BLOCK) ||
+                 InRange(format, VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK) ||
+                 InRange(format, VK_FORMAT_EAC_R11_UNORM_BLOCK, VK_FORMAT_EAC_R11_SNORM_BLOCK)) {
+            block = { 4, 4, 8 };
+        }
+        else if (InRange(format, VK_FORMAT_BC2_UNORM_BLOCK, VK_FORMAT_BC3_SRGB_BLOCK) ||
+                 InRange(format, VK_FORMAT_BC5_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK) ||
+                 InRange(format, VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK) ||
+                 InRange(format, VK_FORMAT_EAC_R11G11_UNORM_BLOCK, VK_FORMAT_EAC_R11G11_SNORM_BLOCK)) {
+            block = { 4, 4, 16 };
+        }
+        else if (InRange(format, VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_12x12_SRGB_BLOCK)) {
+            // UNORM and SRGB alternate for each footprint.
+            block = ASTC_BLOCKS[(format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2];
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+}
+
+void Ktx2File::Open(const std::string& filePath) {
+    path = filePath;
+    file.open(path, std::ios::binary | std::ios::ate);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open ktx2 file!");
+    }
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+
+    uint8_t identifier[sizeof(KTX2_IDENTIFIER)];
+    Ktx2Header header{};
+    file.read(reinterpret_cast<char*>(identifier), sizeof(identifier));
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || memcmp(identifier, KTX2_IDENTIFIER, sizeof(identifier)) != 0) {
+        throw std::runtime_error("not a ktx2 file!");
+    }
+
+    // Basis Universal (vkFormat 0) and supercompressed files need a
+    // transcoder; cube maps, arrays and 3D textures have no user here yet.
+    if (header.vkFormat == VK_FORMAT_UNDEFINED || header.supercompressionScheme != 0) {
+        throw std::runtime_error("ktx2 file needs transcoding or decompression!");
+    }
+    if (header.pixelWidth == 0 || header.pixelHeight == 0 || header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1) {
+        throw std::runtime_error("ktx2 file is not a 2D texture!");
+    }
+
+    format = static_cast<VkFormat>(header.vkFormat);
+    FormatBlock block{};
+    if (!GetFormatBlock(format, block)) {
+        throw std::runtime_error("ktx2 file has an unsupported format!");
+    }
+
+    // levelCount 0 asks the loader to generate mips; we only take what is
+    // in the file. A chain ends at 1x1, floor(log2(max(w, h))) + 1 levels.
+    uint32_t levelCount = std::max(header.levelCount, 1u);
+    uint32_t maxLevelCount = 1;
+    for (uint32_t size = std::max(header.pixelWidth, header.pixelHeight); size > 1; size >>= 1) {
+        maxLevelCount++;
+    }
+    if (levelCount > maxLevelCount) {
+        throw std::runtime_error("ktx2 file has more levels than its size allows!");
+    }
+
+    std::vector<Ktx2LevelIndex> index(levelCount);
+    file.read(reinterpret_cast<char*>(index.data()), sizeof(Ktx2LevelIndex) * levelCount);
+    if (!file) {
+        throw std::runtime_error("failed to read ktx2 level index!");
+    }
+
+    levels.resize(levelCount);
+    for (uint32_t i = 0; i < levelCount; i++) {
+        levels[i].width = std::max(header.pixelWidth >> i, 1u);
+        levels[i].height = std::max(header.pixelHeight >> i, 1u);
+
+        // Written the other way round, offset + length could wrap.
+        if (index[i].byteOffset > fileSize || index[i].byteLength > fileSize - index[i].byteOffset) {
+            throw std::runtime_error("ktx2 level lies outside the file!");
+        }
+        // Without supercompression a level is exactly its blocks; the
+        // upload copies that many bytes.
+        uint64_t blocksX = (levels[i].width + block.width - 1) / block.width;
+        uint64_t blocksY = (levels[i].height + block.height - 1) / block.height;
+        if (index[i].byteLength != blocksX * blocksY * block.bytes) {
+            throw std::runtime_error("ktx2 level size does not match its format!");
+        }
+        levels[i].offset = index[i].byteOffset;
+        levels[i].size = index[i].byteLength;
+    }
+}
+
+void Ktx2File::ReadLevel(uint32_t level, void* destination) {
+    const Ktx2Level& info = levels[level];
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(info.offset));
+    file.read(static_cast<char*>(destination), static_cast<std::streamsize>(info.size));
+
+    if (!file) {
+        throw std::runtime_error("failed to read ktx2 level!");
+    }
+}
+
+uint64_t Ktx2File::DataSize() const {
+    uint64_t size = 0;
+    for (const Ktx2Level& level : levels) {
+        size += level.size;
+    }
+    return size;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One mip level of a KTX2 file; level 0 is the full-resolution image.
+struct Ktx2Level {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+};
+
+// A 2D KTX2 texture with pre-built mips and no supercompression (toktx
+// without --bcmp/--zcmp; 8 to 32-bit color formats, BCn, ETC2 or ASTC). Open() reads only the
+// header and the level index; ReadLevel() pulls one level's bytes when a
+// streamer gets to it, so the small mips can be resident long before the
+// large ones are read.
+class Ktx2File {
+public:
+    void Open(const std::string& path);
+    void ReadLevel(uint32_t level, void* destination);
+
+    const std::string& Path() const { return path; }
+    VkFormat Format() const { return format; }
+    uint32_t Width() const { return levels[0].width; }
+    uint32_t Height() const { return levels[0].height; }
+    uint32_t LevelCount() const { return static_cast<uint32_t>(levels.size()); }
+    const Ktx2Level& Level(uint32_t level) const { return levels[level]; }
+    // Bytes of every level together.
+    uint64_t DataSize() const;
+
+private:
+    std::string path;
+    std::ifstream file;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    std::vector<Ktx2Level> levels;
+};
@@ -0,0 +1,762 @@
+#include "VulkanMain/Texture/Texture.h"
+#include "VulkanMain/Main/Main.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <tuple>
+
+namespace {
+    // Copy offsets must be a multiple of the texel block size (16 bytes at
+    // most) and of 4.
+    constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    uint32_t FindMemoryType(VkPhysicalDevice physicalDevice, uint32_t typeBits, VkMemoryPropertyFlags properties) {
+        VkPhysicalDeviceMemoryProperties memProperties;
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+        std::optional<uint32_t> memoryType = VkUtils::FindMemoryType(memProperties, typeBits, properties);
+        if (!memoryType) {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+        return *memoryType;
+    }
+
+    VkImageMemoryBarrier LayoutBarrier(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.layerCount = 1;
+        return barrier;
+    }
+}
+
+bool SamplerDesc::operator<(const SamplerDesc& other) const {
+    return std::tie(magFilter, minFilter, mipmapMode, addressMode, maxAnisotropy, minLod, maxLod)
+         < std::tie(other.magFilter, other.minFilter, other.mipmapMode, other.addressMode, other.maxAnisotropy, other.minLod, other.maxLod);
+}
+
+bool ImageViewDesc::operator<(const ImageViewDesc& other) const {
+    return std::tie(image, format, aspect, baseMip, mipCount)
+         < std::tie(other.image, other.format, other.aspect, other.baseMip, other.mipCount);
+}
+
+void SamplerCache::Init(VkDevice vkDevice) {
+    device = vkDevice;
+}
+
+VkSampler SamplerCache::Get(const SamplerDesc& desc) {
+    auto found = samplers.find(desc);
+    if (found != samplers.end()) {
+        hits++;
+        return found->second;
+    }
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = desc.magFilter;
+    samplerInfo.minFilter = desc.minFilter;
+    samplerInfo.mipmapMode = desc.mipmapMode;
+    samplerInfo.addressModeU = desc.addressMode;
+    samplerInfo.addressModeV = desc.addressMode;
+    samplerInfo.addressModeW = desc.addressMode;
+    samplerInfo.anisotropyEnable = desc.maxAnisotropy > 1.0f ? VK_TRUE : VK_FALSE;
+    samplerInfo.maxAnisotropy = desc.maxAnisotropy;
+    samplerInfo.minLod = desc.minLod;
+    samplerInfo.maxLod = desc.maxLod;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+
+    VkSampler sampler;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture sampler!");
+    }
+    samplers.emplace(desc, sampler);
+    return sampler;
+}
+
+void SamplerCache::Destroy() {
+    for (auto& entry : samplers) {
+        vkDestroySampler(device, entry.second, nullptr);
+    }
+    samplers.clear();
+    hits = 0;
+}
+
+void ImageViewCache::Init(VkDevice vkDevice) {
+    device = vkDevice;
+}
+
+VkImageView ImageViewCache::Get(const ImageViewDesc& desc) {
+    auto found = views.find(desc);
+    if (found != views.end()) {
+        hits++;
+        return found->second;
+    }
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = desc.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = desc.format;
+    viewInfo.subresourceRange.aspectMask = desc.aspect;
+    viewInfo.subresourceRange.baseMipLevel = desc.baseMip;
+    viewInfo.subresourceRange.levelCount = desc.mipCount;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image view!");
+    }
+    views.emplace(desc, view);
+    return view;
+}
+
+void ImageViewCache::Release(VkImage image) {
+    // Views of one image are adjacent: the key orders by image first.
+    auto it = views.lower_bound({ image, VK_FORMAT_UNDEFINED, 0, 0, 0 });
+    while (it != views.end() && it->first.image == image) {
+        vkDestroyImageView(device, it->second, nullptr);
+        it = views.erase(it);
+    }
+}
+
+void ImageViewCache::Destroy() {
+    for (auto& entry : views) {
+        vkDestroyImageView(device, entry.second, nullptr);
+    }
+    views.clear();
+    hits = 0;
+}
+
+void TextureStreamer::Init(VkDevice vkDevice, VkPhysicalDevice vkPhysicalDevice, VkDeviceSize memoryBudget, uint32_t frames, double defragMs) {
+    device = vkDevice;
+    physicalDevice = vkPhysicalDevice;
+    budget = memoryBudget;
+    framesInFlight = frames;
+    defragBudgetMs = defragMs;
+    staging.resize(frames);
+    defragTimed.assign(frames, false);
+    views.Init(device);
+}
+
+void TextureStreamer::Destroy() {
+    for (const Retired& old : retired) {
+        views.Release(old.image);
+        vkDestroyImage(device, old.image, nullptr);
+    }
+    retired.clear();
+    pendingBytes = 0;
+
+    for (Texture& texture : textures) {
+        views.Release(texture.image);
+        vkDestroyImage(device, texture.image, nullptr);
+    }
+    textures.clear();
+    pool.Destroy();
+    draining = MemoryPool::NO_BLOCK;
+    defragStalled = false;
+
+    for (Staging& buffer : staging) {
+        DestroyStaging(buffer);
+    }
+    staging.clear();
+    views.Destroy();
+    stats = TextureStats{};
+}
+
+VkImage TextureStreamer::CreateImage(const Ktx2File& file, uint32_t firstMip, VkDeviceSize& memorySize) {
+    const Ktx2Level& top = file.Level(firstMip);
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = file.Format();
+    imageInfo.extent = { top.width, top.height, 1 };
+    imageInfo.mipLevels = file.LevelCount() - firstMip;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // TRANSFER_SRC: the resident levels are copied out when a larger image
+    // replaces this one.
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    VkImage image;
+    if (vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+    memorySize = memRequirements.size;
+    return image;
+}
+
+bool TextureStreamer::AllocateImage(VkImage image, bool newBlock, PoolAllocation& allocation) {
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, image, &memRequirements);
+
+    // Color images with the same tiling and usage all allow the same
+    // memory types, so one pool serves every texture.
+    if (!pool.Initialized()) {
+        uint32_t memoryType = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        pool.Init(device, memoryType, MemoryCategory::Texture, VkTexture::POOL_BLOCK_SIZE);
+        heap = VkMemory::HeapOfType(memoryType);
+    }
+
+    if (!pool.Allocate(memRequirements, draining, newBlock, allocation)) {
+        if (newBlock) {
+            throw std::runtime_error("failed to allocate texture memory!");
+        }
+        return false;
+    }
+    vkBindImageMemory(device, image, allocation.memory, allocation.offset);
+    return true;
+}
+
+void TextureStreamer::EnsureStaging(Staging& buffer, VkDeviceSize size) {
+    if (buffer.size >= size) {
+        return;
+    }
+    DestroyStaging(buffer);
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = std::max(size, VkTexture::STREAM_BYTES_PER_FRAME);
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture staging buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, buffer.buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = FindMemoryType(physicalDevice, memRequirements.memoryTypeBits,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    if (VkMemory::Allocate(device, allocInfo, MemoryCategory::Staging, buffer.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate texture staging memory!");
+    }
+    vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+    vkMapMemory(device, buffer.memory, 0, bufferInfo.size, 0, &buffer.mapped);
+    buffer.size = bufferInfo.size;
+}
+
+void TextureStreamer::DestroyStaging(Staging& buffer) {
+    if (buffer.buffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkUnmapMemory(device, buffer.memory);
+    vkDestroyBuffer(device, buffer.buffer, nullptr);
+    VkMemory::Free(device, buffer.memory);
+    buffer = Staging{};
+}
+
+void TextureStreamer::UpdateView(Texture& texture) {
+    texture.view = views.Get({ texture.image, texture.file.Format(), VK_IMAGE_ASPECT_COLOR_BIT, 0, texture.file.LevelCount() - texture.residentMip });
+    stats.views = static_cast<uint32_t>(views.Size());
+}
+
+void TextureStreamer::CopyLevels(VkCommandBuffer commandBuffer, Texture& texture, VkImage image, uint32_t firstMip, uint32_t lastMip, Staging& buffer, VkDeviceSize& offset) {
+    std::vector<VkBufferImageCopy> regions;
+    for (uint32_t mip = firstMip; mip < lastMip; mip++) {
+        const Ktx2Level& level = texture.file.Level(mip);
+        offset = AlignUp(offset, STAGING_ALIGNMENT);
+        texture.file.ReadLevel(mip, static_cast<char*>(buffer.mapped) + offset);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = mip - firstMip;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = { level.width, level.height, 1 };
+        regions.push_back(region);
+
+        offset += level.size;
+    }
+
+    vkCmdCopyBufferToImage(commandBuffer, buffer.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+}
+
+uint32_t TextureStreamer::Load(const std::string& path, VkCommandPool commandPool, VkQueue queue) {
+    auto loadStart = std::chrono::steady_clock::now();
+
+    Texture texture;
+    texture.file.Open(path);
+
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(physicalDevice, texture.file.Format(), &formatProperties);
+    if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT)) {
+        throw std::runtime_error("texture format is not supported by this device!");
+    }
+
+    // The tail of the chain up to INITIAL_MIP_SIZE, at least the last level.
+    uint32_t levelCount = texture.file.LevelCount();
+    uint32_t firstMip = levelCount - 1;
+    while (firstMip > 0 && std::max(texture.file.Level(firstMip - 1).width, texture.file.Level(firstMip - 1).height) <= VkTexture::INITIAL_MIP_SIZE) {
+        firstMip--;
+    }
+
+    // Never allocated, only asked what the whole chain would take.
+    VkDeviceSize fullSize;
+    vkDestroyImage(device, CreateImage(texture.file, 0, fullSize), nullptr);
+
+    texture.image = CreateImage(texture.file, firstMip, texture.memorySize);
+    AllocateImage(texture.image, true, texture.allocation);
+    texture.residentMip = firstMip;
+
+    Staging upload;
+    VkDeviceSize uploadSize = 0;
+    for (uint32_t mip = firstMip; mip < levelCount; mip++) {
+        uploadSize = AlignUp(uploadSize, STAGING_ALIGNMENT) + texture.file.Level(mip).size;
+    }
+    EnsureStaging(upload, uploadSize);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate texture upload command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    VkImageMemoryBarrier toTransfer = LayoutBarrier(texture.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkDeviceSize offset = 0;
+    CopyLevels(commandBuffer, texture, texture.image, firstMip, levelCount, upload, offset);
+
+    VkImageMemoryBarrier toShader = LayoutBarrier(texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toShader);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit texture upload!");
+    }
+    vkQueueWaitIdle(queue);
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+    DestroyStaging(upload);
+
+    UpdateView(texture);
+    textures.push_back(std::move(texture));
+
+    stats.textures++;
+    stats.residentBytes += textures.back().memorySize;
+    stats.fullBytes += fullSize;
+    stats.loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    stats.pool = pool.Stats();
+    return static_cast<uint32_t>(textures.size() - 1);
+}
+
+// The old image and its view stay until no frame in flight can use them.
+void TextureStreamer::Retire(Texture& texture, VkImage image, const PoolAllocation& allocation, VkDeviceSize memorySize, uint32_t residentMip, uint64_t frameNumber) {
+    retired.push_back({ frameNumber, texture.image, texture.allocation, texture.memorySize });
+    pendingBytes += texture.memorySize;
+    stats.residentBytes = stats.residentBytes - texture.memorySize + memorySize;
+
+    texture.image = image;
+    texture.allocation = allocation;
+    texture.memorySize = memorySize;
+    texture.residentMip = residentMip;
+    texture.nextMemorySize = 0;
+    texture.changed = true;
+    UpdateView(texture);
+}
+
+void TextureStreamer::CopyResident(VkCommandBuffer commandBuffer, const Texture& texture, VkImage image, uint32_t firstMip) {
+    // Frames already submitted may still sample the old image; the barrier
+    // waits for their fragment shaders before it becomes a copy source.
+    VkImageMemoryBarrier toCopy[2] = {
+        LayoutBarrier(image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT),
+        LayoutBarrier(texture.image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0, VK_ACCESS_TRANSFER_READ_BIT)
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, toCopy);
+
+    // File level l is level l - residentMip of the old image and l - firstMip
+    // of the new one.
+    std::vector<VkImageCopy> regions;
+    for (uint32_t level = std::max(firstMip, texture.residentMip); level < texture.file.LevelCount(); level++) {
+        VkImageCopy region{};
+        region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.srcSubresource.mipLevel = level - texture.residentMip;
+        region.srcSubresource.layerCount = 1;
+        region.dstSubresource = region.srcSubresource;
+        region.dstSubresource.mipLevel = level - firstMip;
+        region.extent = { texture.file.Level(level).width, texture.file.Level(level).height, 1 };
+        regions.push_back(region);
+    }
+    vkCmdCopyImage(commandBuffer, texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+}
+
+// Replaces texture's image with one that also holds the next larger level.
+bool TextureStreamer::Promote(VkCommandBuffer commandBuffer, Texture& texture, Staging& buffer, VkDeviceSize& offset, uint64_t frameNumber, VkDeviceSize& headroom) {
+    uint32_t mip = texture.residentMip - 1;
+    if (texture.nextMemorySize > headroom) {
+        return false;
+    }
+
+    VkDeviceSize memorySize;
+    VkImage image = CreateImage(texture.file, mip, memorySize);
+    texture.nextMemorySize = memorySize;
+    if (stats.residentBytes - texture.memorySize + memorySize > budget) {
+        vkDestroyImage(device, image, nullptr);
+        texture.budgetLimited = true;
+        return false;
+    }
+    // Until the old image is retired both are allocated.
+    if (memorySize > headroom) {
+        vkDestroyImage(device, image, nullptr);
+        return false;
+    }
+    headroom -= memorySize;
+    PoolAllocation allocation;
+    AllocateImage(image, true, allocation);
+
+    CopyResident(commandBuffer, texture, image, mip);
+    CopyLevels(commandBuffer, texture, image, mip, mip + 1, buffer, offset);
+
+    VkImageMemoryBarrier toShader = LayoutBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toShader);
+
+    stats.streamedBytes += texture.file.Level(mip).size;
+    Retire(texture, image, allocation, memorySize, mip, frameNumber);
+    return true;
+}
+
+// Never below what Load() made resident.
+bool TextureStreamer::CanDemote(const Texture& texture) const {
+    const Ktx2Level& top = texture.file.Level(texture.residentMip);
+    return texture.residentMip + 1 < texture.file.LevelCount() && std::max(top.width, top.height) > VkTexture::INITIAL_MIP_SIZE;
+}
+
+VkDeviceSize TextureStreamer::Demote(VkCommandBuffer commandBuffer, Texture& texture, uint64_t frameNumber) {
+    uint32_t mip = texture.residentMip + 1;
+
+    VkDeviceSize memorySize;
+    VkImage image = CreateImage(texture.file, mip, memorySize);
+    // Demoting is how memory is given back; it must not take a new block.
+    PoolAllocation allocation;
+    if (!AllocateImage(image, false, allocation)) {
+        vkDestroyImage(device, image, nullptr);
+        return 0;
+    }
+
+    CopyResident(commandBuffer, texture, image, mip);
+
+    VkImageMemoryBarrier toShader = LayoutBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toShader);
+
+    VkDeviceSize freed = texture.memorySize - std::min(texture.memorySize, memorySize);
+    Retire(texture, image, allocation, memorySize, mip, frameNumber);
+    // There is room under the texture budget again.
+    texture.budgetLimited = false;
+    stats.evictions++;
+    stats.evictedBytes += freed;
+    return freed;
+}
+
+bool TextureStreamer::Evict(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint64_t frameNumber) {
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < textures.size(); i++) {
+        if (CanDemote(textures[i])) {
+            candidates.push_back(i);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+        if (textures[a].lastUsed != textures[b].lastUsed) {
+            return textures[a].lastUsed < textures[b].lastUsed;
+        }
+        return textures[a].memorySize > textures[b].memorySize;
+    });
+
+    VkDeviceSize freed = 0;
+    for (uint32_t i : candidates) {
+        while (freed < bytes && CanDemote(textures[i])) {
+            VkDeviceSize demoted = Demote(commandBuffer, textures[i], frameNumber);
+            if (demoted == 0) {
+                break;
+            }
+            freed += demoted;
+        }
+    }
+    return freed > 0;
+}
+
+// Never grows the pool: an image that only fits in a new block stays.
+bool TextureStreamer::Move(VkCommandBuffer commandBuffer, Texture& texture, uint64_t frameNumber) {
+    VkDeviceSize memorySize;
+    VkImage image = CreateImage(texture.file, texture.residentMip, memorySize);
+    PoolAllocation allocation;
+    if (!AllocateImage(image, false, allocation)) {
+        vkDestroyImage(device, image, nullptr);
+        return false;
+    }
+
+    CopyResident(commandBuffer, texture, image, texture.residentMip);
+
+    VkImageMemoryBarrier toShader = LayoutBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toShader);
+
+    Retire(texture, image, allocation, memorySize, texture.residentMip, frameNumber);
+    stats.defragMoves++;
+    stats.defragBytes += memorySize;
+    return true;
+}
+
+void TextureStreamer::SetTimestampQueries(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queriesPerFrame, double periodNs, uint32_t validBits) {
+    timestampPool = queryPool;
+    timestampFirst = firstQuery;
+    timestampStride = queriesPerFrame;
+    timestampPeriodNs = periodNs;
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+}
+
+void TextureStreamer::ReadDefragTime(uint32_t frame) {
+    stats.defragMs = 0.0;
+    if (!defragTimed[frame]) {
+        return;
+    }
+    defragTimed[frame] = false;
+
+    uint64_t timestamps[2];
+    if (vkGetQueryPoolResults(device, timestampPool, frame * timestampStride + timestampFirst, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+        uint64_t ticks = (timestamps[1] - timestamps[0]) & timestampMask;
+        stats.defragMs = static_cast<double>(ticks) * timestampPeriodNs / 1e6;
+    }
+}
+
+// One block at a time: its images move out over as many frames as the
+// limits need, and the block goes back to the driver once the last old
+// image is retired. defragBudgetMs bounds the CPU time spent recording.
+bool TextureStreamer::Defragment(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    pool.ReleaseEmpty();
+    if (draining != MemoryPool::NO_BLOCK && pool.Used(draining) == 0) {
+        draining = MemoryPool::NO_BLOCK;
+    }
+    if (defragBudgetMs <= 0.0) {
+        return false;
+    }
+    // The same layout would pick the same block and fail the same way.
+    if (defragStalled && pool.Generation() == stalledGeneration) {
+        return false;
+    }
+    defragStalled = false;
+    if (draining == MemoryPool::NO_BLOCK) {
+        draining = pool.SparsestBlock();
+    }
+
+    bool changed = false;
+    bool timed = false;
+    for (Texture& texture : textures) {
+        if (draining == MemoryPool::NO_BLOCK) {
+            break;
+        }
+        if (texture.allocation.block != draining) {
+            continue;
+        }
+        if (!timed && timestampPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, frame * timestampStride + timestampFirst);
+            timed = true;
+        }
+        // The free space is too scattered after all; try again once
+        // something has been allocated or freed.
+        if (!Move(commandBuffer, texture, frameNumber)) {
+            draining = MemoryPool::NO_BLOCK;
+            defragStalled = true;
+            stalledGeneration = pool.Generation();
+            break;
+        }
+        changed = true;
+        if (stats.defragBytes >= VkTexture::DEFRAG_BYTES_PER_FRAME || elapsedMs() >= defragBudgetMs) {
+            break;
+        }
+    }
+    if (timed) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, frame * timestampStride + timestampFirst + 1);
+    }
+    defragTimed[frame] = timed;
+    return changed;
+}
+
+bool TextureStreamer::StreamIn(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkDeviceSize headroom) {
+    // Smallest next level first, as many as fit this frame's upload.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < textures.size(); i++) {
+        if (textures[i].residentMip > 0 && !textures[i].budgetLimited && textures[i].nextMemorySize <= headroom) {
+            candidates.push_back(i);
+        }
+    }
+    auto nextSize = [&](uint32_t i) {
+        return AlignUp(textures[i].file.Level(textures[i].residentMip - 1).size, STAGING_ALIGNMENT);
+    };
+    std::sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+        return nextSize(a) < nextSize(b);
+    });
+
+    VkDeviceSize planned = 0;
+    size_t count = 0;
+    for (; count < candidates.size(); count++) {
+        VkDeviceSize size = nextSize(candidates[count]);
+        if (planned > 0 && planned + size > VkTexture::STREAM_BYTES_PER_FRAME) {
+            break;
+        }
+        planned += size;
+    }
+    if (count == 0) {
+        return false;
+    }
+
+    EnsureStaging(staging[frame], planned);
+    VkDeviceSize offset = 0;
+    bool changed = false;
+    for (size_t i = 0; i < count; i++) {
+        changed |= Promote(commandBuffer, textures[candidates[i]], staging[frame], offset, frameNumber, headroom);
+    }
+    return changed;
+}
+
+bool TextureStreamer::Stream(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkDeviceSize headroom, VkDeviceSize excess) {
+    stats.streamedBytes = 0;
+    stats.evictedBytes = 0;
+    stats.defragBytes = 0;
+    ReadDefragTime(frame);
+    for (Texture& texture : textures) {
+        texture.changed = false;
+    }
+
+    auto expired = std::partition(retired.begin(), retired.end(), [&](const Retired& old) {
+        return frameNumber < old.frameNumber + framesInFlight;
+    });
+    for (auto it = expired; it != retired.end(); ++it) {
+        views.Release(it->image);
+        vkDestroyImage(device, it->image, nullptr);
+        pool.Free(it->allocation);
+        pendingBytes -= it->memorySize;
+    }
+    retired.erase(expired, retired.end());
+    stats.views = static_cast<uint32_t>(views.Size());
+
+    bool changed = excess > 0 ? Evict(commandBuffer, excess, frameNumber) : StreamIn(commandBuffer, frame, frameNumber, headroom);
+    changed |= Defragment(commandBuffer, frame, frameNumber);
+    stats.pool = pool.Stats();
+    return changed;
+}
+
+void VkMain::CreateTextures() {
+    samplerCache.Init(device);
+
+    std::string path = VkUtils::GetEnvString("VK3D_TEXTURE");
+    if (path.empty()) {
+        return;
+    }
+    if (!bindless) {
+        std::cout << "Textures are only sampled in bindless mode (VK3D_BINDLESS=1), not loading " << path << std::endl;
+        return;
+    }
+
+    VkDeviceSize budget = static_cast<VkDeviceSize>(VkUtils::GetEnvUint("VK3D_TEXTURE_BUDGET_MB", 256)) << 20;
+    double defragMs = VkUtils::GetEnvUint("VK3D_DEFRAG_US", 500) / 1000.0;
+    textureStreamer.Init(device, physicalDevice, budget, MAX_FRAMES_IN_FLIGHT, defragMs);
+    sceneTexture = textureStreamer.Load(path, commandPool, graphicsQueue);
+
+    textureSampler = samplerCache.Get(SamplerDesc{});
+    sceneTextureSlot = bindlessTable.RegisterImage(textureStreamer.View(sceneTexture), textureSampler);
+    for (auto& uploads : objectUploads) {
+        uploads.AddAll();
+    }
+
+    frameStats.textures = textureStreamer.Stats();
+    frameStats.textures.samplers = static_cast<uint32_t>(samplerCache.Size());
+}
+
+// Before the frame's object upload, so a replaced view reaches this frame's
+// object buffer together with the copy that fills it.
+void VkMain::StreamTextures(VkCommandBuffer commandBuffer) {
+    if (sceneTexture == NO_TEXTURE) {
+        return;
+    }
+
+    // Once every frame in flight has its object buffer rewritten, nothing
+    // reads the old slot any more.
+    auto expired = std::partition(retiredTextureSlots.begin(), retiredTextureSlots.end(), [&](const std::pair<uint64_t, uint32_t>& slot) {
+        return frameStats.frame < slot.first + MAX_FRAMES_IN_FLIGHT;
+    });
+    for (auto it = expired; it != retiredTextureSlots.end(); ++it) {
+        bindlessTable.ReleaseImage(it->second);
+    }
+    retiredTextureSlots.erase(expired, retiredTextureSlots.end());
+
+    // Retired images and free pool space count in the driver's usage but
+    // are there for the taking. Without a heap budget (no heaps reported) streaming
+    // is only held back by the texture budget.
+    VkDeviceSize headroom = ~VkDeviceSize(0);
+    VkDeviceSize excess = 0;
+    uint32_t heap = textureStreamer.Heap();
+    if (heap < frameStats.memory.heaps.size() && frameStats.memory.heaps[heap].budget > 0) {
+        const MemoryHeapStats& stats = frameStats.memory.heaps[heap];
+        VkDeviceSize usage = stats.usage - std::min(stats.usage, textureStreamer.ReusableBytes());
+        VkDeviceSize high = stats.budget / 100 * VkTexture::EVICT_ABOVE_PERCENT;
+        VkDeviceSize low = stats.budget / 100 * VkTexture::GROW_BELOW_PERCENT;
+        if (usage > high) {
+            excess = usage - low;
+        }
+        headroom = usage < low ? low - usage : 0;
+    }
+
+    textureStreamer.Touch(sceneTexture, frameStats.frame);
+    if (textureStreamer.Stream(commandBuffer, currentFrame, frameStats.frame, headroom, excess) && textureStreamer.Changed(sceneTexture)) {
+        retiredTextureSlots.push_back({ frameStats.frame, sceneTextureSlot });
+        sceneTextureSlot = bindlessTable.RegisterImage(textureStreamer.View(sceneTexture), textureSampler);
+        for (auto& uploads : objectUploads) {
+            uploads.AddAll();
+        }
+    }
+
+    frameStats.textures = textureStreamer.Stats();
+    frameStats.textures.samplers = static_cast<uint32_t>(samplerCache.Size());
+}
+
+void VkMain::DestroyTextures() {
+    textureStreamer.Destroy();
+    samplerCache.Destroy();
+    sceneTexture = NO_TEXTURE;
+    sceneTextureSlot = VkBindless::INVALID_INDEX;
+    retiredTextureSlots.clear();
+}
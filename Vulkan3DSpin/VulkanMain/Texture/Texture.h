@@ -0,0 +1,263 @@
+#pragma once
+#include "VulkanMain/Texture/Ktx2.h"
+#include "VulkanMain/Dispatch/Dispatch.h"
+#include "VulkanMain/Memory/Pool.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace VkTexture {
+    // Levels at most this many texels on a side are uploaded by Load(); the
+    // rest stream in one level at a time.
+    constexpr uint32_t INITIAL_MIP_SIZE = 128;
+    // Streaming upload per frame. A single level larger than this still goes
+    // through, alone in its frame.
+    constexpr VkDeviceSize STREAM_BYTES_PER_FRAME = 8ull << 20;
+    // Of the texture heap's budget: above the first, least recently used
+    // textures drop levels until usage is back under the second, and only
+    // below the second do they stream in new ones.
+    constexpr VkDeviceSize EVICT_ABOVE_PERCENT = 95;
+    constexpr VkDeviceSize GROW_BELOW_PERCENT = 90;
+    // Images are suballocated from blocks this large; a larger image gets a
+    // block of its own.
+    constexpr VkDeviceSize POOL_BLOCK_SIZE = 32ull << 20;
+    // Copied per frame to empty sparse blocks, on top of the time limit.
+    constexpr VkDeviceSize DEFRAG_BYTES_PER_FRAME = 8ull << 20;
+}
+
+// Everything that decides what a VkSampler does, so equal descriptions can
+// share one sampler.
+struct SamplerDesc {
+    VkFilter magFilter = VK_FILTER_LINEAR;
+    VkFilter minFilter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    // 1 leaves anisotropic filtering off.
+    float maxAnisotropy = 1.0f;
+    float minLod = 0.0f;
+    float maxLod = VK_LOD_CLAMP_NONE;
+
+    bool operator<(const SamplerDesc& other) const;
+};
+
+struct ImageViewDesc {
+    VkImage image;
+    VkFormat format;
+    VkImageAspectFlags aspect;
+    uint32_t baseMip;
+    uint32_t mipCount;
+
+    bool operator<(const ImageViewDesc& other) const;
+};
+
+// Both caches own what they hand out until Destroy(); asking twice for the
+// same description returns the same handle.
+class SamplerCache {
+public:
+    void Init(VkDevice device);
+    VkSampler Get(const SamplerDesc& desc);
+    void Destroy();
+
+    size_t Size() const { return samplers.size(); }
+    uint32_t Hits() const { return hits; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    std::map<SamplerDesc, VkSampler> samplers;
+    uint32_t hits = 0;
+};
+
+class ImageViewCache {
+public:
+    void Init(VkDevice device);
+    VkImageView Get(const ImageViewDesc& desc);
+    // Destroys every view of image, before the image itself goes.
+    void Release(VkImage image);
+    void Destroy();
+
+    size_t Size() const { return views.size(); }
+    uint32_t Hits() const { return hits; }
+
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    std::map<ImageViewDesc, VkImageView> views;
+    uint32_t hits = 0;
+};
+
+struct TextureStats {
+    uint32_t textures = 0;
+    double loadMs = 0.0;
+    // Device memory of the resident mips, and what full chains would take.
+    VkDeviceSize residentBytes = 0;
+    VkDeviceSize fullBytes = 0;
+    // Mip data uploaded by the last Stream().
+    VkDeviceSize streamedBytes = 0;
+    // Levels dropped to get back under the heap budget since Load(), and
+    // the memory the last Stream() gave back that way.
+    uint32_t evictions = 0;
+    VkDeviceSize evictedBytes = 0;
+    MemoryPoolStats pool;
+    // Images moved to empty sparse blocks since Load(); the bytes of the
+    // last Stream()'s moves, and the GPU time of the moves it read back
+    // (recorded framesInFlight frames earlier; 0 when none were timed).
+    uint32_t defragMoves = 0;
+    VkDeviceSize defragBytes = 0;
+    double defragMs = 0.0;
+    uint32_t samplers = 0;
+    uint32_t views = 0;
+};
+
+// Device-local KTX2 textures filled through a staging buffer. Load() makes
+// the smallest mips resident straight away; each Stream() then adds the next
+// larger level of a texture while the memory budget allows, or when the heap
+// runs short takes the largest level off the least recently used textures.
+//
+// A texture's image only ever holds its resident levels. Adding a level
+// allocates a larger image, copies the resident levels over on the GPU and
+// retires the old image once the frames in flight that may sample it are
+// done, so memory use follows what is actually resident.
+//
+// Images are suballocated from a MemoryPool, which fragments as they come
+// and go. Each Stream() also drains the sparsest block a few images at a
+// time, moving them into the free space of the others the same way, and
+// releases blocks once they are empty.
+class TextureStreamer {
+public:
+    // defragMs limits the CPU time spent moving images per frame; 0 turns
+    // defragmentation off.
+    void Init(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize budget, uint32_t framesInFlight, double defragMs);
+    void Destroy();
+    // Image moves are bracketed by queries firstQuery and firstQuery + 1 of
+    // each frame's queriesPerFrame in queryPool, which the caller resets
+    // before Stream(). periodNs and validBits are the queue's.
+    void SetTimestampQueries(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queriesPerFrame, double periodNs, uint32_t validBits);
+
+    // Synchronous: records the initial upload into a one-time command buffer
+    // and waits for queue to finish it.
+    uint32_t Load(const std::string& path, VkCommandPool commandPool, VkQueue queue);
+
+    // Records this frame's uploads into commandBuffer, before anything that
+    // samples the textures. frame selects the staging buffer (the caller has
+    // waited for its last use); frameNumber counts frames and decides when
+    // retired images are free. headroom is how much more the heap can take;
+    // with excess > 0 nothing is promoted and at least that much is evicted
+    // instead, as far as the initial mips allow. Returns true if any View()
+    // changed.
+    bool Stream(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkDeviceSize headroom, VkDeviceSize excess);
+
+    // Marks texture as used this frame, for eviction order.
+    void Touch(uint32_t texture, uint64_t frameNumber) { textures[texture].lastUsed = frameNumber; }
+    // The heap the images come from.
+    uint32_t Heap() const { return heap; }
+    // What the driver counts as used but textures can take again: free
+    // space in the pool and retired images not yet freed.
+    VkDeviceSize ReusableBytes() const { return pendingBytes + pool.FreeBytes(); }
+
+    // Covers the resident levels only.
+    VkImageView View(uint32_t texture) const { return textures[texture].view; }
+    uint32_t ResidentMip(uint32_t texture) const { return textures[texture].residentMip; }
+    bool Changed(uint32_t texture) const { return textures[texture].changed; }
+
+    const TextureStats& Stats() const { return stats; }
+
+private:
+    struct Texture {
+        Ktx2File file;
+        // Levels [residentMip, LevelCount()) of the file are in image.
+        uint32_t residentMip = 0;
+        VkImage image = VK_NULL_HANDLE;
+        PoolAllocation allocation;
+        VkDeviceSize memorySize = 0;
+        VkImageView view = VK_NULL_HANDLE;
+        // Set by Stream() when the view was replaced.
+        bool changed = false;
+        // The next level would not fit the budget.
+        bool budgetLimited = false;
+        // What the image with the next level takes, once CreateImage has
+        // been asked; 0 until then. Lets Promote wait for heap headroom
+        // without creating and destroying that image every frame.
+        VkDeviceSize nextMemorySize = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    struct Staging {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+    };
+
+    struct Retired {
+        uint64_t frameNumber;
+        VkImage image;
+        PoolAllocation allocation;
+        VkDeviceSize memorySize;
+    };
+
+    // Image for file levels [firstMip, LevelCount()); memorySize is set to
+    // what it needs before anything is allocated so the budget can be checked.
+    VkImage CreateImage(const Ktx2File& file, uint32_t firstMip, VkDeviceSize& memorySize);
+    // Outside the block being drained. Only when newBlock is set may the
+    // pool grow; returns false if it would have to.
+    bool AllocateImage(VkImage image, bool newBlock, PoolAllocation& allocation);
+    void EnsureStaging(Staging& staging, VkDeviceSize size);
+    void DestroyStaging(Staging& staging);
+    void UpdateView(Texture& texture);
+    // Reads file levels [firstMip, lastMip) into staging at offset and copies
+    // them to levels [0, lastMip - firstMip) of image, which must be in
+    // TRANSFER_DST layout. offset ends past the last level written.
+    void CopyLevels(VkCommandBuffer commandBuffer, Texture& texture, VkImage image, uint32_t firstMip, uint32_t lastMip, Staging& staging, VkDeviceSize& offset);
+    // Copies the levels image shares with texture's image, which it
+    // replaces; image holds file levels from firstMip and ends in
+    // TRANSFER_DST layout.
+    void CopyResident(VkCommandBuffer commandBuffer, const Texture& texture, VkImage image, uint32_t firstMip);
+    bool Promote(VkCommandBuffer commandBuffer, Texture& texture, Staging& staging, VkDeviceSize& offset, uint64_t frameNumber, VkDeviceSize& headroom);
+    // The reverse: copies all but the largest resident level into a smaller
+    // image. Returns the memory that frees once the old image is retired, or
+    // 0 if the smaller image does not fit in the existing blocks; nothing is
+    // recorded then.
+    VkDeviceSize Demote(VkCommandBuffer commandBuffer, Texture& texture, uint64_t frameNumber);
+    bool CanDemote(const Texture& texture) const;
+    // Least recently used first, then the largest.
+    bool Evict(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint64_t frameNumber);
+    bool StreamIn(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber, VkDeviceSize headroom);
+    void Retire(Texture& texture, VkImage image, const PoolAllocation& allocation, VkDeviceSize memorySize, uint32_t residentMip, uint64_t frameNumber);
+    // Same levels, new place.
+    bool Move(VkCommandBuffer commandBuffer, Texture& texture, uint64_t frameNumber);
+    bool Defragment(VkCommandBuffer commandBuffer, uint32_t frame, uint64_t frameNumber);
+    // GPU time of the moves frame recorded last time round, once its
+    // submission is done.
+    void ReadDefragTime(uint32_t frame);
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDeviceSize budget = 0;
+    uint32_t framesInFlight = 1;
+    uint32_t heap = 0;
+    VkDeviceSize pendingBytes = 0;
+    double defragBudgetMs = 0.0;
+
+    MemoryPool pool;
+    // Nothing new is placed here while its images move out.
+    uint32_t draining = MemoryPool::NO_BLOCK;
+    // A move found no room in the pool as of this generation; retried
+    // once it has changed.
+    bool defragStalled = false;
+    uint64_t stalledGeneration = 0;
+
+    VkQueryPool timestampPool = VK_NULL_HANDLE;
+    uint32_t timestampFirst = 0;
+    uint32_t timestampStride = 0;
+    double timestampPeriodNs = 0.0;
+    uint64_t timestampMask = 0;
+    // Whether each frame's command buffer wrote the defrag timestamps.
+    std::vector<bool> defragTimed;
+
+    std::vector<Texture> textures;
+    std::vector<Staging> staging;
+    std::vector<Retired> retired;
+    ImageViewCache views;
+    TextureStats stats;
+};
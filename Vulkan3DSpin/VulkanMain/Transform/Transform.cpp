@@ -0,0 +1,287 @@
+#include "VulkanMain/Transform/Transform.h"
+#include "VulkanMain/Jobs/Jobs.h"
+#include "VulkanMain/Simd/Simd.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+    struct TransformStreams {
+        const float* posX; const float* posY; const float* posZ;
+        const float* rotX; const float* rotY; const float* rotZ; const float* rotW;
+        const float* scaleX; const float* scaleY; const float* scaleZ;
+    };
+
+#if defined(VK3D_SIMD)
+    using VkSimd::Lanes;
+
+    // vp[k * 4 + r] = m[k][r] broadcast to every lane.
+    void Broadcast(const glm::mat4& m, Lanes::Reg* vp) {
+        for (int k = 0; k < 4; k++) {
+            for (int r = 0; r < 4; r++) {
+                vp[k * 4 + r] = Lanes::Set(m[k][r]);
+            }
+        }
+    }
+
+    // Rotation and scale columns of T * R * S for Lanes::WIDTH objects
+    // starting at i; w[column][row], same layout as glm::mat4_cast.
+    void BuildBasis(const TransformStreams& s, size_t i, Lanes::Reg w[3][3]) {
+        using L = Lanes;
+        const L::Reg one = L::Set(1.0f);
+        const L::Reg two = L::Set(2.0f);
+
+        L::Reg qx = L::Load(s.rotX + i), qy = L::Load(s.rotY + i), qz = L::Load(s.rotZ + i), qw = L::Load(s.rotW + i);
+        L::Reg sx = L::Load(s.scaleX + i), sy = L::Load(s.scaleY + i), sz = L::Load(s.scaleZ + i);
+
+        L::Reg xx = L::Mul(qx, qx), yy = L::Mul(qy, qy), zz = L::Mul(qz, qz);
+        L::Reg xy = L::Mul(qx, qy), xz = L::Mul(qx, qz), yz = L::Mul(qy, qz);
+        L::Reg wx = L::Mul(qw, qx), wy = L::Mul(qw, qy), wz = L::Mul(qw, qz);
+
+        w[0][0] = L::Mul(L::Sub(one, L::Mul(two, L::Add(yy, zz))), sx);
+        w[0][1] = L::Mul(L::Mul(two, L::Add(xy, wz)), sx);
+        w[0][2] = L::Mul(L::Mul(two, L::Sub(xz, wy)), sx);
+        w[1][0] = L::Mul(L::Mul(two, L::Sub(xy, wz)), sy);
+        w[1][1] = L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, zz))), sy);
+        w[1][2] = L::Mul(L::Mul(two, L::Add(yz, wx)), sy);
+        w[2][0] = L::Mul(L::Mul(two, L::Add(xz, wy)), sz);
+        w[2][1] = L::Mul(L::Mul(two, L::Sub(yz, wx)), sz);
+        w[2][2] = L::Mul(L::Sub(one, L::Mul(two, L::Add(xx, yy))), sz);
+    }
+
+    // Builds world for Lanes::WIDTH objects starting at i.
+    void BuildLocalBatch(const TransformStreams& s, size_t i, glm::mat4* world) {
+        using L = Lanes;
+        const L::Reg one = L::Set(1.0f);
+        const L::Reg zero = L::Set(0.0f);
+
+        L::Reg w[3][3];
+        BuildBasis(s, i, w);
+        for (int c = 0; c < 3; c++) {
+            L::StoreColumn(world + i, c, w[c][0], w[c][1], w[c][2], zero);
+        }
+        L::StoreColumn(world + i, 3, L::Load(s.posX + i), L::Load(s.posY + i), L::Load(s.posZ + i), one);
+    }
+
+    // Builds world and MVP for Lanes::WIDTH objects starting at i.
+    // vp comes from Broadcast(viewProj).
+    void BuildBatch(const TransformStreams& s, size_t i, const Lanes::Reg* vp, glm::mat4* world, glm::mat4* mvp) {
+        using L = Lanes;
+        const L::Reg one = L::Set(1.0f);
+        const L::Reg zero = L::Set(0.0f);
+
+        L::Reg w[3][3];
+        BuildBasis(s, i, w);
+        L::Reg px = L::Load(s.posX + i), py = L::Load(s.posY + i), pz = L::Load(s.posZ + i);
+
+        for (int c = 0; c < 3; c++) {
+            L::StoreColumn(world + i, c, w[c][0], w[c][1], w[c][2], zero);
+        }
+        L::StoreColumn(world + i, 3, px, py, pz, one);
+
+        // mvp[c][r] = sum_k viewProj[k][r] * world[c][k]
+        for (int c = 0; c < 3; c++) {
+            L::Reg r[4];
+            for (int row = 0; row < 4; row++) {
+                r[row] = L::Add(L::Add(
+                    L::Mul(vp[0 * 4 + row], w[c][0]),
+                    L::Mul(vp[1 * 4 + row], w[c][1])),
+                    L::Mul(vp[2 * 4 + row], w[c][2]));
+            }
+            L::StoreColumn(mvp + i, c, r[0], r[1], r[2], r[3]);
+        }
+
+        L::Reg t[4];
+        for (int row = 0; row < 4; row++) {
+            t[row] = L::Add(L::Add(L::Add(
+                L::Mul(vp[0 * 4 + row], px),
+                L::Mul(vp[1 * 4 + row], py)),
+                L::Mul(vp[2 * 4 + row], pz)),
+                vp[3 * 4 + row]);
+        }
+        L::StoreColumn(mvp + i, 3, t[0], t[1], t[2], t[3]);
+    }
+
+    // out[objects[j]] = viewProj * world[objects[j]] for j < Lanes::WIDTH.
+    void MultiplyBatch(const Lanes::Reg* vp, const glm::mat4* world, const uint32_t* objects, glm::mat4* out) {
+        using L = Lanes;
+        glm::mat4 batch[L::WIDTH];
+
+        for (int c = 0; c < 4; c++) {
+            L::Reg w[4];
+            L::LoadColumn(world, objects, c, w[0], w[1], w[2], w[3]);
+
+            L::Reg r[4];
+            for (int row = 0; row < 4; row++) {
+                r[row] = L::Add(L::Add(L::Add(
+                    L::Mul(vp[0 * 4 + row], w[0]),
+                    L::Mul(vp[1 * 4 + row], w[1])),
+                    L::Mul(vp[2 * 4 + row], w[2])),
+                    L::Mul(vp[3 * 4 + row], w[3]));
+            }
+            L::StoreColumn(batch, c, r[0], r[1], r[2], r[3]);
+        }
+
+        for (size_t j = 0; j < L::WIDTH; j++) {
+            out[objects[j]] = batch[j];
+        }
+    }
+#endif
+
+    // Scalar version of BuildLocalBatch for the tail of a range.
+    void BuildLocal(const TransformStreams& s, size_t i, glm::mat4& world) {
+        float qx = s.rotX[i], qy = s.rotY[i], qz = s.rotZ[i], qw = s.rotW[i];
+        float xx = qx * qx, yy = qy * qy, zz = qz * qz;
+        float xy = qx * qy, xz = qx * qz, yz = qy * qz;
+        float wx = qw * qx, wy = qw * qy, wz = qw * qz;
+
+        world[0] = glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * s.scaleX[i];
+        world[1] = glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * s.scaleY[i];
+        world[2] = glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * s.scaleZ[i];
+        world[3] = glm::vec4(s.posX[i], s.posY[i], s.posZ[i], 1.0f);
+    }
+
+    // Scalar version of BuildBatch for the tail of a range.
+    void BuildOne(const TransformStreams& s, size_t i, const glm::mat4& viewProj, glm::mat4& world, glm::mat4& mvp) {
+        BuildLocal(s, i, world);
+        mvp = viewProj * world;
+    }
+}
+
+uint32_t TransformSystem::Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+    uint32_t index = static_cast<uint32_t>(Size());
+    Resize(Size() + 1);
+    SetPosition(index, position);
+    SetRotation(index, rotation);
+    SetScale(index, scale);
+    return index;
+}
+
+void TransformSystem::Resize(size_t count) {
+    posX.resize(count, 0.0f);
+    posY.resize(count, 0.0f);
+    posZ.resize(count, 0.0f);
+    rotX.resize(count, 0.0f);
+    rotY.resize(count, 0.0f);
+    rotZ.resize(count, 0.0f);
+    rotW.resize(count, 1.0f);
+    scaleX.resize(count, 1.0f);
+    scaleY.resize(count, 1.0f);
+    scaleZ.resize(count, 1.0f);
+
+    world.resize(count, glm::mat4(1.0f));
+    mvp.resize(count, glm::mat4(1.0f));
+}
+
+void TransformSystem::Clear() {
+    Resize(0);
+}
+
+void TransformSystem::SetPosition(uint32_t index, const glm::vec3& position) {
+    posX[index] = position.x;
+    posY[index] = position.y;
+    posZ[index] = position.z;
+}
+
+void TransformSystem::SetRotation(uint32_t index, const glm::quat& rotation) {
+    rotX[index] = rotation.x;
+    rotY[index] = rotation.y;
+    rotZ[index] = rotation.z;
+    rotW[index] = rotation.w;
+}
+
+void TransformSystem::SetScale(uint32_t index, const glm::vec3& scale) {
+    scaleX[index] = scale.x;
+    scaleY[index] = scale.y;
+    scaleZ[index] = scale.z;
+}
+
+glm::vec3 TransformSystem::GetPosition(uint32_t index) const {
+    return glm::vec3(posX[index], posY[index], posZ[index]);
+}
+
+glm::quat TransformSystem::GetRotation(uint32_t index) const {
+    return glm::quat(rotW[index], rotX[index], rotY[index], rotZ[index]);
+}
+
+glm::vec3 TransformSystem::GetScale(uint32_t index) const {
+    return glm::vec3(scaleX[index], scaleY[index], scaleZ[index]);
+}
+
+void TransformSystem::ComputeMatrices(const glm::mat4& viewProj) {
+    VkJobs::ParallelFor(Size(), BATCH_SIZE, [&](size_t begin, size_t end) {
+        ComputeMatricesRange(viewProj, begin, end);
+    });
+}
+
+void TransformSystem::ComputeMatricesRange(const glm::mat4& viewProj, size_t begin, size_t end) {
+    TransformStreams s{
+        posX.data(), posY.data(), posZ.data(),
+        rotX.data(), rotY.data(), rotZ.data(), rotW.data(),
+        scaleX.data(), scaleY.data(), scaleZ.data()
+    };
+
+    size_t i = begin;
+
+#if defined(VK3D_SIMD)
+    Lanes::Reg vp[16];
+    Broadcast(viewProj, vp);
+
+    for (; i + Lanes::WIDTH <= end; i += Lanes::WIDTH) {
+        BuildBatch(s, i, vp, world.data(), mvp.data());
+    }
+#endif
+
+    for (; i < end; i++) {
+        BuildOne(s, i, viewProj, world[i], mvp[i]);
+    }
+}
+
+void TransformSystem::ComputeLocalRange(size_t begin, size_t end, glm::mat4* out) const {
+    TransformStreams s{
+        posX.data(), posY.data(), posZ.data(),
+        rotX.data(), rotY.data(), rotZ.data(), rotW.data(),
+        scaleX.data(), scaleY.data(), scaleZ.data()
+    };
+
+    size_t i = begin;
+
+#if defined(VK3D_SIMD)
+    for (; i + Lanes::WIDTH <= end; i += Lanes::WIDTH) {
+        BuildLocalBatch(s, i, out);
+    }
+#endif
+
+    for (; i < end; i++) {
+        BuildLocal(s, i, out[i]);
+    }
+}
+
+void TransformSystem::ComputeMatricesScalar(const glm::mat4& viewProj) {
+    for (size_t i = 0; i < Size(); i++) {
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(posX[i], posY[i], posZ[i]));
+        model = model * glm::mat4_cast(glm::quat(rotW[i], rotX[i], rotY[i], rotZ[i]));
+        model = glm::scale(model, glm::vec3(scaleX[i], scaleY[i], scaleZ[i]));
+
+        world[i] = model;
+        mvp[i] = viewProj * model;
+    }
+}
+
+void VkTransform::ComputeMvps(const glm::mat4& viewProj, const std::vector<glm::mat4>& world, const std::vector<uint32_t>& objects, std::vector<glm::mat4>& out) {
+    VkJobs::ParallelFor(objects.size(), TransformSystem::BATCH_SIZE, [&](size_t begin, size_t end) {
+        size_t j = begin;
+
+#if defined(VK3D_SIMD)
+        Lanes::Reg vp[16];
+        Broadcast(viewProj, vp);
+
+        for (; j + Lanes::WIDTH <= end; j += Lanes::WIDTH) {
+            MultiplyBatch(vp, world.data(), objects.data() + j, out.data());
+        }
+#endif
+
+        for (; j < end; j++) {
+            out[objects[j]] = viewProj * world[objects[j]];
+        }
+    });
+}
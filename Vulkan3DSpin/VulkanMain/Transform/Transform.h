@@ -0,0 +1,60 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-object transforms stored as structure-of-arrays so that world and MVP
+// matrices can be built several objects at a time with SSE/AVX2.
+class TransformSystem {
+public:
+    uint32_t Add(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+    void Resize(size_t count);
+    void Clear();
+    size_t Size() const { return posX.size(); }
+
+    void SetPosition(uint32_t index, const glm::vec3& position);
+    void SetRotation(uint32_t index, const glm::quat& rotation);
+    void SetScale(uint32_t index, const glm::vec3& scale);
+
+    glm::vec3 GetPosition(uint32_t index) const;
+    glm::quat GetRotation(uint32_t index) const;
+    glm::vec3 GetScale(uint32_t index) const;
+
+    // Builds world = T * R * S and mvp = viewProj * world for every object,
+    // SIMD batched and split across the job workers.
+    void ComputeMatrices(const glm::mat4& viewProj);
+
+    // Same as ComputeMatrices for [begin, end) on the calling thread only.
+    void ComputeMatricesRange(const glm::mat4& viewProj, size_t begin, size_t end);
+
+    // Writes only the T * R * S matrices of [begin, end) to out[begin, end),
+    // with the same kernel; for callers that compose or keep them elsewhere.
+    void ComputeLocalRange(size_t begin, size_t end, glm::mat4* out) const;
+
+    // Reference path with one glm::translate/mat4_cast/scale per object.
+    void ComputeMatricesScalar(const glm::mat4& viewProj);
+
+    const std::vector<glm::mat4>& World() const { return world; }
+    const std::vector<glm::mat4>& MVP() const { return mvp; }
+
+    // Objects handed to a single job; a multiple of every SIMD width.
+    static constexpr size_t BATCH_SIZE = 256;
+
+private:
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> rotX, rotY, rotZ, rotW;
+    std::vector<float> scaleX, scaleY, scaleZ;
+
+    std::vector<glm::mat4> world;
+    std::vector<glm::mat4> mvp;
+};
+
+namespace VkTransform {
+    // out[i] = viewProj * world[i] for every i in objects, SIMD batched and
+    // split across the job workers. objects must not repeat an index and out
+    // must be at least as large as world; other entries are left untouched.
+    void ComputeMvps(const glm::mat4& viewProj, const std::vector<glm::mat4>& world, const std::vector<uint32_t>& objects, std::vector<glm::mat4>& out);
+}
@@ -91,6 +91,9 @@ SwapChainSupportDetails VkUtils::QuerySwapChainSupport(VkPhysicalDevice device,
 
 bool VkUtils::IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
     QueueFamilyIndices indices = FindQueueFamilies(device, surface);
+    if (surface == VK_NULL_HANDLE) {
+        return indices.isComplete();
+    }
 
     bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
@@ -119,6 +122,21 @@ bool VkUtils::CheckDeviceExtensionSupport(VkPhysicalDevice device) {
     return requiredExtensions.empty();
 }
 
+bool VkUtils::HasDeviceExtension(VkPhysicalDevice device, const char* name) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) {
+        if (strcmp(extension.extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 QueueFamilyIndices VkUtils::FindQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface) {
     QueueFamilyIndices indices;
 
@@ -134,8 +152,14 @@ QueueFamilyIndices VkUtils::FindQueueFamilies(VkPhysicalDevice device, VkSurface
             indices.graphicsFamily = i;
         }
 
+        // Without a surface (benchmarking) the graphics family stands in.
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        if (surface == VK_NULL_HANDLE) {
+            presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        }
+        else {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        }
 
         if (presentSupport) {
             indices.presentFamily = i;
@@ -148,15 +172,26 @@ QueueFamilyIndices VkUtils::FindQueueFamilies(VkPhysicalDevice device, VkSurface
         i++;
     }
 
+    for (uint32_t family = 0; family < queueFamilyCount; family++) {
+        VkQueueFlags flags = queueFamilies[family].queueFlags;
+        if ((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+            indices.computeFamily = family;
+            break;
+        }
+    }
+
     return indices;
 }
 
-std::vector<const char*> VkUtils::GetRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+std::vector<const char*> VkUtils::GetRequiredExtensions(bool windowed) {
+    std::vector<const char*> extensions;
+    if (windowed) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (VkDebug::enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -206,4 +241,41 @@ std::vector<char> VkUtils::ReadFile(const std::string& filename) {
     file.close();
 
     return buffer;
+}
+
+std::optional<uint32_t> VkUtils::FindMemoryType(const VkPhysicalDeviceMemoryProperties& memProperties, uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        bool typeSupported = typeFilter & (1u << i);
+        bool hasProperties = (memProperties.memoryTypes[i].propertyFlags & properties) == properties;
+
+        if (typeSupported && hasProperties) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool VkUtils::GetEnvFlag(const char* name) {
+    const char* value = std::getenv(name);
+    return value != nullptr && value[0] != '\0' && strcmp(value, "0") != 0;
+}
+
+uint32_t VkUtils::GetEnvUint(const char* name, uint32_t defaultValue) {
+    const char* value = std::getenv(name);
+    if (value == nullptr || value[0] == '\0') {
+        return defaultValue;
+    }
+
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(value, &end, 10);
+    if (*end != '\0' || parsed > std::numeric_limits<uint32_t>::max()) {
+        return defaultValue;
+    }
+
+    return static_cast<uint32_t>(parsed);
+}
+
+std::string VkUtils::GetEnvString(const char* name) {
+    const char* value = std::getenv(name);
+    return value != nullptr ? std::string(value) : std::string();
 }
\ No newline at end of file
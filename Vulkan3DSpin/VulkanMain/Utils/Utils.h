@@ -5,9 +5,13 @@ const std::vector<const char*> deviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+const std::string shaderDirectory = "C:/Users/kym10/source/repos/Vulkan3DEngine/Vulkan3DEngine/VulkanMain/Shader/";
+
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // A family with compute but no graphics, for async compute; optional.
+    std::optional<uint32_t> computeFamily;
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -30,8 +34,19 @@ namespace VkUtils {
 
     bool IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface);
     bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+    // Optional extensions, checked one at a time.
+    bool HasDeviceExtension(VkPhysicalDevice device, const char* name);
     bool CheckValidationLayerSupport();
 
-    std::vector<const char*> GetRequiredExtensions();
+    // windowed: include what GLFW needs for a surface.
+    std::vector<const char*> GetRequiredExtensions(bool windowed);
     std::vector<char> ReadFile(const std::string& filename);
+
+    // First type allowed by typeFilter that has every flag in properties.
+    std::optional<uint32_t> FindMemoryType(const VkPhysicalDeviceMemoryProperties& memProperties, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    // Runtime switches read from the environment, e.g. VK3D_GPU_CULLING=1.
+    bool GetEnvFlag(const char* name);
+    uint32_t GetEnvUint(const char* name, uint32_t defaultValue);
+    std::string GetEnvString(const char* name);
 }
\ No newline at end of file
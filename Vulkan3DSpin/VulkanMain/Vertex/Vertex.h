@@ -1,6 +1,7 @@
 #pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
 #include <array> 
-#include <vulkan/vulkan.h> 
 #include <glm/glm.hpp>    
 
 struct Vertex 
@@ -0,0 +1,322 @@
+#include "VulkanMain/VulkanDebug/Log.h"
+#include "VulkanMain/Utils/Utils.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr VkDebugUtilsMessageSeverityFlagsEXT ALL_SEVERITIES =
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    constexpr VkDebugUtilsMessageTypeFlagsEXT ALL_TYPES =
+        VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
+        VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+
+    struct Message {
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+        VkDebugUtilsMessageTypeFlagsEXT type = 0;
+        uint64_t key = 0;
+        std::string id;
+        std::string text;
+    };
+
+    // Bounded multi-producer queue after Dmitry Vyukov's: a cell's sequence
+    // equals the position a producer may fill it at, or that position + 1
+    // once it holds a message. Only the writer thread pops.
+    class MessageQueue {
+    public:
+        static constexpr size_t CAPACITY = 1024;
+
+        MessageQueue() {
+            for (size_t i = 0; i < CAPACITY; i++) {
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        bool Push(Message&& message) {
+            size_t position = tail.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = cells[position % CAPACITY];
+                size_t sequence = cell.sequence.load(std::memory_order_acquire);
+                if (sequence == position) {
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        cell.message = std::move(message);
+                        cell.sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (sequence < position) {
+                    return false;
+                }
+                else {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool Pop(Message& message) {
+            Cell& cell = cells[head % CAPACITY];
+            if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+                return false;
+            }
+            message = std::move(cell.message);
+            cell.sequence.store(head + CAPACITY, std::memory_order_release);
+            head++;
+            return true;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence{ 0 };
+            Message message;
+        };
+
+        Cell cells[CAPACITY];
+        std::atomic<size_t> tail{ 0 };
+        size_t head = 0;
+    };
+
+    // Open addressing on the message key; key 0 marks a free slot. When the
+    // table is full a message is printed every time.
+    constexpr size_t ID_SLOTS = 1024;
+
+    struct IdCount {
+        std::atomic<uint64_t> key{ 0 };
+        std::atomic<uint32_t> count{ 0 };
+    };
+
+    std::atomic<VkDebugUtilsMessageSeverityFlagsEXT> severities{ VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT };
+    std::atomic<VkDebugUtilsMessageTypeFlagsEXT> types{ ALL_TYPES };
+    std::atomic<uint32_t> dropped{ 0 };
+    IdCount idCounts[ID_SLOTS];
+    MessageQueue queue;
+
+    // Name of each key the writer has printed, for the summary.
+    std::vector<std::pair<uint64_t, std::string>> names;
+
+    // The message ID when the layer gives one, else the text.
+    uint64_t MessageKey(const VkDebugUtilsMessengerCallbackDataEXT& data) {
+        const char* text = data.pMessageIdName != nullptr ? data.pMessageIdName : data.pMessage;
+        uint64_t hash = 14695981039346656037ull;
+        for (const char* c = text != nullptr ? text : ""; *c != '\0'; c++) {
+            hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+        }
+        hash ^= static_cast<uint32_t>(data.messageIdNumber);
+        return hash != 0 ? hash : 1;
+    }
+
+    // How many times key has been posted, this one included.
+    uint32_t CountKey(uint64_t key) {
+        size_t slot = static_cast<size_t>(key % ID_SLOTS);
+        for (size_t probe = 0; probe < ID_SLOTS; probe++) {
+            IdCount& entry = idCounts[(slot + probe) % ID_SLOTS];
+            uint64_t current = entry.key.load(std::memory_order_acquire);
+            if (current == 0) {
+                uint64_t expected = 0;
+                if (entry.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel) || expected == key) {
+                    return entry.count.fetch_add(1, std::memory_order_relaxed) + 1;
+                }
+                current = expected;
+            }
+            if (current == key) {
+                return entry.count.fetch_add(1, std::memory_order_relaxed) + 1;
+            }
+        }
+        return 1;
+    }
+
+    const char* SeverityName(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+        switch (severity) {
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT: return "error";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT: return "warning";
+        case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT: return "info";
+        default: return "verbose";
+        }
+    }
+
+    const char* TypeName(VkDebugUtilsMessageTypeFlagsEXT type) {
+        if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT) {
+            return "validation";
+        }
+        if (type & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT) {
+            return "performance";
+        }
+        return "general";
+    }
+
+    VkDebugUtilsMessageSeverityFlagsEXT ParseSeverity(const std::string& level) {
+        VkDebugUtilsMessageSeverityFlagsEXT lowest = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT;
+        if (level == "verbose") {
+            lowest = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
+        }
+        else if (level == "info") {
+            lowest = VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+        }
+        else if (level == "error") {
+            lowest = VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        }
+        else if (!level.empty() && level != "warning") {
+            std::cout << "unknown VK3D_VALIDATION_SEVERITY " << level << ", using warning" << std::endl;
+        }
+        return ALL_SEVERITIES & ~(lowest - 1);
+    }
+
+    VkDebugUtilsMessageTypeFlagsEXT ParseTypes(const std::string& list) {
+        if (list.empty()) {
+            return ALL_TYPES;
+        }
+        VkDebugUtilsMessageTypeFlagsEXT parsed = 0;
+        std::stringstream stream(list);
+        std::string name;
+        while (std::getline(stream, name, ',')) {
+            if (name == "general") {
+                parsed |= VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT;
+            }
+            else if (name == "validation") {
+                parsed |= VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+            }
+            else if (name == "performance") {
+                parsed |= VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+            }
+            else {
+                std::cout << "unknown VK3D_VALIDATION_TYPES entry " << name << std::endl;
+            }
+        }
+        return parsed != 0 ? parsed : ALL_TYPES;
+    }
+
+    void Write(const Message& message) {
+        names.emplace_back(message.key, message.id.empty() ? message.text.substr(0, 80) : message.id);
+
+        // One write per message, so lines from other threads do not interleave.
+        std::string line = "validation layer [";
+        line += SeverityName(message.severity);
+        line += ", ";
+        line += TypeName(message.type);
+        line += "]: ";
+        line += message.text;
+        line += '\n';
+        std::cerr << line;
+    }
+
+    bool Drain() {
+        Message message;
+        bool any = false;
+        while (queue.Pop(message)) {
+            Write(message);
+            any = true;
+        }
+        if (any) {
+            std::cerr.flush();
+        }
+        return any;
+    }
+
+    // Last in the file, so it is destroyed before the queue it drains.
+    struct Writer {
+        std::mutex mutex;
+        std::thread thread;
+        std::atomic<bool> stopping{ false };
+
+        void Loop() {
+            while (!stopping.load(std::memory_order_acquire)) {
+                if (!Drain()) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                }
+            }
+        }
+
+        ~Writer() {
+            VkLog::Stop();
+        }
+    };
+    Writer writer;
+}
+
+void VkLog::Start() {
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    if (writer.thread.joinable()) {
+        return;
+    }
+    severities.store(ParseSeverity(VkUtils::GetEnvString("VK3D_VALIDATION_SEVERITY")), std::memory_order_relaxed);
+    types.store(ParseTypes(VkUtils::GetEnvString("VK3D_VALIDATION_TYPES")), std::memory_order_relaxed);
+    writer.stopping.store(false, std::memory_order_release);
+    writer.thread = std::thread(&Writer::Loop, &writer);
+}
+
+void VkLog::Stop() {
+    std::lock_guard<std::mutex> lock(writer.mutex);
+    if (!writer.thread.joinable()) {
+        return;
+    }
+    writer.stopping.store(true, std::memory_order_release);
+    writer.thread.join();
+    Drain();
+
+    for (const auto& name : names) {
+        for (const IdCount& entry : idCounts) {
+            if (entry.key.load(std::memory_order_relaxed) != name.first) {
+                continue;
+            }
+            uint32_t count = entry.count.load(std::memory_order_relaxed);
+            if (count > 1) {
+                std::cerr << "validation layer: " << name.second << " repeated " << count - 1 << " more times\n";
+            }
+            break;
+        }
+    }
+    uint32_t lost = dropped.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        std::cerr << "validation layer: " << lost << " messages dropped with the queue full\n";
+    }
+    std::cerr.flush();
+    names.clear();
+}
+
+void VkLog::SetFilter(VkDebugUtilsMessageSeverityFlagsEXT newSeverities, VkDebugUtilsMessageTypeFlagsEXT newTypes) {
+    severities.store(newSeverities, std::memory_order_relaxed);
+    types.store(newTypes, std::memory_order_relaxed);
+}
+
+VkDebugUtilsMessageSeverityFlagsEXT VkLog::Severities() {
+    return severities.load(std::memory_order_relaxed);
+}
+
+VkDebugUtilsMessageTypeFlagsEXT VkLog::Types() {
+    return types.load(std::memory_order_relaxed);
+}
+
+void VkLog::Post
+(
+    VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+    VkDebugUtilsMessageTypeFlagsEXT type,
+    const VkDebugUtilsMessengerCallbackDataEXT& data
+)
+{
+    if ((severity & severities.load(std::memory_order_relaxed)) == 0 || (type & types.load(std::memory_order_relaxed)) == 0) {
+        return;
+    }
+
+    uint64_t key = MessageKey(data);
+    if (CountKey(key) > 1) {
+        return;
+    }
+
+    Message message;
+    message.severity = severity;
+    message.type = type;
+    message.key = key;
+    message.id = data.pMessageIdName != nullptr ? data.pMessageIdName : "";
+    message.text = data.pMessage != nullptr ? data.pMessage : "";
+    if (!queue.Push(std::move(message))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
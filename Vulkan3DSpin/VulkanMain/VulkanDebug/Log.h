@@ -0,0 +1,32 @@
+#pragma once
+#include "VulkanMain/Dispatch/Dispatch.h"
+
+// Validation messages without stalling whatever thread the layer calls
+// back on. Post filters by severity and type, counts repeats of a message
+// ID instead of printing them again, and pushes the rest onto a lock-free
+// queue that a writer thread empties into stderr.
+namespace VkLog {
+    // Reads the filter and starts the writer thread; safe to call again.
+    //   VK3D_VALIDATION_SEVERITY  verbose, info, warning or error: that
+    //                             level and above, default warning
+    //   VK3D_VALIDATION_TYPES     comma separated general, validation and
+    //                             performance, default all three
+    void Start();
+    // Writes whatever is still queued, then how often each repeated message
+    // came. Runs at exit too if Cleanup never got there.
+    void Stop();
+
+    // The messenger only hears what the filter allowed when it was created,
+    // so at run time the filter can be narrowed but not widened.
+    void SetFilter(VkDebugUtilsMessageSeverityFlagsEXT severities, VkDebugUtilsMessageTypeFlagsEXT types);
+    VkDebugUtilsMessageSeverityFlagsEXT Severities();
+    VkDebugUtilsMessageTypeFlagsEXT Types();
+
+    // From the debug callback; any thread.
+    void Post
+    (
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+        VkDebugUtilsMessageTypeFlagsEXT type,
+        const VkDebugUtilsMessengerCallbackDataEXT& data
+    );
+}
@@ -1,5 +1,23 @@
 #include "VulkanDebug.h"
 #include "VulkanMain/Main/Main.h"
+#include "VulkanMain/VulkanDebug/Log.h"
+#include "VulkanMain/Utils/Utils.h"
+
+namespace {
+    bool ValidationRequested() {
+        std::string value = VkUtils::GetEnvString("VK3D_VALIDATION");
+        if (value.empty()) {
+#ifdef NDEBUG
+            return false;
+#else
+            return true;
+#endif
+        }
+        return value != "0";
+    }
+}
+
+const bool VkDebug::enableValidationLayers = ValidationRequested();
 
 VkResult VkDebug::CreateDebugUtilsMessengerEXT
 (
@@ -40,15 +58,17 @@ namespace VkDebug {
         void* pUserData
     ) 
     {
-        std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+        VkLog::Post(messageSeverity, messageType, *pCallbackData);
         return VK_FALSE;
     }
 
     void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
         createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+        // Only what the filter lets through, so the layer does not even
+        // format the rest.
+        createInfo.messageSeverity = VkLog::Severities();
+        createInfo.messageType = VkLog::Types();
         createInfo.pfnUserCallback = DebugCallback;
     }
 }
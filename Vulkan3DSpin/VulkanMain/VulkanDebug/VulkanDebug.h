@@ -6,11 +6,9 @@ namespace VkDebug {
     "VK_LAYER_KHRONOS_validation"
     };
 
-#ifdef NDEBUG
-    const bool enableValidationLayers = false;
-#else
-    const bool enableValidationLayers = true;
-#endif
+    // On in debug builds, off with NDEBUG; VK3D_VALIDATION=1 or =0
+    // overrides either. Messages go through VkLog (see Log.h).
+    extern const bool enableValidationLayers;
 
     VkResult CreateDebugUtilsMessengerEXT
     (